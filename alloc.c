@@ -0,0 +1,322 @@
+// alloc.c - asignación de enjambres a blancos (auction con ε-scaling)
+#include "alloc.h"
+#include <math.h>
+#include <stdlib.h>
+#include <float.h>
+#include <limits.h>
+
+void alloc_model_init(alloc_model_t *m, double vx, double b, double a, int w_percent, int rate){
+    m->vx = vx > 0 ? vx : 1.0;
+    m->b = b;
+    m->a = a;
+    m->w = w_percent / 100.0;
+    m->rate = rate > 0 ? rate : 1;
+    m->shortfall_cost = 1000.0;
+    m->stack_cost = 100.0;
+    m->priority_cost = 100.0;
+}
+
+double alloc_expected_survivors(const alloc_model_t *m, const alloc_swarm_t *s){
+    double from = s->x > m->b ? s->x : m->b;
+    double width = m->a - from;
+    if(width <= 0 || m->w <= 0) return s->drones;
+    double cycles = (width / m->vx) / m->rate;
+    return s->drones * pow(1.0 - m->w, cycles);
+}
+
+static double cost_with_survivors(const alloc_model_t *m, const alloc_swarm_t *s, double survivors,
+                                  const alloc_target_t *t, int slot){
+    double c = hypot(t->x - s->x, t->y - s->y) / m->vx;
+    if(survivors < t->required) c += m->shortfall_cost * (t->required - survivors);
+    c += m->stack_cost * (t->load + slot);
+    c -= m->priority_cost * t->priority;
+    return c;
+}
+
+double alloc_cost(const alloc_model_t *m, const alloc_swarm_t *s, const alloc_target_t *t, int slot){
+    return cost_with_survivors(m, s, alloc_expected_survivors(m, s), t, slot);
+}
+// Auction (Bertsekas) con ε-scaling sobre una matriz cuadrada: los swarms son
+// las filas 0..ns-1 y se agregan filas ficticias de costo 0 hasta igualar las columnas
+// (una columna que queda con una fila ficticia es un lugar sin usar).
+// Cada swarm puja solo por sus ALLOC_CANDIDATES blancos más baratos más el que le dio
+// una pasada golosa; esa pasada es una asignación completa dentro de las listas, así
+// que el auction siempre termina y nunca queda peor que ella. El resultado es óptimo
+// salvo n·ε_final si el mejor blanco de cada swarm está en su lista.
+#define ALLOC_EPS_FINAL  1e-3
+#define ALLOC_EPS_FACTOR 6.0
+#define ALLOC_CANDIDATES 16
+
+// Lista de un swarm, de menor a mayor costo (lugar 0)
+typedef struct {
+    int t[ALLOC_CANDIDATES + 1];
+    double c[ALLOC_CANDIDATES + 1];
+    int len;
+} alloc_row_t;
+
+typedef struct {
+    const alloc_model_t *m;
+    const alloc_swarm_t *s;
+    double surv;
+    const alloc_target_t *tg;
+    const int *used;    // lugares tomados por la pasada golosa (NULL = costo del lugar 0)
+    int k;
+} cand_ctx_t;
+
+static double cand_cost(int t, void *p){
+    cand_ctx_t *c = p;
+    if(c->tg[t].destroyed) return INFINITY;
+    int slot = 0;
+    if(c->used){
+        slot = c->used[t];
+        if(slot >= c->k) return INFINITY;
+    }
+    return cost_with_survivors(c->m, c->s, c->surv, &c->tg[t], slot);
+}
+
+// Fuente sin índice: todos los blancos ordenados
+typedef struct { double c; int t; } cand_sort_t;
+
+static int cand_cmp(const void *a, const void *b){
+    double ca = ((const cand_sort_t *)a)->c, cb = ((const cand_sort_t *)b)->c;
+    return ca < cb ? -1 : ca > cb;
+}
+
+typedef struct { int nt; } dense_index_t;
+
+static int dense_nearest(void *index, double x, double y, double (*cost)(int, void *),
+                         double dist_scale, double extra_min, void *cctx,
+                         int want, int *out, double *out_cost){
+    (void)x; (void)y; (void)dist_scale; (void)extra_min;
+    int nt = ((dense_index_t *)index)->nt;
+    cand_sort_t *all = malloc(nt * sizeof(cand_sort_t));
+    if(!all) return -1;
+    int n = 0;
+    for(int t = 0; t < nt; t++){
+        double c = cost(t, cctx);
+        if(isinf(c)) continue;
+        all[n].c = c;
+        all[n++].t = t;
+    }
+    qsort(all, n, sizeof(cand_sort_t), cand_cmp);
+    if(n > want) n = want;
+    for(int k = 0; k < n; k++){ out[k] = all[k].t; out_cost[k] = all[k].c; }
+    free(all);
+    return n;
+}
+
+// Swarms de igual posición y drones tienen los mismos costos
+typedef struct { double x, y; int drones, i; } row_key_t;
+
+static int row_key_cmp(const void *a, const void *b){
+    const row_key_t *p = a, *q = b;
+    if(p->x != q->x) return p->x < q->x ? -1 : 1;
+    if(p->y != q->y) return p->y < q->y ? -1 : 1;
+    return p->drones - q->drones;
+}
+
+static void cand_sift_down(int *t, double *c, int n, int p){
+    int ti = t[p];
+    double ci = c[p];
+    for(;;){
+        int ch = 2 * p + 1;
+        if(ch >= n) break;
+        if(ch + 1 < n && c[ch + 1] < c[ch]) ch++;
+        if(c[ch] >= ci) break;
+        t[p] = t[ch];
+        c[p] = c[ch];
+        p = ch;
+    }
+    t[p] = ti;
+    c[p] = ci;
+}
+
+// Montículo de mínimos de precios: las filas ficticias (costo 0 en todas las columnas)
+// pujan por la más barata y la segunda más barata sin recorrer las n columnas
+static void price_sift_down(int *hp, int *hpos, const double *price, int n, int p){
+    int j = hp[p];
+    for(;;){
+        int c = 2 * p + 1;
+        if(c >= n) break;
+        if(c + 1 < n && price[hp[c + 1]] < price[hp[c]]) c++;
+        if(price[hp[c]] >= price[j]) break;
+        hp[p] = hp[c];
+        hpos[hp[p]] = p;
+        p = c;
+    }
+    hp[p] = j;
+    hpos[j] = p;
+}
+
+int alloc_solve(const alloc_model_t *m, const alloc_swarm_t *sw, int ns,
+                const alloc_target_t *tg, int nt, alloc_nearest_fn nearest, void *index, int *out){
+    int alive = 0, min_required = INT_MAX, max_priority = 0;
+    for(int t = 0; t < nt; t++) {
+        if(tg[t].destroyed) continue;
+        alive++;
+        if(tg[t].required < min_required) min_required = tg[t].required;
+        if(tg[t].priority > max_priority) max_priority = tg[t].priority;
+    }
+    for(int i = 0; i < ns; i++) out[i] = -1;
+    if(ns == 0 || alive == 0) return 0;
+
+    dense_index_t dense = { nt };
+    if(!nearest){ nearest = dense_nearest; index = &dense; }
+
+    // k lugares por blanco vivo, el lugar j-ésimo con costo de apilado creciente
+    int k = (ns + alive - 1) / alive;
+    double *surv = malloc(ns * sizeof(double));
+    int *used = calloc(nt, sizeof(int));
+    int *col_of = malloc(nt * sizeof(int));     // primera columna de cada blanco (-1 = no entra)
+    alloc_row_t *rows = malloc(ns * sizeof(alloc_row_t));
+    row_key_t *keys = malloc(ns * sizeof(row_key_t));
+    int *gt = malloc(ns * sizeof(int));
+    double *gc = malloc(ns * sizeof(double));
+    int *col_target = NULL, *owner = NULL, *assigned = NULL, *queue = NULL, *hp = NULL, *hpos = NULL;
+    double *price = NULL;
+    int rc = -1;
+    if(!surv || !used || !col_of || !rows || !keys || !gt || !gc) goto done;
+
+    // pasada golosa (el lugar libre más barato de cada swarm) y listas de candidatos.
+    // Los swarms iguales (p.ej. todos en el punto de ensamble) se resuelven juntos con una
+    // sola consulta de tantos blancos como swarms del grupo. Lo que no es vuelo cuesta al
+    // menos el faltante contra el blanco menos exigente menos la mayor prioridad, cota
+    // que usa el índice para cortar la búsqueda.
+    for(int i = 0; i < ns; i++) {
+        keys[i].x = sw[i].x;
+        keys[i].y = sw[i].y;
+        keys[i].drones = sw[i].drones;
+        keys[i].i = i;
+    }
+    qsort(keys, ns, sizeof(row_key_t), row_key_cmp);
+    for(int a = 0, b; a < ns; a = b) {
+        for(b = a + 1; b < ns && row_key_cmp(&keys[a], &keys[b]) == 0; b++);
+        const alloc_swarm_t *s = &sw[keys[a].i];
+        double su = alloc_expected_survivors(m, s);
+        double extra_min = -m->priority_cost * max_priority;
+        if(su < min_required) extra_min += m->shortfall_cost * (min_required - su);
+        cand_ctx_t cc = { m, s, su, tg, used, k };
+        int ng = nearest(index, s->x, s->y, cand_cost, 1.0 / m->vx, extra_min, &cc, b - a, gt, gc);
+        alloc_row_t proto;
+        cc.used = NULL;
+        proto.len = nearest(index, s->x, s->y, cand_cost, 1.0 / m->vx, extra_min, &cc,
+                            ALLOC_CANDIDATES, proto.t, proto.c);
+        if(ng <= 0 || proto.len < 0) goto done;
+
+        // gt/gc quedan de menor a mayor, que ya es un montículo de mínimos: cada swarm
+        // toma la raíz y ese blanco pasa a costar su lugar siguiente (o sale si se llenó)
+        for(int p = a; p < b; p++) {
+            if(ng == 0) goto done;
+            int i = keys[p].i, g = gt[0];
+            if(++used[g] < k) gc[0] += m->stack_cost;
+            else { ng--; gt[0] = gt[ng]; gc[0] = gc[ng]; }
+            cand_sift_down(gt, gc, ng, 0);
+
+            alloc_row_t *r = &rows[i];
+            *r = proto;
+            surv[i] = su;
+            int have = 0;
+            for(int q = 0; q < r->len; q++) if(r->t[q] == g) have = 1;
+            if(!have) {     // fuera de los más baratos: su costo no es menor que el último
+                r->t[r->len] = g;
+                r->c[r->len++] = cost_with_survivors(m, s, su, &tg[g], 0);
+            }
+        }
+    }
+
+    // columnas: los blancos de alguna lista
+    int n = 0;
+    for(int t = 0; t < nt; t++) col_of[t] = -1;
+    for(int i = 0; i < ns; i++)
+        for(int p = 0; p < rows[i].len; p++) {
+            int t = rows[i].t[p];
+            if(col_of[t] < 0) { col_of[t] = n; n += k; }
+        }
+    col_target = malloc(n * sizeof(int));
+    price = calloc(n, sizeof(double));
+    owner = malloc(n * sizeof(int));    // fila dueña de cada columna
+    assigned = malloc(n * sizeof(int)); // columna de cada fila
+    queue = malloc(n * sizeof(int));
+    hp = malloc(n * sizeof(int));
+    hpos = malloc(n * sizeof(int));
+    if(!col_target || !price || !owner || !assigned || !queue || !hp || !hpos) goto done;
+    for(int t = 0; t < nt; t++)
+        if(col_of[t] >= 0)
+            for(int slot = 0; slot < k; slot++) col_target[col_of[t] + slot] = t;
+    for(int j = 0; j < n; j++) { hp[j] = j; hpos[j] = j; }
+
+    // ε inicial según la mayor diferencia de costos dentro de una lista (más el apilado):
+    // un término constante por fila (p.ej. el faltante con blancos iguales) no cambia la asignación
+    double spread = 0;
+    for(int i = 0; i < ns; i++) {
+        double sp = rows[i].c[rows[i].len - 1] - rows[i].c[0] + m->stack_cost * (k - 1);
+        if(sp > spread) spread = sp;
+    }
+
+    double eps = spread / ALLOC_EPS_FACTOR;
+    if(eps < ALLOC_EPS_FINAL) eps = ALLOC_EPS_FINAL;
+    for(;;) {
+        for(int j = 0; j < n; j++) owner[j] = -1;
+        for(int i = 0; i < n; i++) { assigned[i] = -1; queue[i] = i; }
+        int head = 0, pending = n;
+
+        while(pending > 0) {
+            int i = queue[head];
+            head = (head + 1) % n;
+            pending--;
+
+            // mejor y segundo mejor valor (beneficio = -costo - precio)
+            double best = -DBL_MAX, second = -DBL_MAX;
+            int bj = -1;
+            if(i < ns) {
+                // ningún precio baja de pmin: un lugar de costo c vale a lo sumo -c - pmin,
+                // así que la lista se recorre hasta que eso no supera al segundo mejor
+                const alloc_row_t *r = &rows[i];
+                double pmin = price[hp[0]];
+                for(int p = 0; p < r->len; p++) {
+                    int j0 = col_of[r->t[p]];
+                    for(int slot = 0; slot < k; slot++) {
+                        double c = r->c[p] + m->stack_cost * slot;
+                        if(-c - pmin <= second) break;
+                        double val = -c - price[j0 + slot];
+                        if(val > best) { second = best; best = val; bj = j0 + slot; }
+                        else if(val > second) second = val;
+                    }
+                    if(-r->c[p] - pmin <= second) break;
+                }
+            } else {
+                bj = hp[0];
+                best = -price[bj];
+                if(n > 1) {
+                    int c = (n > 2 && price[hp[2]] < price[hp[1]]) ? hp[2] : hp[1];
+                    second = -price[c];
+                }
+            }
+            if(second == -DBL_MAX) second = best;
+
+            price[bj] += best - second + eps;
+            price_sift_down(hp, hpos, price, n, hpos[bj]);
+            int prev = owner[bj];
+            owner[bj] = i;
+            assigned[i] = bj;
+            if(prev >= 0) {
+                assigned[prev] = -1;
+                queue[(head + pending) % n] = prev;
+                pending++;
+            }
+        }
+
+        if(eps <= ALLOC_EPS_FINAL) break;
+        eps /= ALLOC_EPS_FACTOR;
+        if(eps < ALLOC_EPS_FINAL) eps = ALLOC_EPS_FINAL;
+    }
+
+    for(int i = 0; i < ns; i++)
+        if(assigned[i] >= 0) out[i] = col_target[assigned[i]];
+    rc = 0;
+done:
+    free(surv); free(used); free(col_of); free(rows); free(keys); free(gt); free(gc);
+    free(col_target); free(price);
+    free(owner); free(assigned); free(queue); free(hp); free(hpos);
+    return rc;
+}
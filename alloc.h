@@ -0,0 +1,60 @@
+// alloc.h - asignación de enjambres a blancos por modelo de costo
+#ifndef ALLOC_H
+#define ALLOC_H
+
+// Modelo de costo (todos en segundos-equivalentes):
+//   vuelo     = distancia(swarm, blanco) / vx
+//   faltante  = shortfall_cost * max(0, required - sobrevivientes esperados)
+//   apilado   = stack_cost * (swarms que ya van al mismo blanco)
+//   prioridad = -priority_cost * prioridad del blanco
+// Sobrevivientes esperados: cada ciclo de artillería (rate s) derriba con
+// probabilidad w a cada dron dentro de [b, a); se cruza a velocidad vx.
+typedef struct {
+    double vx;
+    double b, a;
+    double w;               // probabilidad de derribo por ciclo (0..1)
+    double rate;            // segundos entre ciclos de disparo
+    double shortfall_cost;  // por dron que se espera que falte
+    double stack_cost;      // por swarm extra sobre el mismo blanco
+    double priority_cost;   // bonificación por punto de prioridad
+} alloc_model_t;
+
+typedef struct {
+    double x, y;    // posición actual (o de ensamble)
+    int drones;     // drones vivos
+} alloc_swarm_t;
+
+typedef struct {
+    double x, y;
+    int required;   // drones necesarios para destruirlo
+    int load;       // swarms ya comprometidos (en vuelo) hacia este blanco
+    int destroyed;  // no se asigna si != 0
+    int priority;
+} alloc_target_t;
+
+void alloc_model_init(alloc_model_t *m, double vx, double b, double a, int w_percent, int rate);
+
+// Sobrevivientes esperados al salir de la zona de defensa
+double alloc_expected_survivors(const alloc_model_t *m, const alloc_swarm_t *s);
+
+// Costo de enviar s a t como el (slot+1)-ésimo swarm asignado en esta resolución
+double alloc_cost(const alloc_model_t *m, const alloc_swarm_t *s, const alloc_target_t *t, int slot);
+
+// Índice espacial de blancos para alloc_solve, con la firma de targets_nearest: deja en
+// out los want blancos de menor cost(t, cctx) (INFINITY = excluido), de menor a mayor con
+// su costo en out_cost, sabiendo que cost >= distancia * dist_scale + extra_min.
+// Devuelve cuántos dejó o -1 si falla.
+typedef int (*alloc_nearest_fn)(void *index, double x, double y, double (*cost)(int t, void *cctx),
+                                double dist_scale, double extra_min, void *cctx,
+                                int want, int *out, double *out_cost);
+
+// Asignación de costo mínimo (auction con ε-scaling); cada blanco vivo ofrece
+// k = ceil(ns / vivos) lugares. Cada swarm puja solo por sus blancos más baratos (los
+// pide a nearest; NULL recorre todos) más el que le toca en una pasada golosa, así
+// que cada puja mira unas pocas columnas y no las de todos los blancos.
+// out[i] = índice del blanco o -1 si no hay blancos.
+// Devuelve 0 o -1 si falla la memoria.
+int alloc_solve(const alloc_model_t *m, const alloc_swarm_t *sw, int ns,
+                const alloc_target_t *tg, int nt, alloc_nearest_fn nearest, void *index, int *out);
+
+#endif
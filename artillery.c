@@ -1,65 +1,489 @@
 // artillery.c - Sistema de defensa anti-drone
+// Varias baterías (posición, alcance, cadencia, munición) configuradas con líneas
+// BATTERY=... en params.txt; sin ninguna se usa la banda clásica B <= x <= A.
+// Cada batería dispara en paralelo (hilos de trabajo) sobre su propia cola de
+// amenazas (heap indexado) que se actualiza con cada POS; dispara a lo sumo
+// SHOTS_PER_CYCLE veces por ciclo, a las amenazas más urgentes según ENGAGE_POLICY.
+// Los tracks sin POS por TRACK_TIMEOUT segundos vencen en una rueda de timers y
+// su slot vuelve a una lista libre.
 #include "common.h"
+#include "log.h"
+#include "journal.h"
+#include "reload.h"
+#include "checkpoint.h"
 #include <semaphore.h>
 #include <math.h>
 
-#define MAX_DRONES_TRACKED 1000
 
 typedef struct {
     int global_id;
     int swarm_id;
     double x, y;
+    double vx;              // velocidad en x estimada con los dos últimos POS
+    double t_pos;           // reloj monotónico del último POS
     int in_defense_zone;
     int active;
-    time_t last_update;
+    int shot_down;          // lápida: derribado, sigue en el índice hasta vencer en la rueda
+    int bucket;             // celda de la grilla (-1 = sin posición todavía)
+    long expire_tick;       // tick de vencimiento en la rueda (-1 = fuera de la rueda)
+    int wheel_prev, wheel_next;
+    int hash_next;          // cadena del índice id -> slot (o siguiente libre)
+    unsigned status_version; // cambia al empezar/dejar de rastrearlo o cruzar la zona
 } tracked_drone_t;
 
+typedef struct { int slot; double key; } threat_t;
+
+typedef struct {
+    int id;
+    double x, y, range;     // range < 0: banda clásica B..A (sin límite en y)
+    double rate;            // segundos entre ciclos de disparo
+    int ammo;               // disparos restantes, -1 = ilimitada
+    double pk;              // probabilidad de derribo a distancia 0 (0..1)
+    int pk_from_w;          // pk tomado de W: sigue los cambios de W en caliente
+    int shots_per_cycle;
+    int *buckets;           // celdas de la grilla que cubre (sin repetidos)
+    int nbuckets;
+    // amenazas a su alcance: min-heap por key; heap_pos[slot] = índice o -1
+    threat_t *heap;
+    int heap_len;
+    int *heap_pos;
+    sem_t heap_lock;
+    double next_fire;       // reloj monotónico
+    long shots, hits;
+    int out_of_ammo_logged;
+} battery_t;
+
 // Parámetros del sistema
 int BASE_PORT = 40000;
 int W = 30;  // Probabilidad de derribo (%)
 int NUM_TARGETS = 2;
 int ARTILLERY_RATE = 2; // Segundos entre disparos
+int MAX_TRACKED = 1000; // capacidad del registro de drones rastreados
+int TRACK_TIMEOUT = 10; // segundos sin POS hasta descartar un track
+int ASSEMBLY_SIZE = 5;
+int NUM_SWARMS = 2;
+int ARTILLERY_WORKERS = 4;
+double GRID_CELL = 10.0; // lado de celda de la grilla de drones
+int SHOTS_PER_CYCLE = 3;  // disparos por batería y ciclo (si BATTERY no lo indica)
+double VX = 5.0;          // velocidad nominal de los drones (si no hay estimación)
+double C = 100.0;         // línea de los blancos
+
+// Orden de la cola de amenazas (menor key = se dispara primero)
+enum { POLICY_EXIT, POLICY_TARGET, POLICY_PK };
+int ENGAGE_POLICY = POLICY_EXIT;
+static const char *policy_names[] = { "EXIT", "TARGET", "PK" };
 
 // Zonas de defensa
 double B = 20.0;   // Inicio zona de defensa
 double A = 50.0;   // Fin zona de defensa
 
+#define GRID_BUCKETS 4096   // potencia de 2
+#define LOCK_STRIPES 64
+#define MAX_BATTERIES 1024
+
 // Estado del sistema
-tracked_drone_t drones[MAX_DRONES_TRACKED];
-int num_tracked = 0;
+tracked_drone_t *drones = NULL;   // MAX_TRACKED entradas, reservadas en artillery_setup
+volatile int num_tracked = 0;     // tracks vivos
+int num_in_defense = 0;           // tracks dentro de alguna zona (atómico)
+volatile sig_atomic_t full_status_requested = 0;   // SIGUSR1: volcado completo
+#define STATUS_MAX_DIFF 50        // drones cambiados que se listan por reporte
+int slots_used = 0;               // slots alguna vez usados (los libres se reutilizan)
+int free_slot = -1;               // lista libre enlazada por hash_next
+int *id_hash = NULL;              // id -> primer slot de la cadena
+int id_hash_mask = 0;
+
+// Rueda de timers de vencimiento: un bucket por tick de 1 s; como tiene más
+// buckets que TRACK_TIMEOUT + 1, todo lo que hay en el bucket que vence está vencido
+int *wheel_head = NULL;
+int wheel_mask = 0;
+long wheel_tick = 0;              // último tick procesado
 int artillery_sock;
-int center_port;
-sem_t sem_tracking;
+
+battery_t batteries[MAX_BATTERIES];
+int num_batteries = 0;
+int legacy_band = 0;              // 1 si se usa la banda B..A por falta de baterías
+unsigned int *worker_seeds = NULL; // estado de rand_r de cada hilo de trabajo (va en la instantánea)
+char checkpoint_dir[200] = "";    // CHECKPOINT_DIR, vacío si no hay instantáneas
+
+// cobertura: baterías (no banda) que alcanzan cada celda, en formato CSR
+int *cov_start = NULL, *cov_items = NULL;
+
+// Orden de locks: drone -> heap de una batería (nunca dos heaps a la vez),
+// drone -> registro, drone -> rueda
+sem_t sem_registry;               // índice id -> slot, lista libre y num_tracked
+sem_t sem_wheel;
+sem_t drone_locks[LOCK_STRIPES];  // estado de cada drone (slot % LOCK_STRIPES)
+
+static inline sem_t *drone_lock(int slot){ return &drone_locks[slot % LOCK_STRIPES]; }
+
+static inline int bucket_of_cell(long cx, long cy){
+    unsigned long h = (unsigned long)cx * 73856093ul ^ (unsigned long)cy * 19349663ul;
+    return (int)(h & (GRID_BUCKETS - 1));
+}
+
+static inline int bucket_of(double x, double y){
+    return bucket_of_cell((long)floor(x / GRID_CELL), (long)floor(y / GRID_CELL));
+}
+
+static double now_mono(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// BATTERY=x,y,alcance,cadencia[,munición[,pk%[,disparos por ciclo]]]
+static void parse_battery(const char *val){
+    if(num_batteries >= MAX_BATTERIES) {
+        LOGW("Máximo de %d baterías alcanzado, se ignora BATTERY=%s", MAX_BATTERIES, val);
+        return;
+    }
+    battery_t *b = &batteries[num_batteries];
+    memset(b, 0, sizeof(*b));
+    int ammo = -1, shots = 0;
+    double pk = -1;
+    if(sscanf(val, "%lf , %lf , %lf , %lf , %d , %lf , %d", &b->x, &b->y, &b->range, &b->rate,
+              &ammo, &pk, &shots) < 4 ||
+       b->range <= 0 || b->rate <= 0) {
+        LOGW("BATTERY inválida: %s", val);
+        return;
+    }
+    b->id = num_batteries;
+    b->ammo = ammo;
+    b->pk = pk;   // < 0: se completa con W al terminar de leer
+    b->shots_per_cycle = shots;  // 0: SHOTS_PER_CYCLE
+    num_batteries++;
+}
 
 void load_params(const char *path) {
     FILE *f = fopen(path, "r");
-    if(!f) { 
-        printf("[ARTILLERY] No se pudo abrir %s, usando valores por defecto\n", path);
-        return; 
+    if(!f) {
+        LOGW("No se pudo abrir %s, usando valores por defecto", path);
+        return;
     }
-    
+
     char line[200];
     while(fgets(line, sizeof(line), f)) {
         if(line[0] == '#' || strlen(line) < 3) continue;
-        
+
         char key[80];
         int val;
         double dval;
-        
-        if(sscanf(line, "%[^=]=%d", key, &val) == 2) {
+        char sval[120];
+
+        if(sscanf(line, "%79[^=]=%119[^\n#]", key, sval) == 2 && strcmp(key, "BATTERY") == 0) {
+            parse_battery(sval);
+        }
+        else if(sscanf(line, "%79[^=]=%119s", key, sval) == 2 && strcmp(key, "ENGAGE_POLICY") == 0) {
+            int p;
+            for(p = 0; p < 3 && strcmp(sval, policy_names[p]) != 0; p++);
+            if(p < 3) ENGAGE_POLICY = p;
+            else LOGW("ENGAGE_POLICY desconocida: %s", sval);
+        }
+        else if(sscanf(line, "%[^=]=%d", key, &val) == 2) {
             if(strcmp(key, "BASE_PORT") == 0) BASE_PORT = val;
             else if(strcmp(key, "W") == 0) W = val;
             else if(strcmp(key, "NUM_TARGETS") == 0) NUM_TARGETS = val;
             else if(strcmp(key, "ARTILLERY_RATE") == 0) ARTILLERY_RATE = val;
+            else if(strcmp(key, "MAX_TRACKED") == 0) MAX_TRACKED = val;
+            else if(strcmp(key, "TRACK_TIMEOUT") == 0 && val > 0) TRACK_TIMEOUT = val;
+            else if(strcmp(key, "ASSEMBLY_SIZE") == 0) ASSEMBLY_SIZE = val;
+            else if(strcmp(key, "NUM_SWARMS") == 0) NUM_SWARMS = val;
+            else if(strcmp(key, "ARTILLERY_WORKERS") == 0) ARTILLERY_WORKERS = val;
+            else if(strcmp(key, "SHOTS_PER_CYCLE") == 0 && val > 0) SHOTS_PER_CYCLE = val;
         }
-        else if(sscanf(line, "%[^=]=%lf", key, &dval) == 2) {
+        if(sscanf(line, "%[^=]=%lf", key, &dval) == 2) {
             if(strcmp(key, "B") == 0) B = dval;
             else if(strcmp(key, "A") == 0) A = dval;
+            else if(strcmp(key, "GRID_CELL") == 0 && dval > 0) GRID_CELL = dval;
+            else if(strcmp(key, "VX") == 0 && dval > 0) VX = dval;
+            else if(strcmp(key, "C") == 0) C = dval;
         }
     }
     fclose(f);
-    
-    printf("[ARTILLERY] Parámetros cargados: W=%d%%, B=%.1f, A=%.1f\n", W, B, A);
+
+    LOGI("Parámetros cargados: W=%d%%, B=%.1f, A=%.1f, baterías=%d, política=%s",
+         W, B, A, num_batteries, policy_names[ENGAGE_POLICY]);
+}
+
+// Celdas cubiertas por una batería circular (sin repetidos por colisiones del hash)
+static void battery_build_buckets(battery_t *b, char *seen){
+    long x0 = (long)floor((b->x - b->range) / GRID_CELL), x1 = (long)floor((b->x + b->range) / GRID_CELL);
+    long y0 = (long)floor((b->y - b->range) / GRID_CELL), y1 = (long)floor((b->y + b->range) / GRID_CELL);
+    memset(seen, 0, GRID_BUCKETS);
+    int cap = 16;
+    b->buckets = malloc(cap * sizeof(int));
+    b->nbuckets = 0;
+    for(long cy = y0; cy <= y1 && b->nbuckets < GRID_BUCKETS; cy++) {
+        for(long cx = x0; cx <= x1 && b->nbuckets < GRID_BUCKETS; cx++) {
+            int k = bucket_of_cell(cx, cy);
+            if(seen[k]) continue;
+            seen[k] = 1;
+            if(b->nbuckets == cap) {
+                cap *= 2;
+                b->buckets = realloc(b->buckets, cap * sizeof(int));
+            }
+            b->buckets[b->nbuckets++] = k;
+        }
+    }
+}
+
+// Reserva el registro y arma baterías, grilla y tabla de cobertura
+int artillery_setup(void) {
+    drones = calloc(MAX_TRACKED, sizeof(tracked_drone_t));
+    int hsize = 1, wsize = 1;
+    while(hsize < 2 * MAX_TRACKED) hsize <<= 1;
+    while(wsize <= TRACK_TIMEOUT + 1) wsize <<= 1;
+    id_hash = malloc(hsize * sizeof(int));
+    wheel_head = malloc(wsize * sizeof(int));
+    if(!drones || !id_hash || !wheel_head) return -1;
+    for(int i = 0; i < hsize; i++) id_hash[i] = -1;
+    for(int i = 0; i < wsize; i++) wheel_head[i] = -1;
+    id_hash_mask = hsize - 1;
+    wheel_mask = wsize - 1;
+    wheel_tick = (long)now_mono();
+    num_tracked = 0;
+    num_in_defense = 0;
+    slots_used = 0;
+    free_slot = -1;
+    worker_seeds = malloc(ARTILLERY_WORKERS * sizeof(unsigned int));
+    if(!worker_seeds) return -1;
+    for(int w = 0; w < ARTILLERY_WORKERS; w++)
+        worker_seeds[w] = (unsigned int)time(NULL) ^ (unsigned int)(w * 2654435761u);
+    sem_init(&sem_registry, 0, 1);
+    sem_init(&sem_wheel, 0, 1);
+    for(int i = 0; i < LOCK_STRIPES; i++) {
+        sem_init(&drone_locks[i], 0, 1);
+    }
+
+    if(num_batteries == 0) {
+        // banda clásica: una batería sin posición que cubre B <= x <= A
+        legacy_band = 1;
+        battery_t *b = &batteries[num_batteries++];
+        memset(b, 0, sizeof(*b));
+        b->range = -1;
+        b->rate = ARTILLERY_RATE > 0 ? ARTILLERY_RATE : 1;
+        b->ammo = -1;
+        b->pk = W / 100.0;
+        b->pk_from_w = 1;
+    }
+
+    char *seen = malloc(GRID_BUCKETS);
+    int *count = calloc(GRID_BUCKETS + 1, sizeof(int));
+    if(!seen || !count) { free(seen); free(count); return -1; }
+    double t0 = now_mono();
+    for(int i = 0; i < num_batteries; i++) {
+        battery_t *b = &batteries[i];
+        if(b->pk < 0) { b->pk = W / 100.0; b->pk_from_w = 1; }
+        else if(b->pk > 1) b->pk /= 100.0;
+        if(b->shots_per_cycle <= 0) b->shots_per_cycle = SHOTS_PER_CYCLE;
+        b->next_fire = t0 + b->rate;
+        b->heap = malloc(MAX_TRACKED * sizeof(threat_t));
+        b->heap_pos = malloc(MAX_TRACKED * sizeof(int));
+        if(!b->heap || !b->heap_pos) { free(seen); free(count); return -1; }
+        for(int k = 0; k < MAX_TRACKED; k++) b->heap_pos[k] = -1;
+        b->heap_len = 0;
+        sem_init(&b->heap_lock, 0, 1);
+        if(b->range < 0) continue;
+        battery_build_buckets(b, seen);
+        for(int k = 0; k < b->nbuckets; k++) count[b->buckets[k] + 1]++;
+    }
+    for(int k = 0; k < GRID_BUCKETS; k++) count[k + 1] += count[k];
+    cov_start = malloc((GRID_BUCKETS + 1) * sizeof(int));
+    cov_items = malloc((count[GRID_BUCKETS] + 1) * sizeof(int));
+    memcpy(cov_start, count, (GRID_BUCKETS + 1) * sizeof(int));
+    for(int i = 0; i < num_batteries; i++)
+        for(int k = 0; k < batteries[i].nbuckets; k++)
+            cov_items[count[batteries[i].buckets[k]]++] = i;
+    free(seen);
+    free(count);
+    return 0;
+}
+
+// ¿Algún arma alcanza el punto? (banda clásica o círculo de alguna batería)
+static int in_coverage(double x, double y) {
+    if(legacy_band && x >= B && x <= A) return 1;
+    int k = bucket_of(x, y);
+    for(int c = cov_start[k]; c < cov_start[k + 1]; c++) {
+        const battery_t *b = &batteries[cov_items[c]];
+        if(hypot(x - b->x, y - b->y) <= b->range) return 1;
+    }
+    return 0;
+}
+
+// Probabilidad de derribo: constante en la banda, decrece linealmente hasta el alcance
+static double hit_probability(const battery_t *b, double x, double y) {
+    if(b->range < 0) return (x >= B && x <= A) ? b->pk : 0.0;
+    double d = hypot(x - b->x, y - b->y);
+    if(d > b->range) return 0.0;
+    return b->pk * (1.0 - d / b->range);
+}
+
+// Urgencia de una amenaza para la batería b (menor = primero):
+//   EXIT   tiempo hasta salir del alcance de b avanzando en x
+//   TARGET tiempo hasta la línea de blancos x = C
+//   PK     probabilidad de derribo (las más seguras primero)
+static double threat_key(const battery_t *b, const tracked_drone_t *d) {
+    double v = d->vx > 0.1 ? d->vx : live_params()->VX;
+    switch(ENGAGE_POLICY) {
+    case POLICY_TARGET:
+        return (C - d->x) / v;
+    case POLICY_PK:
+        return -hit_probability(b, d->x, d->y);
+    default:
+        if(b->range < 0) return (A - d->x) / v;
+        double dy = d->y - b->y;
+        double half = sqrt(fmax(0.0, b->range * b->range - dy * dy));
+        return (b->x + half - d->x) / v;
+    }
+}
+
+// ---------- heap indexado por slot (con heap_lock tomado) ----------
+static void heap_swap(battery_t *b, int i, int j) {
+    threat_t t = b->heap[i];
+    b->heap[i] = b->heap[j];
+    b->heap[j] = t;
+    b->heap_pos[b->heap[i].slot] = i;
+    b->heap_pos[b->heap[j].slot] = j;
+}
+
+static void heap_sift(battery_t *b, int i) {
+    while(i > 0 && b->heap[(i - 1) / 2].key > b->heap[i].key) {
+        heap_swap(b, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+    for(;;) {
+        int l = 2 * i + 1, r = l + 1, m = i;
+        if(l < b->heap_len && b->heap[l].key < b->heap[m].key) m = l;
+        if(r < b->heap_len && b->heap[r].key < b->heap[m].key) m = r;
+        if(m == i) break;
+        heap_swap(b, i, m);
+        i = m;
+    }
+}
+
+static void heap_upsert(battery_t *b, int slot, double key) {
+    int i = b->heap_pos[slot];
+    if(i < 0) {
+        i = b->heap_len++;
+        b->heap_pos[slot] = i;
+    }
+    b->heap[i].slot = slot;
+    b->heap[i].key = key;
+    heap_sift(b, i);
+}
+
+static void heap_remove(battery_t *b, int slot) {
+    int i = b->heap_pos[slot];
+    if(i < 0) return;
+    b->heap_pos[slot] = -1;
+    if(--b->heap_len == i) return;
+    b->heap[i] = b->heap[b->heap_len];
+    b->heap_pos[b->heap[i].slot] = i;
+    heap_sift(b, i);
+}
+
+// Inserta, reordena o saca el drone de la cola de b según su posición actual
+// (con el lock del drone tomado)
+static void threat_refresh(battery_t *b, int slot) {
+    tracked_drone_t *d = &drones[slot];
+    int in_range = d->active && hit_probability(b, d->x, d->y) > 0;
+    sem_wait(&b->heap_lock);
+    if(in_range) heap_upsert(b, slot, threat_key(b, d));
+    else heap_remove(b, slot);
+    sem_post(&b->heap_lock);
+}
+
+// Actualiza las colas de las baterías que cubren la celda anterior y la nueva
+// (un drone solo puede estar en colas de baterías que cubren su celda)
+static void threats_moved(int slot, int old_bucket) {
+    int nb = drones[slot].bucket;
+    if(legacy_band) threat_refresh(&batteries[0], slot);
+    if(old_bucket >= 0 && old_bucket != nb)
+        for(int c = cov_start[old_bucket]; c < cov_start[old_bucket + 1]; c++)
+            threat_refresh(&batteries[cov_items[c]], slot);
+    if(nb >= 0)
+        for(int c = cov_start[nb]; c < cov_start[nb + 1]; c++)
+            threat_refresh(&batteries[cov_items[c]], slot);
+}
+
+// ---------- rueda de timers ----------
+static void wheel_unlink(int slot) {
+    tracked_drone_t *d = &drones[slot];
+    if(d->expire_tick < 0) return;
+    if(d->wheel_prev >= 0) drones[d->wheel_prev].wheel_next = d->wheel_next;
+    else wheel_head[d->expire_tick & wheel_mask] = d->wheel_next;
+    if(d->wheel_next >= 0) drones[d->wheel_next].wheel_prev = d->wheel_prev;
+    d->expire_tick = -1;
+}
+
+// Reprograma el vencimiento a TRACK_TIMEOUT desde ahora (con el lock del drone tomado)
+static void wheel_schedule(int slot) {
+    tracked_drone_t *d = &drones[slot];
+    sem_wait(&sem_wheel);
+    long tick = (wheel_tick > (long)now_mono() ? wheel_tick : (long)now_mono()) + TRACK_TIMEOUT + 1;
+    if(d->expire_tick != tick) {
+        wheel_unlink(slot);
+        int *head = &wheel_head[tick & wheel_mask];
+        d->expire_tick = tick;
+        d->wheel_prev = -1;
+        d->wheel_next = *head;
+        if(*head >= 0) drones[*head].wheel_prev = slot;
+        *head = slot;
+    }
+    sem_post(&sem_wheel);
+}
+
+static inline int id_bucket(int drone_id) {
+    return (int)(((unsigned)drone_id * 2654435761u) & (unsigned)id_hash_mask);
+}
+
+// Marca el drone inactivo y lo saca de las colas de amenazas (con su lock tomado)
+static void drone_stop(int slot) {
+    tracked_drone_t *d = &drones[slot];
+    d->active = 0;
+    if(d->in_defense_zone) {
+        d->in_defense_zone = 0;
+        __atomic_sub_fetch(&num_in_defense, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch(&d->status_version, 1, __ATOMIC_RELEASE);
+    threats_moved(slot, -1);
+}
+
+// Saca el slot de la rueda y del índice y lo devuelve a la lista libre (con su lock tomado)
+static void drone_release(int slot) {
+    tracked_drone_t *d = &drones[slot];
+    sem_wait(&sem_wheel);
+    wheel_unlink(slot);
+    sem_post(&sem_wheel);
+
+    sem_wait(&sem_registry);
+    int *p = &id_hash[id_bucket(d->global_id)];
+    while(*p >= 0 && *p != slot) p = &drones[*p].hash_next;
+    if(*p == slot) *p = d->hash_next;
+    d->hash_next = free_slot;
+    free_slot = slot;
+    if(!d->shot_down) num_tracked--;   // la lápida ya se descontó al derribarlo
+    d->shot_down = 0;
+    sem_post(&sem_registry);
+}
+
+// Marca el drone inactivo, lo saca de colas, rueda e índice y devuelve su slot
+// a la lista libre (con su lock tomado)
+static void drone_deactivate(int slot) {
+    drone_stop(slot);
+    drone_release(slot);
+}
+
+// Derribado: deja de rastrearse pero queda en el índice como lápida hasta
+// TRACK_TIMEOUT, para que un POS que ya venía en camino (p.ej. dentro de un
+// MSG_POS_BATCH) no lo vuelva a agregar y se lo derribe dos veces (con su lock tomado)
+static void drone_shoot_down(int slot) {
+    drone_stop(slot);
+    drones[slot].shot_down = 1;
+    wheel_schedule(slot);
+    sem_wait(&sem_registry);
+    num_tracked--;
+    sem_post(&sem_registry);
 }
 
 void notify_center_hit(int drone_id, int swarm_id) {
@@ -69,9 +493,10 @@ void notify_center_hit(int drone_id, int swarm_id) {
     hit_msg.swarm_id = swarm_id;
     hit_msg.drone_id = drone_id;
     snprintf(hit_msg.text, sizeof(hit_msg.text), "DRONE %d SHOT_DOWN", drone_id);
-    
-    send_msg(artillery_sock, center_port, &hit_msg);
-    printf("[ARTILLERY] *** IMPACTO *** Drone %d (swarm %d) derribado!\n", drone_id, swarm_id);
+
+    // al shard del centro que tiene el swarm
+    send_msg_reliable(artillery_sock, port_for_center_shard(BASE_PORT, center_shard_of_swarm(swarm_id)), &hit_msg);
+    LOGI("*** IMPACTO *** Drone %d (swarm %d) derribado!", drone_id, swarm_id);
 }
 
 void notify_drone_hit(int drone_id) {
@@ -80,261 +505,677 @@ void notify_drone_hit(int drone_id) {
     hit_msg.type = MSG_ARTILLERY;
     hit_msg.drone_id = drone_id;
     snprintf(hit_msg.text, sizeof(hit_msg.text), "HIT");
-    
+
     int drone_port = port_for_drone(BASE_PORT, drone_id);
-    send_msg(artillery_sock, drone_port, &hit_msg);
+    send_msg_reliable(artillery_sock, drone_port, &hit_msg);
+}
+
+// Slot de un drone vivo o -1 (con sem_registry tomado)
+static int find_drone_locked(int drone_id) {
+    for(int i = id_hash[id_bucket(drone_id)]; i >= 0; i = drones[i].hash_next)
+        if(drones[i].global_id == drone_id) return i;
+    return -1;
 }
 
-tracked_drone_t* find_drone(int drone_id) {
-    for(int i = 0; i < num_tracked; i++) {
-        if(drones[i].global_id == drone_id && drones[i].active) {
-            return &drones[i];
+// Slot de un drone vivo o -1. El slot puede liberarse y reutilizarse después:
+// quien lo use debe verificar global_id y active bajo el lock del drone.
+int find_drone(int drone_id) {
+    sem_wait(&sem_registry);
+    int slot = find_drone_locked(drone_id);
+    sem_post(&sem_registry);
+    return slot;
+}
+
+// Respeta el orden drone -> registro: el slot se toma del registro, se inicializa con
+// su lock (quien usaba el slot antes ya lo soltó) y recién entonces se enlaza en el
+// índice, con el registro tomado de nuevo
+static int add_drone(int drone_id, int swarm_id) {
+    static int full_logged = 0;
+    sem_wait(&sem_registry);
+    int slot = find_drone_locked(drone_id);
+    if(slot >= 0) {
+        sem_post(&sem_registry);
+        return slot;
+    }
+    if(free_slot >= 0) {
+        slot = free_slot;
+        free_slot = drones[slot].hash_next;
+    } else if(slots_used < MAX_TRACKED) {
+        slot = slots_used++;
+    }
+    sem_post(&sem_registry);
+    if(slot < 0) {
+        if(!full_logged) {
+            full_logged = 1;
+            LOGW("Registro lleno (MAX_TRACKED=%d), drone %d sin rastrear", MAX_TRACKED, drone_id);
         }
+        return -1;
     }
-    return NULL;
-}
 
-tracked_drone_t* add_drone(int drone_id, int swarm_id) {
-    if(num_tracked >= MAX_DRONES_TRACKED) return NULL;
-    
-    drones[num_tracked].global_id = drone_id;
-    drones[num_tracked].swarm_id = swarm_id;
-    drones[num_tracked].x = 0.0;
-    drones[num_tracked].y = 0.0;
-    drones[num_tracked].in_defense_zone = 0;
-    drones[num_tracked].active = 1;
-    drones[num_tracked].last_update = time(NULL);
-    
-    return &drones[num_tracked++];
+    tracked_drone_t *d = &drones[slot];
+    sem_wait(drone_lock(slot));
+    d->global_id = drone_id;
+    d->swarm_id = swarm_id;
+    d->x = 0.0;
+    d->y = 0.0;
+    d->vx = 0.0;
+    d->t_pos = 0.0;
+    d->in_defense_zone = 0;
+    d->active = 1;
+    d->shot_down = 0;
+    d->bucket = -1;
+    d->expire_tick = -1;
+    sem_wait(&sem_registry);
+    int other = find_drone_locked(drone_id);   // otro hilo lo agregó entretanto
+    if(other >= 0) {
+        d->active = 0;
+        d->hash_next = free_slot;
+        free_slot = slot;
+    } else {
+        int *head = &id_hash[id_bucket(drone_id)];
+        d->hash_next = *head;
+        *head = slot;
+        num_tracked++;
+    }
+    sem_post(&sem_registry);
+    __atomic_add_fetch(&d->status_version, 1, __ATOMIC_RELEASE);
+    sem_post(drone_lock(slot));
+    if(other >= 0) return other;
+    LOGI("Rastreando nuevo drone %d (swarm %d)", drone_id, swarm_id);
+    return slot;
 }
 
 void update_drone_position(int drone_id, int swarm_id, double x, double y) {
-    sem_wait(&sem_tracking);
-    
-    tracked_drone_t* drone = find_drone(drone_id);
-    if(!drone) {
-        drone = add_drone(drone_id, swarm_id);
-        if(!drone) {
-            sem_post(&sem_tracking);
+    int slot;
+    tracked_drone_t *drone;
+    for(;;) {
+        slot = find_drone(drone_id);
+        if(slot < 0) slot = add_drone(drone_id, swarm_id);
+        if(slot < 0) return;
+        drone = &drones[slot];
+        sem_wait(drone_lock(slot));
+        if(drone->global_id == drone_id && drone->active) break;
+        if(drone->global_id == drone_id && drone->shot_down) {
+            sem_post(drone_lock(slot));   // POS atrasado de un drone ya derribado
             return;
         }
-        printf("[ARTILLERY] Rastreando nuevo drone %d (swarm %d)\n", drone_id, swarm_id);
+        sem_post(drone_lock(slot));   // el slot venció y se reutilizó entretanto
     }
-    
+    double t = now_mono();
+    if(drone->t_pos > 0 && t - drone->t_pos > 0.05)
+        drone->vx = 0.5 * drone->vx + 0.5 * (x - drone->x) / (t - drone->t_pos);
+    drone->t_pos = t;
     drone->x = x;
     drone->y = y;
     drone->swarm_id = swarm_id; // actualizar swarm en caso de reconformación
-    drone->last_update = time(NULL);
-    
-    // Verificar si entró en zona de defensa
+    wheel_schedule(slot);
+
+    int old_bucket = drone->bucket;
+    drone->bucket = bucket_of(x, y);
+    threats_moved(slot, old_bucket);
+
+    // Verificar si entró en zona de defensa (alcance de alguna batería)
     int was_in_defense = drone->in_defense_zone;
-    int now_in_defense = (x >= B && x <= A);
-    
+    int now_in_defense = in_coverage(x, y);
+    drone->in_defense_zone = now_in_defense;
+    if(was_in_defense != now_in_defense) {
+        __atomic_add_fetch(&num_in_defense, now_in_defense ? 1 : -1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&drone->status_version, 1, __ATOMIC_RELEASE);
+    }
+    sem_post(drone_lock(slot));
+
     if(!was_in_defense && now_in_defense) {
-        drone->in_defense_zone = 1;
-        printf("[ARTILLERY] Drone %d entró en zona de defensa (%.1f, %.1f)\n", 
+        LOGI("Drone %d entró en zona de defensa (%.1f, %.1f)",
                drone_id, x, y);
+        journal_append(JEV_ZONE_ENTER, swarm_id, drone_id, 0, x, y);
     }
     else if(was_in_defense && !now_in_defense) {
-        drone->in_defense_zone = 0;
-        if(x > A) {
-            printf("[ARTILLERY] Drone %d salió de zona de defensa\n", drone_id);
-        }
+        LOGI("Drone %d salió de zona de defensa", drone_id);
+        journal_append(JEV_ZONE_EXIT, swarm_id, drone_id, 0, x, y);
     }
-    
-    sem_post(&sem_tracking);
 }
 
-void artillery_engagement_cycle() {
-    sem_wait(&sem_tracking);
-    
-    time_t now = time(NULL);
-    
-    for(int i = 0; i < num_tracked; i++) {
-        if(!drones[i].active || !drones[i].in_defense_zone) continue;
-        
-        // Verificar si el drone sigue activo (timeout de 10 segundos)
-        if(now - drones[i].last_update > 10) {
-            printf("[ARTILLERY] Drone %d timeout, removiendo del tracking\n", 
-                   drones[i].global_id);
-            drones[i].active = 0;
+typedef struct { int drone_id, swarm_id; double x, y; } hit_t;
+
+// Un ciclo de disparo de una batería: hasta shots_per_cycle disparos (si queda
+// munición) a las amenazas más urgentes de su cola, cada uno con probabilidad
+// según la distancia
+void battery_engage(battery_t *b, unsigned int *seed) {
+    static __thread int *picked = NULL, picked_cap = 0;
+    static __thread hit_t *hits = NULL;
+    static __thread int hits_cap = 0;
+
+    if(b->ammo == 0) {
+        if(!b->out_of_ammo_logged) {
+            b->out_of_ammo_logged = 1;
+            LOGW("Batería %d sin munición", b->id);
+        }
+        return;
+    }
+
+    // Sacar las más urgentes; las que sobrevivan vuelven a la cola con su key actual.
+    // Se sacan algunas de más por si hay tracks vencidos entre ellas.
+    int want = b->shots_per_cycle * 2;
+    if(want > picked_cap) {
+        picked_cap = want;
+        picked = realloc(picked, picked_cap * sizeof(int));
+    }
+    int n = 0;
+    sem_wait(&b->heap_lock);
+    while(n < want && b->heap_len > 0) {
+        int s = b->heap[0].slot;
+        heap_remove(b, s);
+        picked[n++] = s;
+    }
+    sem_post(&b->heap_lock);
+
+    int nh = 0, fired = 0;
+    for(int k = 0; k < n; k++) {
+        int s = picked[k];
+        tracked_drone_t *d = &drones[s];
+        sem_wait(drone_lock(s));
+        if(!d->active) { sem_post(drone_lock(s)); continue; }
+
+        double p = hit_probability(b, d->x, d->y);
+        if(p <= 0 || fired >= b->shots_per_cycle || b->ammo == 0) {
+            threat_refresh(b, s);
+            sem_post(drone_lock(s));
             continue;
         }
-        
-        // Intentar disparo con probabilidad W%
-        if(rand() % 100 < W) {
-            printf("[ARTILLERY] ¡DISPARANDO contra drone %d!\n", drones[i].global_id);
-            
-            // Notificar al centro de control
-            notify_center_hit(drones[i].global_id, drones[i].swarm_id);
-            
-            // Notificar directamente al drone
-            notify_drone_hit(drones[i].global_id);
-            
-            // Marcar como destruido
-            drones[i].active = 0;
+
+        fired++;
+        b->shots++;
+        if(b->ammo > 0) b->ammo--;
+        if(rand_r(seed) < p * ((double)RAND_MAX + 1.0)) {
+            // Marcar como destruido (bajo su lock: ninguna otra batería lo vuelve a derribar)
+            drone_shoot_down(s);
+            if(nh == hits_cap) {
+                hits_cap = hits_cap ? hits_cap * 2 : 16;
+                hits = realloc(hits, hits_cap * sizeof(hit_t));
+            }
+            hits[nh++] = (hit_t){ d->global_id, d->swarm_id, d->x, d->y };
+            b->hits++;
+        } else {
+            threat_refresh(b, s);
+        }
+        sem_post(drone_lock(s));
+    }
+
+    for(int k = 0; k < nh; k++) {
+        LOGI("¡DISPARANDO contra drone %d! (batería %d)", hits[k].drone_id, b->id);
+        // Notificar al centro de control y directamente al drone
+        notify_center_hit(hits[k].drone_id, hits[k].swarm_id);
+        notify_drone_hit(hits[k].drone_id);
+        journal_append(JEV_HIT, hits[k].swarm_id, hits[k].drone_id, b->id, hits[k].x, hits[k].y);
+    }
+}
+
+// Procesa los ticks de la rueda hasta now_tick y descarta los tracks vencidos.
+// Devuelve cuántos vencieron; el costo es proporcional a eso (más los ticks).
+int expire_tracks(long now_tick) {
+    static int *expired = NULL, cap = 0;
+    int n = 0;
+    sem_wait(&sem_wheel);
+    for(; wheel_tick < now_tick; ) {
+        wheel_tick++;
+        for(int s = wheel_head[wheel_tick & wheel_mask], next; s >= 0; s = next) {
+            next = drones[s].wheel_next;
+            // de una vuelta futura: solo pasa si la rueda se atrasó más que su tamaño
+            if(drones[s].expire_tick > wheel_tick) continue;
+            wheel_unlink(s);
+            if(n == cap) {
+                cap = cap ? cap * 2 : 64;
+                expired = realloc(expired, cap * sizeof(int));
+            }
+            expired[n++] = s;
         }
     }
-    
-    sem_post(&sem_tracking);
-}
-
-void print_artillery_status() {
-    sem_wait(&sem_tracking);
-    
-    int active_count = 0;
-    int in_defense_count = 0;
-    
-    printf("=== ARTILLERY STATUS ===\n");
-    for(int i = 0; i < num_tracked; i++) {
-        if(drones[i].active) {
-            active_count++;
-            if(drones[i].in_defense_zone) in_defense_count++;
-            
-            printf("Drone %d (S%d): (%.1f,%.1f) %s\n", 
-                   drones[i].global_id, 
-                   drones[i].swarm_id,
-                   drones[i].x, 
-                   drones[i].y,
-                   drones[i].in_defense_zone ? "[EN ZONA DEFENSA]" : "");
+    sem_post(&sem_wheel);
+
+    int evicted = 0;
+    for(int k = 0; k < n; k++) {
+        int s = expired[k];
+        sem_wait(drone_lock(s));
+        // un POS pudo reprogramarlo entre que salió de la rueda y este lock
+        if(drones[s].active && drones[s].expire_tick < 0) {
+            LOGW("Drone %d timeout, removiendo del tracking", drones[s].global_id);
+            drone_deactivate(s);
+            evicted++;
+        } else if(drones[s].shot_down && drones[s].expire_tick < 0) {
+            drone_release(s);   // vence la lápida de un derribado
         }
+        sem_post(drone_lock(s));
+    }
+    return evicted;
+}
+
+// Un ciclo de todas las baterías en este hilo (sin esperar sus cadencias)
+void artillery_engagement_cycle() {
+    static unsigned int seed = 1;
+    for(int i = 0; i < num_batteries; i++) battery_engage(&batteries[i], &seed);
+}
+
+static void print_tracked_line(const tracked_drone_t *d) {
+    if(d->active)
+        printf("Drone %d (S%d): (%.1f,%.1f) %s\n", d->global_id, d->swarm_id, d->x, d->y,
+               d->in_defense_zone ? "[EN ZONA DEFENSA]" : "");
+    else
+        printf("Drone %d (S%d): fuera de seguimiento\n", d->global_id, d->swarm_id);
+}
+
+// Totales desde contadores atómicos y solo los drones que empezaron o dejaron de
+// rastrearse o cruzaron la zona desde el reporte anterior (hasta STATUS_MAX_DIFF;
+// la búsqueda de cambios no toma locks). full lista todos los activos.
+void print_artillery_status(int full) {
+    static unsigned *reported = NULL;
+    static int reported_cap = 0;
+    if(reported_cap < MAX_TRACKED) {
+        unsigned *r = realloc(reported, MAX_TRACKED * sizeof(unsigned));
+        if(!r) return;
+        memset(r + reported_cap, 0, (MAX_TRACKED - reported_cap) * sizeof(unsigned));
+        reported = r;
+        reported_cap = MAX_TRACKED;
+    }
+    int n = __atomic_load_n(&slots_used, __ATOMIC_ACQUIRE);
+
+    printf("=== ARTILLERY STATUS%s ===\n", full ? " (completo)" : "");
+    int changed = 0, listed = 0;
+    for(int i = 0; i < n; i++) {
+        unsigned v = __atomic_load_n(&drones[i].status_version, __ATOMIC_ACQUIRE);
+        int diff = v != reported[i];
+        reported[i] = v;
+        changed += diff;
+        if(!(full || (diff && listed < STATUS_MAX_DIFF))) continue;
+        sem_wait(drone_lock(i));
+        tracked_drone_t d = drones[i];
+        sem_post(drone_lock(i));
+        if(full && !d.active && !diff) continue;
+        print_tracked_line(&d);
+        listed++;
+    }
+    if(!full && changed > listed)
+        printf("... y %d drones más con cambios (kill -USR1 %d para el estado completo)\n",
+               changed - listed, (int)getpid());
+    printf("Total activos: %d, En zona defensa: %d, slots usados: %d/%d, cambios: %d\n",
+           num_tracked, __atomic_load_n(&num_in_defense, __ATOMIC_RELAXED), n, MAX_TRACKED, changed);
+    int pending; unsigned long retx, dropped, dups;
+    reliable_stats(&pending, &retx, &dropped, &dups);
+    printf("Avisos confiables: pendientes=%d reintentos=%lu sin_ack=%lu duplicados=%lu\n",
+           pending, retx, dropped, dups);
+    int queued = 0, rcvbuf = 0;
+    int fill = sock_queue_fill(artillery_sock, &queued, &rcvbuf);
+    printf("Socket: cola=%d/%d kB (%d%%) descartes=%lu\n",
+           queued / 1024, rcvbuf / 1024, fill, sock_drops(artillery_sock));
+    for(int i = 0; i < num_batteries; i++) {
+        const battery_t *b = &batteries[i];
+        if(b->range < 0)
+            printf("Batería %d: banda %.1f<=x<=%.1f amenazas=%d disparos=%ld impactos=%ld\n",
+                   b->id, B, A, b->heap_len, b->shots, b->hits);
+        else
+            printf("Batería %d: (%.1f,%.1f) r=%.1f munición=%d amenazas=%d disparos=%ld impactos=%ld\n",
+                   b->id, b->x, b->y, b->range, b->ammo, b->heap_len, b->shots, b->hits);
     }
-    printf("Total activos: %d, En zona defensa: %d\n", active_count, in_defense_count);
-    
-    sem_post(&sem_tracking);
 }
 
 void mark_drone_dead(int drone_id) {
-    sem_wait(&sem_tracking);
-    for(int i = 0; i < num_tracked; i++) {
-        if(drones[i].global_id == drone_id) {
-            drones[i].active = 0;
-            printf("[ARTILLERY] Drone %d eliminado del tracking\n", drone_id);
+    int slot = find_drone(drone_id);
+    if(slot < 0) return;
+    sem_wait(drone_lock(slot));
+    if(drones[slot].global_id == drone_id && drones[slot].active) {
+        drone_deactivate(slot);
+        LOGI("Drone %d eliminado del tracking", drone_id);
+    }
+    sem_post(drone_lock(slot));
+}
+
+// Despacha un mensaje recibido por la artillería
+// Cambios de parámetros en caliente: pk de las baterías que lo toman de W y cadencia
+// de la banda clásica (VX se lee directo de la instantánea al ordenar amenazas)
+static void apply_live_params(const live_params_t *old, const live_params_t *now) {
+    if(now->W != old->W)
+        for(int i = 0; i < num_batteries; i++)
+            if(batteries[i].pk_from_w) batteries[i].pk = now->W / 100.0;
+    if(legacy_band && now->ARTILLERY_RATE != old->ARTILLERY_RATE)
+        batteries[0].rate = now->ARTILLERY_RATE;
+}
+
+void dispatch_artillery_message(const msg_view_t *m, struct sockaddr_in *from) {
+    if(m->type == MSG_PING) {
+        send_view(artillery_sock, ntohs(from->sin_port), m);
+    }
+    else if(m->type == MSG_STATUS) {
+        // Procesar mensajes de posición: "POS x y"
+        if(strncmp(m->text, "POS ", 4) == 0) {
+            double x, y;
+            if(sscanf(m->text + 4, "%lf %lf", &x, &y) == 2) {
+                update_drone_position(m->drone_id, m->swarm_id, x, y);
+            }
+        }
+        else if(strstr(m->text, "ARRIVED_DETONATED") ||
+                strstr(m->text, "CAMERA_AUTODESTRUCT")) {
+            mark_drone_dead(m->drone_id);
+        }
+    }
+    else if(m->type == MSG_POS_BATCH) {
+        // Lote de un worker_agent: "gid swarm x y;" por cada POS de sus drones
+        const char *p = m->text, *end = m->text + m->text_len;
+        while(p < end) {
+            char *q;
+            int gid = (int)strtol(p, &q, 10);
+            if(q == p) break;
+            int sid = (int)strtol(q, &q, 10);
+            double x = strtod(q, &q);
+            double y = strtod(q, &q);
+            if(*q != ';') break;
+            update_drone_position(gid, sid, x, y);
+            p = q + 1;
+        }
+    }
+    else if(m->type == MSG_ARTILLERY) {
+        if(strstr(m->text, "TERMINATE")) {
+            LOGI("Recibido TERMINATE. Finalizando sistema de artillería...");
+            exit(0);
+        }
+        else if(strstr(m->text, "SHOT_DOWN")) {
+            mark_drone_dead(m->drone_id);
+        }
+        else if(strstr(m->text, "ENTERING_DEFENSE")) {
+            LOGD("Drone %d reportó entrada en zona de defensa", m->drone_id);
+        }
+        // "SET W n" del operador (socket de control del centro)
+        else if(strncmp(m->text, "SET W ", 6) == 0) {
+            int w = atoi(m->text + 6);
+            if(w >= 0 && w <= 100) {
+                live_params_t *p = live_params_begin();
+                p->W = w;
+                const live_params_t *old = live_params_commit(p);
+                LOGI("Probabilidad de derribo cambiada por el operador: W=%d%%", w);
+                apply_live_params(old, p);
+            }
+        }
+        else if(strstr(m->text, "TRUCK_READY")) {
+            LOGI("%s", m->text);
+        }
+        else if(strncmp(m->text, "REASSIGN", 8) == 0) {
+            int drone_id, new_swarm;
+            if(sscanf(m->text, "REASSIGN %d %d", &drone_id, &new_swarm) == 2) {
+                int slot = find_drone(drone_id);
+                if(slot >= 0) {
+                    sem_wait(drone_lock(slot));
+                    drones[slot].swarm_id = new_swarm;
+                    sem_post(drone_lock(slot));
+                    LOGI("Drone %d reasignado a swarm %d", drone_id, new_swarm);
+                }
+            }
         }
     }
-    sem_post(&sem_tracking);
 }
 
 void* listener_thread(void* arg) {
     (void)arg;
-    
+
     struct sockaddr_in from;
-    msg_t m;
-    
+    msg_view_t m;
+
     while(1) {
-        if(recv_msg(artillery_sock, &m, &from) <= 0) {
+        if(recv_view(artillery_sock, &m, &from) <= 0) {
             usleep(50000); // 50ms
             continue;
         }
-        
-        if(m.type == MSG_STATUS) {
-            // Procesar mensajes de posición: "POS x y"
-            if(strncmp(m.text, "POS ", 4) == 0) {
-                double x, y;
-                if(sscanf(m.text + 4, "%lf %lf", &x, &y) == 2) {
-                    update_drone_position(m.drone_id, m.swarm_id, x, y);
-                }
-            }
-            else if(strstr(m.text, "ARRIVED_DETONATED") ||
-                    strstr(m.text, "CAMERA_AUTODESTRUCT")) {
-                mark_drone_dead(m.drone_id);
-            }
-        }
-        else if(m.type == MSG_ARTILLERY) {
-            if(strstr(m.text, "TERMINATE")) {
-                printf("[ARTILLERY] Recibido TERMINATE. Finalizando sistema de artillería...\n");
-                exit(0);
-            }
-            else if(strstr(m.text, "SHOT_DOWN")) {
-                mark_drone_dead(m.drone_id);
-            }
-            else if(strstr(m.text, "ENTERING_DEFENSE")) {
-                printf("[ARTILLERY] Drone %d reportó entrada en zona de defensa\n", m.drone_id);
-            }
-            else if(strstr(m.text, "TRUCK_READY")) {
-                printf("[ARTILLERY] %s\n", m.text);
-            }
-            else if(strncmp(m.text, "REASSIGN", 8) == 0) {
-                int drone_id, new_swarm;
-                if(sscanf(m.text, "REASSIGN %d %d", &drone_id, &new_swarm) == 2) {
-                    sem_wait(&sem_tracking);
-                    tracked_drone_t* d = find_drone(drone_id);
-                    if(d) {
-                        d->swarm_id = new_swarm;
-                        printf("[ARTILLERY] Drone %d reasignado a swarm %d\n", drone_id, new_swarm);
-                    }
-                    sem_post(&sem_tracking);
-                }
+        dispatch_artillery_message(&m, &from);
+    }
+    return NULL;
+}
+
+// Hilo de trabajo w: atiende las baterías i con i % ARTILLERY_WORKERS == w,
+// cada una a su propia cadencia
+void* engagement_thread(void* arg) {
+    int w = (int)(intptr_t)arg;
+    unsigned int *seed = &worker_seeds[w];
+
+    while(1) {
+        double now = now_mono(), next = now + 0.1;
+        for(int i = w; i < num_batteries; i += ARTILLERY_WORKERS) {
+            battery_t *b = &batteries[i];
+            if(b->next_fire <= now) {
+                battery_engage(b, seed);
+                b->next_fire += b->rate;
+                if(b->next_fire < now) b->next_fire = now + b->rate; // se atrasó: no acumular ráfagas
             }
+            if(b->next_fire < next) next = b->next_fire;
         }
+        double wait = next - now_mono();
+        if(wait > 0) usleep((useconds_t)(wait * 1e6));
     }
+
     return NULL;
 }
 
-void* engagement_thread(void* arg) {
+// Avanza la rueda de vencimientos una vez por segundo
+void* expiry_thread(void* arg) {
     (void)arg;
-    
     while(1) {
-        sleep(ARTILLERY_RATE);
-        artillery_engagement_cycle();
+        sleep(1);
+        expire_tracks((long)now_mono());
     }
-    
     return NULL;
 }
 
+// ---------- instantáneas (CHECKPOINT_DIR) ----------
+// artillery.ckpt: munición y contadores de cada batería, estado de rand_r de cada hilo
+// de trabajo, W vigente y tracks activos (posición y velocidad estimada). Las colas de
+// amenazas y la rueda se reconstruyen al reinsertar los tracks.
+typedef struct { int num_batteries, workers, W, ntracks; } artillery_ckpt_t;
+typedef struct { int ammo; long shots, hits; } battery_ckpt_t;
+typedef struct { int global_id, swarm_id; double x, y, vx; } track_ckpt_t;
+
+// Todos los locks de drones (en orden) y después el registro, en el mismo orden
+// drone -> registro que el resto (add_drone incluido): ningún track ni contador de
+// batería queda a medio actualizar en la copia del hijo
+static void artillery_ckpt_lock(void) {
+    for(int i = 0; i < LOCK_STRIPES; i++) sem_wait(&drone_locks[i]);
+    sem_wait(&sem_registry);
+}
+
+static void artillery_ckpt_unlock(void) {
+    sem_post(&sem_registry);
+    for(int i = LOCK_STRIPES - 1; i >= 0; i--) sem_post(&drone_locks[i]);
+}
+
+static void artillery_ckpt_emit(ckpt_out_t *o, void *arg) {
+    (void)arg;
+    artillery_ckpt_t h = { num_batteries, ARTILLERY_WORKERS, live_params()->W, 0 };
+    for(int s = 0; s < slots_used; s++) h.ntracks += drones[s].active;
+    ckpt_put(o, &h, sizeof(h));
+    for(int i = 0; i < num_batteries; i++) {
+        battery_ckpt_t b = { batteries[i].ammo, batteries[i].shots, batteries[i].hits };
+        ckpt_put(o, &b, sizeof(b));
+    }
+    ckpt_put(o, worker_seeds, ARTILLERY_WORKERS * sizeof(unsigned int));
+    for(int s = 0; s < slots_used; s++) {
+        const tracked_drone_t *d = &drones[s];
+        if(!d->active) continue;
+        track_ckpt_t t = { d->global_id, d->swarm_id, d->x, d->y, d->vx };
+        ckpt_put(o, &t, sizeof(t));
+    }
+}
+
+int artillery_checkpoint(void) {
+    if(ckpt_write_forked(checkpoint_dir, "artillery.ckpt", CKPT_ARTILLERY,
+                         artillery_ckpt_lock, artillery_ckpt_unlock, artillery_ckpt_emit, NULL) < 0){
+        LOGW("No se pudo escribir %s/artillery.ckpt: %s", checkpoint_dir, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+// Carga artillery.ckpt tras artillery_setup y antes de arrancar los hilos. La munición
+// y las semillas solo se aplican si coinciden las baterías y los hilos configurados.
+int artillery_restore(void) {
+    size_t len;
+    int64_t written_at;
+    char *data = ckpt_read(checkpoint_dir, "artillery.ckpt", CKPT_ARTILLERY, &len, &written_at);
+    if(!data) {
+        LOGE("No hay una instantánea válida en %s/artillery.ckpt", checkpoint_dir);
+        return -1;
+    }
+    ckpt_in_t in = { data, len };
+    artillery_ckpt_t h;
+    if(ckpt_get(&in, &h, sizeof(h)) < 0 || h.num_batteries < 0 || h.workers < 1 ||
+       in.left != h.num_batteries * sizeof(battery_ckpt_t) + h.workers * sizeof(unsigned int) +
+                  (size_t)h.ntracks * sizeof(track_ckpt_t)) {
+        LOGE("%s/artillery.ckpt está incompleta", checkpoint_dir);
+        free(data);
+        return -1;
+    }
+    for(int i = 0; i < h.num_batteries; i++) {
+        battery_ckpt_t b;
+        ckpt_get(&in, &b, sizeof(b));
+        if(h.num_batteries != num_batteries) continue;
+        batteries[i].ammo = b.ammo;
+        batteries[i].shots = b.shots;
+        batteries[i].hits = b.hits;
+    }
+    if(h.num_batteries != num_batteries)
+        LOGW("La instantánea tiene %d baterías y params.txt %d: munición sin restaurar",
+             h.num_batteries, num_batteries);
+    if(h.workers == ARTILLERY_WORKERS) ckpt_get(&in, worker_seeds, h.workers * sizeof(unsigned int));
+    else {
+        in.p += h.workers * sizeof(unsigned int);
+        in.left -= h.workers * sizeof(unsigned int);
+    }
+    if(h.W != live_params()->W) {
+        live_params_t *p = live_params_begin();
+        p->W = h.W;
+        apply_live_params(live_params_commit(p), p);
+    }
+    for(int k = 0; k < h.ntracks; k++) {
+        track_ckpt_t t;
+        ckpt_get(&in, &t, sizeof(t));
+        update_drone_position(t.global_id, t.swarm_id, t.x, t.y);
+        int slot = find_drone(t.global_id);
+        if(slot < 0) continue;
+        sem_wait(drone_lock(slot));
+        drones[slot].vx = t.vx;
+        sem_post(drone_lock(slot));
+    }
+    free(data);
+    LOGI("Artillería retomada de %s/artillery.ckpt (de hace %lds): %d tracks, W=%d%%",
+         checkpoint_dir, (long)(time(NULL) - written_at), h.ntracks, h.W);
+    return 0;
+}
+
+#ifndef SIM_NO_MAIN
+static void on_sigusr1(int sig) {
+    (void)sig;
+    full_status_requested = 1;
+}
+
 int main(int argc, char** argv) {
     if(argc < 2) {
-        printf("Uso: artillery params.txt\n");
+        printf("Uso: artillery params.txt [--restore]\n");
         exit(1);
     }
-    
-    // Inicializar semáforos
-    sem_init(&sem_tracking, 0, 1);
-    
+    int restore = argc > 2 && strcmp(argv[2], "--restore") == 0;
+
     // Cargar parámetros
+    budget_load(argv[1]);
+    log_init("ARTILLERY", argv[1]);
     load_params(argv[1]);
-    
+    live_params_load(argv[1]);
+    if(net_load(argv[1]) > 0)
+        LOGI("Modo distribuido: POS agrupados por %d worker_agent", net_workers());
+    if(sim_budget) {
+        // registro a la medida de la flota: solo hay tracks de drones vivos
+        MAX_TRACKED = ASSEMBLY_SIZE * NUM_SWARMS + ASSEMBLY_SIZE;
+        LOGI("Modo presupuesto: MAX_TRACKED=%d, pila de hilos %zu kB", MAX_TRACKED, sim_thread_stack / 1024);
+    }
+
+    if(ARTILLERY_WORKERS < 1) ARTILLERY_WORKERS = 1;
+    if(artillery_setup() < 0) { perror("artillery_setup"); exit(1); }
+
+    int checkpoint_secs;
+    int checkpointing = ckpt_config(argv[1], checkpoint_dir, sizeof(checkpoint_dir), &checkpoint_secs);
+    if(restore && !checkpointing) {
+        LOGE("--restore requiere CHECKPOINT_DIR en %s", argv[1]);
+        exit(1);
+    }
+
+    char jdir[200];
+    if(params_get_string(argv[1], "JOURNAL_DIR", jdir, sizeof(jdir))){
+        char jpath[256];
+        snprintf(jpath, sizeof(jpath), "%s/%s", jdir, restore ? "artillery.resumed.journal" : "artillery.journal");
+        journal_open(jpath, JSRC_ARTILLERY);
+    }
+    if(restore && artillery_restore() < 0) exit(1);
+
     // Inicializar red
     artillery_sock = make_udp_socket();
-    center_port = port_for_center(BASE_PORT);
-    
+    budget_rcvbuf(artillery_sock, ASSEMBLY_SIZE * NUM_SWARMS + 1);
+    int rcvbuf = sock_tune(artillery_sock, argv[1]);
+
     int artillery_port = port_for_artillery(BASE_PORT);
     struct sockaddr_in addr;
     memset(&addr, 0, sizeof(addr));
     addr.sin_family = AF_INET;
-    addr.sin_addr.s_addr = inet_addr(HOST);
+    addr.sin_addr.s_addr = net_addr_for_port(artillery_port);
     addr.sin_port = htons(artillery_port);
-    
+
     if(bind(artillery_sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
         perror("bind artillery");
         exit(1);
     }
-    
-    printf("[ARTILLERY] Sistema iniciado en puerto %d\n", artillery_port);
-    printf("[ARTILLERY] Zona de defensa: %.1f <= X <= %.1f\n", B, A);
-    printf("[ARTILLERY] Probabilidad de derribo: %d%%\n", W);
-    
-    srand(time(NULL));
-    
+
+    LOGI("Sistema iniciado en puerto %d (SO_RCVBUF %d kB)", artillery_port, rcvbuf / 1024);
+    if(params_watch(argv[1], apply_live_params))
+        LOGI("Recarga en caliente de %s habilitada", argv[1]);
+    if(legacy_band) {
+        LOGI("Zona de defensa: %.1f <= X <= %.1f", B, A);
+        LOGI("Probabilidad de derribo: %d%%, %d disparos por ciclo", W, batteries[0].shots_per_cycle);
+    } else {
+        for(int i = 0; i < num_batteries; i++)
+            LOGI("Batería %d en (%.1f, %.1f) alcance=%.1f cadencia=%.1fs munición=%d pk=%.0f%% disparos/ciclo=%d",
+                 i, batteries[i].x, batteries[i].y, batteries[i].range, batteries[i].rate,
+                 batteries[i].ammo, batteries[i].pk * 100, batteries[i].shots_per_cycle);
+    }
+
     // Crear hilos
-    pthread_t lt, et;
-    pthread_create(&lt, NULL, listener_thread, NULL);
-    pthread_create(&et, NULL, engagement_thread, NULL);
-    
-    // Bucle principal con información de estado
+    pthread_t lt, xt;
+    pthread_t *et = malloc(ARTILLERY_WORKERS * sizeof(pthread_t));
+    sim_thread_create(&lt, listener_thread, NULL);
+    sim_thread_create(&xt, expiry_thread, NULL);
+    reliable_start();
+    for(int w = 0; w < ARTILLERY_WORKERS; w++)
+        sim_thread_create(&et[w], engagement_thread, (void*)(intptr_t)w);
+    if(checkpointing) {
+        artillery_checkpoint();
+        if(ckpt_start(checkpoint_secs, artillery_checkpoint) == 0)
+            LOGI("Instantáneas en %s/artillery.ckpt cada %d s", checkpoint_dir, checkpoint_secs);
+    }
+
+    // Bucle principal con información de estado (SIGUSR1 adelanta un volcado completo)
+    signal(SIGUSR1, on_sigusr1);
     while(1) {
-        sleep(10);
-        print_artillery_status();
+        unsigned left = sleep(10);
+        if(full_status_requested) {
+            full_status_requested = 0;
+            print_artillery_status(1);
+        }
+        if(left == 0) print_artillery_status(0);
     }
-    
+
     // Cleanup
     pthread_cancel(lt);
-    pthread_cancel(et);
     pthread_join(lt, NULL);
-    pthread_join(et, NULL);
-    
-    sem_destroy(&sem_tracking);
+    pthread_cancel(xt);
+    pthread_join(xt, NULL);
+    for(int w = 0; w < ARTILLERY_WORKERS; w++) {
+        pthread_cancel(et[w]);
+        pthread_join(et[w], NULL);
+    }
+    free(et);
     close(artillery_sock);
-    
+
     return 0;
 }
+#endif
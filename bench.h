@@ -0,0 +1,78 @@
+// bench.h - utilidades para los micro-benchmarks (bench_*.c)
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_MAX_POINTS 16
+#define BENCH_MIN_NS     20e6    // mínimo 20ms medidos por punto
+#define BENCH_MAX_ITERS  2000000
+
+typedef struct {
+    const char *name;
+    int n;
+    double size[BENCH_MAX_POINTS];
+    double ns[BENCH_MAX_POINTS];
+} bench_curve_t;
+
+static inline double bench_now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Mide op() en bucle (sin estado que restaurar); devuelve ns/op
+static inline double bench_measure(void (*op)(void *), void *ctx){
+    long iters = 0;
+    double t0 = bench_now_ns(), el = 0;
+    long batch = 1;
+    while(el < BENCH_MIN_NS && iters < BENCH_MAX_ITERS){
+        for(long i = 0; i < batch; i++) op(ctx);
+        iters += batch;
+        batch *= 2;
+        el = bench_now_ns() - t0;
+    }
+    return el / iters;
+}
+
+// Para operaciones que modifican el estado: setup() se ejecuta fuera de la medición
+static inline double bench_measure_reset(void (*setup)(void *), void (*op)(void *), void *ctx){
+    long iters = 0;
+    double timed = 0, wall0 = bench_now_ns();
+    while(timed < BENCH_MIN_NS && iters < BENCH_MAX_ITERS && bench_now_ns() - wall0 < 2e9){
+        setup(ctx);
+        double t0 = bench_now_ns();
+        op(ctx);
+        timed += bench_now_ns() - t0;
+        iters++;
+    }
+    return timed / iters;
+}
+
+static inline void bench_point(bench_curve_t *c, double size, double ns_op){
+    printf("%-40s n=%-8.0f %12.1f ns/op\n", c->name, size, ns_op);
+    fflush(stdout);
+    if(c->n < BENCH_MAX_POINTS){
+        c->size[c->n] = size;
+        c->ns[c->n] = ns_op;
+        c->n++;
+    }
+}
+
+// Pendiente log-log por mínimos cuadrados: ~0 -> O(1), ~1 -> O(n), ~2 -> O(n²)
+static inline void bench_summary(const bench_curve_t *c){
+    if(c->n < 2) return;
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for(int i = 0; i < c->n; i++){
+        double x = log(c->size[i]), y = log(c->ns[i]);
+        sx += x; sy += y; sxx += x*x; sxy += x*y;
+    }
+    double k = (c->n * sxy - sx * sy) / (c->n * sxx - sx * sx);
+    const char *cls = k < 0.35 ? "O(1)" : k < 0.75 ? "sublineal" : k < 1.35 ? "O(n)" :
+                      k < 1.75 ? "superlineal" : "O(n^2) o peor";
+    printf("%-40s escala ~ n^%.2f  [%s]\n\n", c->name, k, cls);
+}
+
+#endif
@@ -0,0 +1,60 @@
+// bench_artillery.c - micro-benchmarks del seguimiento y ciclo de disparo de la artillería
+// Incluye artillery.c sin su main para medir las funciones internas aisladas.
+#define SIM_NO_MAIN
+#include "artillery.c"
+#include "bench.h"
+
+static int sizes[] = { 16, 64, 256, 1024, 4096, 16384 };
+#define NSIZES ((int)(sizeof(sizes)/sizeof(sizes[0])))
+
+static void setup_tracks(int n, double x){
+    MAX_TRACKED = n;
+    free(drones);
+    free(cov_start);
+    free(cov_items);
+    free(id_hash);
+    free(wheel_head);
+    for(int i = 0; i < num_batteries; i++) {
+        free(batteries[i].buckets);
+        free(batteries[i].heap);
+        free(batteries[i].heap_pos);
+    }
+    num_batteries = 0;
+    artillery_setup();
+    batteries[0].pk = 1e-12;  // prácticamente sin impactos: el ciclo no vacía la cola
+    for(int i = 0; i < n; i++) update_drone_position(i + 1, i / 5, x, (i % 64) * 0.5);
+}
+
+typedef struct { int id; double x; } upd_ctx_t;
+
+static void op_update(void *p){
+    upd_ctx_t *c = p;
+    update_drone_position(c->id, 0, c->x, 1.0);
+}
+
+static void op_cycle(void *p){
+    (void)p;
+    artillery_engagement_cycle();
+}
+
+int main(void){
+    log_min_level = LOG_LVL_OFF;
+    artillery_sock = make_udp_socket();
+
+    bench_curve_t upd_last = { "update_drone_position (ultimo)", 0, {0}, {0} };
+    bench_curve_t upd_first = { "update_drone_position (primero)", 0, {0}, {0} };
+    bench_curve_t cyc = { "artillery_engagement_cycle (en zona)", 0, {0}, {0} };
+    for(int s = 0; s < NSIZES; s++){
+        setup_tracks(sizes[s], 10.0);
+        upd_ctx_t last = { sizes[s], 10.0 }, first = { 1, 10.0 };
+        bench_point(&upd_last, sizes[s], bench_measure(op_update, &last));
+        bench_point(&upd_first, sizes[s], bench_measure(op_update, &first));
+
+        setup_tracks(sizes[s], (B + A) / 2);
+        bench_point(&cyc, sizes[s], bench_measure(op_cycle, NULL));
+    }
+    bench_summary(&upd_last);
+    bench_summary(&upd_first);
+    bench_summary(&cyc);
+    return 0;
+}
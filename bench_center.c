@@ -0,0 +1,202 @@
+// bench_center.c - micro-benchmarks de despacho y reasignación del control_center
+// Incluye control_center.c sin su main para medir las funciones internas aisladas.
+#define SIM_NO_MAIN
+#include "control_center.c"
+#include "bench.h"
+
+static int sizes[] = { 16, 64, 256, 1024, 4096 };
+#define NSIZES ((int)(sizeof(sizes)/sizeof(sizes[0])))
+
+static int bench_gid(int swarm, int slot){ return swarm * 100 + slot + 1; }
+
+// Mundo sintético: nswarms swarms completos, despegados (assembled=2)
+static void setup_world(int nswarms){
+    NUM_SWARMS = nswarms;
+    swarm_lo = 0;
+    swarm_hi = nswarms;
+    NUM_TARGETS = nswarms;
+    ASSEMBLY_SIZE = MAX_DRONES_PER_SWARM;
+    free(swarms);
+    swarms = calloc(NUM_SWARMS, sizeof(swarm_t));
+    for(int i = 0; i < NUM_SWARMS; i++){
+        swarms[i].swarm_id = i;
+        swarms[i].truck_id = i;
+        swarms[i].active_count = ASSEMBLY_SIZE;
+        swarms[i].assembled = 2;
+        for(int j = 0; j < ASSEMBLY_SIZE; j++) swarms[i].drone_global_ids[j] = bench_gid(i, j);
+    }
+    build_targets_catalog();
+    for(int i = 0; i < NUM_SWARMS; i++) set_swarm_target(i, i % NUM_TARGETS);
+}
+
+// Deja el swarm con 'count' drones vivos (slots 0..count-1)
+static void set_swarm_count(int i, int count){
+    swarms[i].active_count = count;
+    swarms[i].in_reassembly = 0;
+    swarms[i].is_destroyed = 0;
+    for(int j = 0; j < ASSEMBLY_SIZE; j++){
+        swarms[i].drone_global_ids[j] = (j < count) ? bench_gid(i, j) : 0;
+        swarms[i].drone_terminated[j] = 0;
+    }
+}
+
+// ---------- despacho ----------
+typedef struct { msg_view_t m; char text[MAX_MSG]; struct sockaddr_in from; } dispatch_ctx_t;
+
+static void ctx_text(dispatch_ctx_t *c, const char *text){
+    c->m.text_len = snprintf(c->text, sizeof(c->text), "%s", text);
+    c->m.text = c->text;
+}
+
+static void op_dispatch(void *p){
+    dispatch_ctx_t *c = p;
+    dispatch_message(&c->m, &c->from);
+}
+
+static void bench_dispatch(void){
+    const char *texts[] = { "POS 35.0 12.0", "IN_ASSEMBLY", "LINK_RESTORED" };
+    const char *names[] = { "dispatch STATUS POS", "dispatch STATUS IN_ASSEMBLY", "dispatch STATUS LINK_RESTORED" };
+    for(int t = 0; t < 3; t++){
+        bench_curve_t c = { names[t], 0, {0}, {0} };
+        for(int s = 0; s < NSIZES; s++){
+            setup_world(sizes[s]);
+            dispatch_ctx_t ctx; memset(&ctx,0,sizeof(ctx));
+            ctx.m.type = MSG_STATUS;
+            ctx.m.swarm_id = sizes[s] - 1;
+            ctx.m.drone_id = bench_gid(sizes[s] - 1, 0);
+            ctx_text(&ctx, texts[t]);
+            bench_point(&c, sizes[s], bench_measure(op_dispatch, &ctx));
+        }
+        bench_summary(&c);
+    }
+
+    bench_curve_t c = { "dispatch HELLO (ya registrado)", 0, {0}, {0} };
+    for(int s = 0; s < NSIZES; s++){
+        setup_world(sizes[s]);
+        dispatch_ctx_t ctx; memset(&ctx,0,sizeof(ctx));
+        ctx.m.type = MSG_HELLO;
+        ctx.m.swarm_id = sizes[s] - 1;
+        ctx.m.drone_id = bench_gid(sizes[s] - 1, 4);
+        char hello[64];
+        snprintf(hello, sizeof(hello), "DRONE_HELLO %d PID 1", ctx.m.drone_id);
+        ctx_text(&ctx, hello);
+        bench_point(&c, sizes[s], bench_measure(op_dispatch, &ctx));
+    }
+    bench_summary(&c);
+}
+
+// ---------- remove_drone_from_swarm_by_id ----------
+static void op_remove_last(void *p){
+    (void)p;
+    int last = NUM_SWARMS - 1;
+    int did = bench_gid(last, 4);
+    remove_drone_from_swarm_by_id(did);
+    // restaurar el slot (O(1)) para la siguiente iteración
+    swarms[last].drone_global_ids[4] = did;
+    swarms[last].drone_terminated[4] = 0;
+    swarms[last].active_count++;
+}
+
+static void bench_remove(void){
+    bench_curve_t c = { "remove_drone_from_swarm_by_id (peor)", 0, {0}, {0} };
+    for(int s = 0; s < NSIZES; s++){
+        setup_world(sizes[s]);
+        bench_point(&c, sizes[s], bench_measure(op_remove_last, NULL));
+    }
+    bench_summary(&c);
+}
+
+// ---------- planificador de reconformación ----------
+// Todos los swarms incompletos (3/5): el plan consolida todo el arreglo en un tick
+static void setup_all_partial(void *p){
+    (void)p;
+    for(int i = 0; i < NUM_SWARMS; i++) set_swarm_count(i, 3);
+}
+
+// Un solo par incompleto en extremos opuestos del arreglo
+static void setup_far(void *p){
+    (void)p;
+    for(int i = 0; i < NUM_SWARMS; i++) set_swarm_count(i, ASSEMBLY_SIZE);
+    set_swarm_count(0, 4);
+    set_swarm_count(NUM_SWARMS - 1, 2);
+}
+
+static void op_plan(void *p){
+    (void)p;
+    plan_reassembly();
+}
+
+static void bench_reassign(void){
+    bench_curve_t c1 = { "plan_reassembly (todos 3/5)", 0, {0}, {0} };
+    bench_curve_t c2 = { "plan_reassembly (par lejano)", 0, {0}, {0} };
+    for(int s = 0; s < NSIZES; s++){
+        setup_world(sizes[s]);
+        bench_point(&c1, sizes[s], bench_measure_reset(setup_all_partial, op_plan, NULL));
+        bench_point(&c2, sizes[s], bench_measure_reset(setup_far, op_plan, NULL));
+    }
+    bench_summary(&c1);
+    bench_summary(&c2);
+}
+
+// ---------- asignación de blancos ----------
+static void op_alloc(void *p){
+    (void)p;
+    solve_target_allocation(0);
+}
+
+static void bench_alloc(void){
+    int alloc_sizes[] = { 16, 64, 256, 1024 };
+    bench_curve_t c = { "solve_target_allocation (swarms=blancos)", 0, {0}, {0} };
+    for(int s = 0; s < 4; s++){
+        setup_world(alloc_sizes[s]);
+        alloc_model_init(&alloc_model, VX, B, A, W, ARTILLERY_RATE);
+        for(int i = 0; i < NUM_SWARMS; i++){
+            swarms[i].assembled = 0;
+            swarms[i].pos_x = B;
+            swarms[i].pos_y = 0;
+        }
+        bench_point(&c, alloc_sizes[s], bench_measure(op_alloc, NULL));
+    }
+    bench_summary(&c);
+}
+
+// ---------- búsqueda del mejor blanco (índice espacial) ----------
+static void op_best_target(void *p){
+    (void)p;
+    best_target_for(0);
+}
+
+static void bench_best_target(void){
+    int tsizes[] = { 1024, 4096, 16384, 65536 };
+    bench_curve_t c = { "best_target_for (blancos dispersos)", 0, {0}, {0} };
+    for(int s = 0; s < 4; s++){
+        setup_world(16);
+        alloc_model_init(&alloc_model, VX, B, A, W, ARTILLERY_RATE);
+        targets_free(&targets);
+        srand(1);
+        for(int t = 0; t < tsizes[s]; t++)
+            targets_add(&targets, C + 1000.0 * rand() / RAND_MAX, 1000.0 * rand() / RAND_MAX - 500, 1, ASSEMBLY_SIZE);
+        targets_build_index(&targets);
+        NUM_TARGETS = targets.count;
+        swarms[0].pos_x = C + 500;
+        swarms[0].pos_y = 0;
+        bench_point(&c, tsizes[s], bench_measure(op_best_target, NULL));
+    }
+    bench_summary(&c);
+}
+
+int main(void){
+    // Sin logging ni diario: se mide solo la lógica (los envíos UDP sí se incluyen)
+    log_min_level = LOG_LVL_OFF;
+    BASE_PORT = 20000;
+    sem_init(&sem_swarms, 0, 1);
+    sem_init(&sem_reassign_line, 0, 1);
+    center_sock = make_udp_socket();
+
+    bench_dispatch();
+    bench_remove();
+    bench_reassign();
+    bench_alloc();
+    bench_best_target();
+    return 0;
+}
@@ -0,0 +1,107 @@
+// bench_proto.c - micro-benchmark de serialización y envío/recepción de mensajes
+#include "common.h"
+#include "bench.h"
+#include <fcntl.h>
+
+typedef struct {
+    msg_t m;
+    char buf[MAX_MSG];
+    int len;
+    int tx, rx, rx_port;
+} proto_ctx_t;
+
+static void op_encode(void *p){
+    proto_ctx_t *c = p;
+    msg_encode(&c->m, c->buf, sizeof(c->buf));
+}
+
+static void op_decode(void *p){
+    proto_ctx_t *c = p;
+    msg_t out;
+    msg_decode(c->buf, &out);
+}
+
+// Decodificación en el lugar (el buffer se restaura: msg_parse solo corta en '\n')
+static void op_parse(void *p){
+    proto_ctx_t *c = p;
+    msg_view_t v;
+    msg_parse(c->buf, c->len, &v);
+}
+
+// send_msg + recv_view por loopback, sin copiar a msg_t
+static void op_roundtrip_view(void *p){
+    proto_ctx_t *c = p;
+    msg_view_t v; struct sockaddr_in from;
+    send_msg(c->tx, c->rx_port, &c->m);
+    recv_view(c->rx, &v, &from);
+}
+
+// send_msg + recv_msg por loopback (incluye las dos syscalls)
+static void op_roundtrip(void *p){
+    proto_ctx_t *c = p;
+    msg_t out; struct sockaddr_in from;
+    send_msg(c->tx, c->rx_port, &c->m);
+    recv_msg(c->rx, &out, &from);
+}
+
+// send_msg_reliable + recv_msg (envía el ACK) + recv_msg del emisor (lo consume)
+static void op_reliable(void *p){
+    proto_ctx_t *c = p;
+    msg_t out; struct sockaddr_in from;
+    send_msg_reliable(c->tx, c->rx_port, &c->m);
+    recv_msg(c->rx, &out, &from);
+    recv_msg(c->tx, &out, &from);   // no bloqueante: procesa el ACK y vuelve
+}
+
+int main(void){
+    proto_ctx_t c; memset(&c,0,sizeof(c));
+    c.tx = make_udp_socket();
+    c.rx = make_udp_socket();
+    struct sockaddr_in addr; memset(&addr,0,sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr(HOST);
+    addr.sin_port = 0;
+    if(bind(c.rx,(struct sockaddr*)&addr,sizeof(addr))<0){ perror("bind"); return 1; }
+    socklen_t len = sizeof(addr);
+    getsockname(c.rx,(struct sockaddr*)&addr,&len);
+    c.rx_port = ntohs(addr.sin_port);
+    addr.sin_port = 0;
+    bind(c.tx,(struct sockaddr*)&addr,sizeof(addr));
+    fcntl(c.tx, F_SETFL, fcntl(c.tx, F_GETFL) | O_NONBLOCK);
+
+    bench_curve_t enc = { "msg_encode (largo de texto)", 0, {0}, {0} };
+    bench_curve_t dec = { "msg_decode (largo de texto)", 0, {0}, {0} };
+    bench_curve_t par = { "msg_parse en el lugar (largo de texto)", 0, {0}, {0} };
+    bench_curve_t rt  = { "send_msg+recv_msg loopback", 0, {0}, {0} };
+    bench_curve_t rtv = { "send_msg+recv_view loopback", 0, {0}, {0} };
+    bench_curve_t rel = { "send_msg_reliable+ACK loopback", 0, {0}, {0} };
+
+    int lens[] = { 4, 16, 64, 128, 190 };
+    for(size_t i = 0; i < sizeof(lens)/sizeof(lens[0]); i++){
+        c.m.type = MSG_STATUS;
+        c.m.swarm_id = 12;
+        c.m.drone_id = 1203;
+        memset(c.m.text, 'x', lens[i]);
+        memcpy(c.m.text, "POS ", 4);
+        c.m.text[lens[i]] = 0;
+        c.len = msg_encode(&c.m, c.buf, sizeof(c.buf));
+
+        bench_point(&enc, lens[i], bench_measure(op_encode, &c));
+        bench_point(&dec, lens[i], bench_measure(op_decode, &c));
+        bench_point(&par, lens[i], bench_measure(op_parse, &c));
+        bench_point(&rt,  lens[i], bench_measure(op_roundtrip, &c));
+        bench_point(&rtv, lens[i], bench_measure(op_roundtrip_view, &c));
+        bench_point(&rel, lens[i], bench_measure(op_reliable, &c));
+    }
+    printf("\n");
+    bench_summary(&enc);
+    bench_summary(&dec);
+    bench_summary(&par);
+    bench_summary(&rt);
+    bench_summary(&rtv);
+    bench_summary(&rel);
+    int pending;
+    reliable_stats(&pending, NULL, NULL, NULL);
+    if(pending) printf("ADVERTENCIA: %d mensajes confiables sin ACK\n", pending);
+    return 0;
+}
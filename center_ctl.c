@@ -0,0 +1,87 @@
+// center_ctl.c - cliente del socket de control del centro (CONTROL_SOCKET)
+//   center_ctl [-s socket] [params.txt] [comando ...]
+// Con un comando lo envía y muestra la respuesta; sin comando lee pedidos de la entrada
+// estándar, uno por línea. Sale con 0 si todas las respuestas fueron OK y 1 si alguna
+// fue ERR (que se muestra en stderr).
+#include "common.h"
+#include <sys/un.h>
+
+static int ctl_connect(const char *path){
+    struct sockaddr_un addr; memset(&addr,0,sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(strlen(path) >= sizeof(addr.sun_path)){
+        fprintf(stderr, "center_ctl: ruta de socket demasiado larga: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0){
+        fprintf(stderr, "center_ctl: no se pudo conectar a %s: %s\n", path, strerror(errno));
+        if(fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Envía un pedido y copia la respuesta a stdout hasta la línea final OK/ERR.
+// Devuelve 0 (OK), 1 (ERR) o -1 si el centro cortó la conexión.
+static int ctl_request(int fd, FILE *in, const char *req){
+    char line[1024];
+    int n = snprintf(line, sizeof(line), "%s\n", req);
+    if(n >= (int)sizeof(line) || send(fd, line, n, MSG_NOSIGNAL) != n){
+        fprintf(stderr, "center_ctl: no se pudo enviar el pedido\n");
+        return -1;
+    }
+    while(fgets(line, sizeof(line), in)){
+        if(strcmp(line, "OK\n") == 0) return 0;
+        if(strncmp(line, "ERR", 3) == 0){
+            fputs(line, stderr);
+            return 1;
+        }
+        fputs(line, stdout);
+    }
+    fprintf(stderr, "center_ctl: el centro cerró la conexión\n");
+    return -1;
+}
+
+int main(int argc, char **argv){
+    const char *params = "params.txt";
+    char sock_path[200] = "";
+    int i = 1;
+    if(i + 1 < argc && strcmp(argv[i], "-s") == 0){
+        snprintf(sock_path, sizeof(sock_path), "%s", argv[i + 1]);
+        i += 2;
+    }
+    if(i < argc && access(argv[i], R_OK) == 0) params = argv[i++];
+    if(!sock_path[0] && !params_get_string(params, "CONTROL_SOCKET", sock_path, sizeof(sock_path))){
+        fprintf(stderr, "Uso: center_ctl [-s socket] [params.txt] [comando ...]\n"
+                        "CONTROL_SOCKET no está configurado en %s\n", params);
+        return 2;
+    }
+
+    int fd = ctl_connect(sock_path);
+    if(fd < 0) return 2;
+    FILE *in = fdopen(dup(fd), "r");
+    if(!in){ perror("fdopen"); return 2; }
+
+    int rc = 0;
+    if(i < argc){
+        char req[512] = "";
+        for(size_t len = 0; i < argc; i++)
+            len += snprintf(req + len, len < sizeof(req) ? sizeof(req) - len : 0, "%s%s",
+                            len ? " " : "", argv[i]);
+        rc = ctl_request(fd, in, req);
+    } else {
+        char line[512];
+        while(fgets(line, sizeof(line), stdin)){
+            line[strcspn(line, "\r\n")] = 0;
+            if(!line[0] || line[0] == '#') continue;
+            int r = ctl_request(fd, in, line);
+            if(r < 0){ rc = r; break; }
+            if(r > 0) rc = 1;
+        }
+    }
+    fclose(in);
+    close(fd);
+    return rc < 0 ? 2 : rc;
+}
@@ -0,0 +1,212 @@
+// checkpoint.c - escritura/lectura de instantáneas y su hilo periódico
+#include "checkpoint.h"
+#include "common.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME  16777619u
+
+static void out_flush(ckpt_out_t *o){
+    size_t off = 0;
+    while(off < o->used && !o->failed){
+        ssize_t w = write(o->fd, o->buf + off, o->used - off);
+        if(w < 0){
+            if(errno == EINTR) continue;
+            o->failed = 1;
+        } else off += w;
+    }
+    o->used = 0;
+}
+
+void ckpt_put(ckpt_out_t *o, const void *p, size_t len){
+    const unsigned char *s = p;
+    for(size_t i = 0; i < len; i++) o->checksum = (o->checksum ^ s[i]) * FNV_PRIME;
+    o->length += len;
+    while(len > 0 && !o->failed){
+        size_t n = sizeof(o->buf) - o->used;
+        if(n > len) n = len;
+        memcpy(o->buf + o->used, s, n);
+        o->used += n;
+        s += n;
+        len -= n;
+        if(o->used == sizeof(o->buf)) out_flush(o);
+    }
+}
+
+// Solo open/write/rename: se llama también desde el hijo del fork
+static int write_file(const char *tmp, const char *path, ckpt_kind_t kind, ckpt_emit_fn emit, void *arg){
+    ckpt_out_t o;
+    o.fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(o.fd < 0) return -1;
+    o.failed = 0;
+    o.checksum = FNV_OFFSET;
+    o.length = 0;
+    o.used = 0;
+
+    ckpt_header_t h = { CKPT_MAGIC, CKPT_VERSION, kind, 0, 0, (int64_t)time(NULL) };
+    if(write(o.fd, &h, sizeof(h)) != (ssize_t)sizeof(h)) o.failed = 1;
+    emit(&o, arg);
+    out_flush(&o);
+    h.checksum = o.checksum;
+    h.length = o.length;
+    if(!o.failed && pwrite(o.fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h)) o.failed = 1;
+    if(close(o.fd) < 0) o.failed = 1;
+    if(o.failed || rename(tmp, path) < 0){
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+// El temporal lleva el pid y un número de escritura: dos escritores del mismo nombre
+// (dos procesos, o dos hilos de uno) nunca comparten archivo a medio escribir
+static int ckpt_paths(const char *dir, const char *name, char *tmp, char *path, size_t len){
+    static unsigned seq = 0;
+    unsigned n = __atomic_fetch_add(&seq, 1, __ATOMIC_RELAXED);
+    if(snprintf(path, len, "%s/%s", dir, name) >= (int)len ||
+       snprintf(tmp, len, "%s/%s.%d.%u.tmp", dir, name, (int)getpid(), n) >= (int)len){
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    return 0;
+}
+
+int ckpt_write(const char *dir, const char *name, ckpt_kind_t kind, ckpt_emit_fn emit, void *arg){
+    char tmp[512], path[512];
+    if(ckpt_paths(dir, name, tmp, path, sizeof(path)) < 0) return -1;
+    return write_file(tmp, path, kind, emit, arg);
+}
+
+// Una escritura con fork a la vez por proceso (hilo periódico y pedidos del operador):
+// el rename de una instantánea vieja no puede pisar a una más nueva
+static pthread_mutex_t forked_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int ckpt_write_forked(const char *dir, const char *name, ckpt_kind_t kind,
+                      void (*lock)(void), void (*unlock)(void), ckpt_emit_fn emit, void *arg){
+    char tmp[512], path[512];
+    if(ckpt_paths(dir, name, tmp, path, sizeof(path)) < 0) return -1;
+    pthread_mutex_lock(&forked_lock);
+    lock();
+    pid_t pid = fork();
+    unlock();
+    if(pid < 0){
+        pthread_mutex_unlock(&forked_lock);
+        return -1;
+    }
+    if(pid == 0) _exit(write_file(tmp, path, kind, emit, arg) < 0 ? 1 : 0);
+
+    int status, rc = 0;
+    while(waitpid(pid, &status, 0) < 0)
+        if(errno != EINTR){ rc = -1; break; }
+    if(rc == 0 && (!WIFEXITED(status) || WEXITSTATUS(status) != 0)){
+        errno = EIO;
+        rc = -1;
+    }
+    pthread_mutex_unlock(&forked_lock);
+    return rc;
+}
+
+void *ckpt_read(const char *dir, const char *name, ckpt_kind_t kind, size_t *len, int64_t *written_at){
+    char path[512];
+    if(snprintf(path, sizeof(path), "%s/%s", dir, name) >= (int)sizeof(path)) return NULL;
+    FILE *f = fopen(path, "rb");
+    if(!f) return NULL;
+    ckpt_header_t h;
+    char *data = NULL;
+    if(fread(&h, sizeof(h), 1, f) == 1 && h.magic == CKPT_MAGIC && h.version == CKPT_VERSION &&
+       h.kind == (uint32_t)kind && h.length < ((uint64_t)1 << 32) &&
+       (data = malloc(h.length ? h.length : 1)) != NULL &&
+       fread(data, 1, h.length, f) == h.length){
+        uint32_t sum = FNV_OFFSET;
+        for(uint64_t i = 0; i < h.length; i++) sum = (sum ^ (unsigned char)data[i]) * FNV_PRIME;
+        if(sum == h.checksum){
+            fclose(f);
+            *len = h.length;
+            if(written_at) *written_at = h.written_at;
+            return data;
+        }
+    }
+    free(data);
+    fclose(f);
+    errno = EINVAL;
+    return NULL;
+}
+
+int ckpt_get(ckpt_in_t *in, void *dst, size_t len){
+    if(in->left < len) return -1;
+    memcpy(dst, in->p, len);
+    in->p += len;
+    in->left -= len;
+    return 0;
+}
+
+int ckpt_config(const char *params_path, char *dir, size_t dirlen, int *secs){
+    char v[16];
+    *secs = params_get_string(params_path, "CHECKPOINT_SECS", v, sizeof(v)) && atoi(v) > 0 ? atoi(v) : 30;
+    if(!params_get_string(params_path, "CHECKPOINT_DIR", dir, dirlen)) return 0;
+    mkdir(dir, 0755);   // si ya existe, bien; si no se puede, fallará la escritura
+    return 1;
+}
+
+// Un solo hilo por proceso. Los pedidos de ckpt_request lo despiertan antes de tiempo:
+// la escritura sale de este hilo y no del que la pidió, y reinicia el período.
+static pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timer_cond;
+static int timer_secs = 0;
+static int (*timer_tick)(void) = NULL;
+static void (*req_done)(int rc, void *arg) = NULL;
+static void *req_arg = NULL;
+
+static void *ckpt_thread(void *arg){
+    (void)arg;
+    pthread_mutex_lock(&timer_lock);
+    for(;;){
+        struct timespec due;
+        clock_gettime(CLOCK_MONOTONIC, &due);
+        due.tv_sec += timer_secs;
+        while(!req_done && pthread_cond_timedwait(&timer_cond, &timer_lock, &due) != ETIMEDOUT) {}
+        void (*done)(int, void *) = req_done;
+        void *done_arg = req_arg;
+        req_done = NULL;
+        pthread_mutex_unlock(&timer_lock);
+        int rc = timer_tick();
+        if(done) done(rc, done_arg);
+        pthread_mutex_lock(&timer_lock);
+    }
+    return NULL;
+}
+
+int ckpt_start(int secs, int (*tick)(void)){
+    pthread_mutex_lock(&timer_lock);
+    if(timer_tick){
+        pthread_mutex_unlock(&timer_lock);
+        return -1;
+    }
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&timer_cond, &ca);
+    pthread_condattr_destroy(&ca);
+    timer_secs = secs;
+    timer_tick = tick;
+    pthread_t th;
+    int rc = sim_thread_create(&th, ckpt_thread, NULL);
+    if(rc == 0) pthread_detach(th);
+    else timer_tick = NULL;
+    pthread_mutex_unlock(&timer_lock);
+    return rc == 0 ? 0 : -1;
+}
+
+int ckpt_request(void (*done)(int rc, void *arg), void *arg){
+    pthread_mutex_lock(&timer_lock);
+    int rc = -1;
+    if(timer_tick && !req_done){
+        req_done = done;
+        req_arg = arg;
+        pthread_cond_signal(&timer_cond);
+        rc = 0;
+    }
+    pthread_mutex_unlock(&timer_lock);
+    return rc;
+}
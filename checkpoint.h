@@ -0,0 +1,65 @@
+// checkpoint.h - instantáneas binarias del estado de la misión (CHECKPOINT_DIR)
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Archivo: cabecera fija + carga útil propia de cada proceso. Se escribe en un temporal
+// propio de cada escritura (<nombre>.<pid>.<n>.tmp) y se renombra: una caída a mitad de
+// escritura deja intacta la instantánea anterior.
+#define CKPT_MAGIC   0x4b434452u   // "RDCK"
+#define CKPT_VERSION 1
+
+typedef enum { CKPT_CENTER = 1, CKPT_ARTILLERY, CKPT_DRONE } ckpt_kind_t;
+
+typedef struct {
+    uint32_t magic, version, kind;
+    uint32_t checksum;      // FNV-1a de la carga útil
+    uint64_t length;        // bytes de carga útil
+    int64_t written_at;     // time() al escribir
+} ckpt_header_t;
+
+// Salida secuencial con buffer propio: no reserva memoria, se puede usar en el hijo
+// de un fork() de un proceso con varios hilos
+typedef struct {
+    int fd, failed;
+    uint32_t checksum;
+    uint64_t length;
+    size_t used;
+    char buf[8192];
+} ckpt_out_t;
+
+void ckpt_put(ckpt_out_t *o, const void *p, size_t len);
+
+typedef void (*ckpt_emit_fn)(ckpt_out_t *o, void *arg);
+
+// Escribe dir/name con lo que vuelque emit; 0 o -1 (errno)
+int ckpt_write(const char *dir, const char *name, ckpt_kind_t kind, ckpt_emit_fn emit, void *arg);
+
+// Igual, pero escribe un hijo de fork() sobre su copia copy-on-write de la memoria:
+// lock()/unlock() rodean solo al fork (el estado queda consistente y el proceso no se
+// detiene mientras se escribe). Las escrituras con fork de un proceso no se solapan: una
+// segunda espera a que la primera termine. Espera al hijo; 0 o -1.
+int ckpt_write_forked(const char *dir, const char *name, ckpt_kind_t kind,
+                      void (*lock)(void), void (*unlock)(void), ckpt_emit_fn emit, void *arg);
+
+// Carga útil verificada (magia, versión, tipo, largo y checksum) en memoria reservada
+// (free del llamador); NULL si no existe o no es válida
+void *ckpt_read(const char *dir, const char *name, ckpt_kind_t kind, size_t *len, int64_t *written_at);
+
+typedef struct { const char *p; size_t left; } ckpt_in_t;
+int ckpt_get(ckpt_in_t *in, void *dst, size_t len);   // 0, o -1 si la carga útil no alcanza
+
+// CHECKPOINT_DIR (0 si no está: sin instantáneas; lo crea si falta) y CHECKPOINT_SECS
+// (30 por defecto)
+int ckpt_config(const char *params_path, char *dir, size_t dirlen, int *secs);
+
+// Hilo de fondo que llama tick() cada secs segundos (tick devuelve 0 o -1)
+int ckpt_start(int secs, int (*tick)(void));
+
+// Pide al hilo de ckpt_start un tick ya; al terminar, desde ese hilo, llama done con lo
+// que devolvió tick. Un pedido pendiente a la vez: -1 si hay otro o el hilo no corre.
+int ckpt_request(void (*done)(int rc, void *arg), void *arg);
+
+#endif
@@ -1,5 +1,9 @@
 // common.c
 #include "common.h"
+#include <stdint.h>
+#include <poll.h>
+#include <semaphore.h>
+#include <linux/sock_diag.h>
 
 int make_udp_socket(){
     int s = socket(AF_INET, SOCK_DGRAM, 0);
@@ -9,39 +13,704 @@ int make_udp_socket(){
     return s;
 }
 
-int send_msg(int sock, int port, msg_t *m){
+// simple serialization: type|swarm|drone|seq|text
+int msg_encode(const msg_t *m, char *buf, size_t len){
+    int n = snprintf(buf, len, "%d|%d|%d|%u|%s", (int)m->type, m->swarm_id, m->drone_id, m->seq, m->text);
+    if(n >= (int)len) n = len - 1;
+    return n;
+}
+
+// Decodifica en el lugar: buf[len] debe ser NUL. Corta el texto en el primer '\n'
+// y deja v->text apuntando dentro de buf (sin copias)
+int msg_parse(char *buf, int len, msg_view_t *v){
+    char *p = buf, *end;
+    long f[3];
+    for(int i = 0; i < 3; i++){
+        f[i] = strtol(p, &end, 10);
+        if(end == p || *end != '|') return -1;
+        p = end + 1;
+    }
+    unsigned long q = strtoul(p, &end, 10);
+    if(end == p || (*end != '|' && *end != 0)) return -1;
+    p = *end ? end + 1 : end;
+    char *stop = memchr(p, '\n', buf + len - p);
+    if(stop) *stop = 0;
+    else stop = buf + len;
+    v->type = (msg_type_t)f[0];
+    v->swarm_id = (int)f[1];
+    v->drone_id = (int)f[2];
+    v->seq = (unsigned)q;
+    v->text = p;
+    v->text_len = (int)(stop - p);
+    return 0;
+}
+
+// Copia una vista a un msg_t (texto truncado a text[200])
+static void msg_from_view(const msg_view_t *v, msg_t *m){
+    int n = v->text_len < (int)sizeof(m->text) - 1 ? v->text_len : (int)sizeof(m->text) - 1;
+    m->type = v->type;
+    m->swarm_id = v->swarm_id;
+    m->drone_id = v->drone_id;
+    m->seq = v->seq;
+    memcpy(m->text, v->text, n);
+    m->text[n] = 0;
+}
+
+int msg_decode(const char *buf, msg_t *m){
+    char tmp[MAX_MSG];
+    int len = strlen(buf);
+    if(len >= MAX_MSG) len = MAX_MSG - 1;
+    memcpy(tmp, buf, len);
+    tmp[len] = 0;
+    msg_view_t v;
+    if(msg_parse(tmp, len, &v) < 0) return -1;
+    msg_from_view(&v, m);
+    return 0;
+}
+
+static int send_raw(int sock, int port, const char *buf, int n){
     struct sockaddr_in to; memset(&to,0,sizeof(to));
     to.sin_family = AF_INET;
-    to.sin_addr.s_addr = inet_addr(HOST);
+    to.sin_addr.s_addr = net_addr_for_port(port);
     to.sin_port = htons(port);
+    return sendto(sock, buf, n, 0, (struct sockaddr*)&to, sizeof(to));
+}
+
+int send_datagram(int sock, int port, const char *buf, int n){
+    return send_raw(sock, port, buf, n);
+}
+
+// Envío sin confirmación (telemetría, ecos): seq 0 aunque m venga de un envío confiable
+int send_msg(int sock, int port, msg_t *m){
+    char buf[MAX_MSG];
+    m->seq = 0;
+    int n = msg_encode(m, buf, sizeof(buf));
+    return send_raw(sock, port, buf, n);
+}
+
+int send_view(int sock, int port, const msg_view_t *v){
     char buf[MAX_MSG];
-    // simple serialization: type|swarm|drone|text
-    int n = snprintf(buf,sizeof(buf),"%d|%d|%d|%s", (int)m->type, m->swarm_id, m->drone_id, m->text);
-    int res = sendto(sock, buf, n, 0, (struct sockaddr*)&to, sizeof(to));
-    if(res<0){ /*perror("sendto");*/ }
+    int n = snprintf(buf, sizeof(buf), "%d|%d|%d|0|%.*s", (int)v->type, v->swarm_id, v->drone_id,
+                     v->text_len, v->text);
+    if(n >= (int)sizeof(buf)) n = sizeof(buf) - 1;
+    return send_raw(sock, port, buf, n);
+}
+
+// ---------- entrega confiable ----------
+// Estado por puerto par: próximo seq a enviarle y ventana de seqs recibidos de él
+typedef struct {
+    int port;               // 0 = libre
+    unsigned tx_seq;
+    unsigned rx_max;
+    uint64_t rx_mask;       // bit i: se recibió rx_max - i
+} rel_peer_t;
+
+typedef struct {
+    int sock, port;
+    unsigned seq;
+    int tries;
+    double next;            // reloj monotónico del próximo reintento
+    int len;
+    char buf[MAX_MSG];
+} rel_pending_t;
+
+static sem_t rel_lock;
+static pthread_once_t rel_once = PTHREAD_ONCE_INIT;
+static rel_peer_t *rel_peers = NULL;
+static int rel_peers_cap = 0, rel_peers_n = 0;
+static rel_pending_t *rel_pending = NULL;
+static int rel_pending_n = 0, rel_pending_cap = 0;
+// Índice (port, seq) -> posición+1 en rel_pending (0 = libre), direccionamiento abierto
+// con el doble de lugares que rel_pending_cap: un ACK no recorre la tabla
+static int *rel_index = NULL;
+static unsigned rel_index_mask = 0;
+static unsigned long rel_retx = 0, rel_dropped = 0, rel_dups = 0;
+
+static void rel_init(void){ sem_init(&rel_lock, 0, 1); }
+
+static double rel_now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static rel_peer_t *rel_peer_slot(rel_peer_t *tab, int cap, int port){
+    unsigned h = ((unsigned)port * 2654435761u) & (unsigned)(cap - 1);
+    while(tab[h].port != 0 && tab[h].port != port) h = (h + 1) & (unsigned)(cap - 1);
+    return &tab[h];
+}
+
+// Par de un puerto, creado si no existe (con rel_lock tomado)
+static rel_peer_t *rel_peer(int port){
+    if(2 * (rel_peers_n + 1) > rel_peers_cap){
+        int cap = rel_peers_cap ? rel_peers_cap * 2 : 64;
+        rel_peer_t *tab = calloc(cap, sizeof(rel_peer_t));
+        if(!tab) return NULL;
+        for(int i = 0; i < rel_peers_cap; i++)
+            if(rel_peers[i].port) *rel_peer_slot(tab, cap, rel_peers[i].port) = rel_peers[i];
+        free(rel_peers);
+        rel_peers = tab;
+        rel_peers_cap = cap;
+    }
+    rel_peer_t *p = rel_peer_slot(rel_peers, rel_peers_cap, port);
+    if(p->port == 0){
+        p->port = port;
+        // inicio distinto por proceso: un par reiniciado no choca con la ventana vieja
+        p->tx_seq = ((unsigned)getpid() * 2654435761u) ^ ((unsigned)port << 16) ^ (unsigned)time(NULL);
+        rel_peers_n++;
+    }
+    return p;
+}
+
+// 1 si (port, seq) es nuevo; lo registra en la ventana del emisor
+static int rel_accept(int port, unsigned seq){
+    pthread_once(&rel_once, rel_init);
+    sem_wait(&rel_lock);
+    rel_peer_t *p = rel_peer(port);
+    int fresh = 1;
+    if(!p){
+        // sin memoria para la ventana: se acepta (a lo sumo un duplicado)
+    } else if(p->rx_mask == 0){
+        p->rx_max = seq;
+        p->rx_mask = 1;
+    } else {
+        int d = (int)(seq - p->rx_max);
+        if(d > 0){
+            p->rx_mask = d >= 64 ? 1 : (p->rx_mask << d) | 1;
+            p->rx_max = seq;
+        } else if(d <= -RELIABLE_WINDOW){
+            // muy anterior a la ventana: el emisor se reinició con otro inicio
+            p->rx_max = seq;
+            p->rx_mask = 1;
+        } else if(p->rx_mask & (1ull << -d)){
+            fresh = 0;
+            rel_dups++;
+        } else {
+            p->rx_mask |= 1ull << -d;
+        }
+    }
+    sem_post(&rel_lock);
+    return fresh;
+}
+
+static unsigned rel_index_home(int port, unsigned seq){
+    return (((unsigned)port * 2654435761u) ^ (seq * 0x9E3779B1u)) & rel_index_mask;
+}
+
+// Lugar del índice con (port, seq) o el libre donde iría (con rel_lock tomado)
+static unsigned rel_index_slot(int port, unsigned seq){
+    unsigned h = rel_index_home(port, seq);
+    while(rel_index[h]){
+        rel_pending_t *e = &rel_pending[rel_index[h] - 1];
+        if(e->port == port && e->seq == seq) break;
+        h = (h + 1) & rel_index_mask;
+    }
+    return h;
+}
+
+// Saca el pendiente i: borrado con corrimiento hacia atrás en el índice y el último
+// del arreglo pasa a ocupar su lugar (con rel_lock tomado)
+static void rel_pending_remove(int i){
+    unsigned h = rel_index_slot(rel_pending[i].port, rel_pending[i].seq);
+    for(unsigned j = (h + 1) & rel_index_mask; rel_index[j]; j = (j + 1) & rel_index_mask){
+        rel_pending_t *e = &rel_pending[rel_index[j] - 1];
+        unsigned k = rel_index_home(e->port, e->seq);
+        // se mueve a h salvo que su lugar natural quede entre h (excluido) y j
+        if(((j - k) & rel_index_mask) >= ((j - h) & rel_index_mask)){
+            rel_index[h] = rel_index[j];
+            h = j;
+        }
+    }
+    rel_index[h] = 0;
+    if(i != --rel_pending_n){
+        rel_pending[i] = rel_pending[rel_pending_n];
+        rel_index[rel_index_slot(rel_pending[i].port, rel_pending[i].seq)] = i + 1;
+    }
+}
+
+static void rel_acked(int port, unsigned seq){
+    pthread_once(&rel_once, rel_init);
+    sem_wait(&rel_lock);
+    if(rel_pending_n > 0){
+        unsigned h = rel_index_slot(port, seq);
+        if(rel_index[h]) rel_pending_remove(rel_index[h] - 1);
+    }
+    sem_post(&rel_lock);
+}
+
+// Lugar para 'extra' pendientes más (con rel_lock tomado); 0 si no hay memoria
+static int rel_pending_reserve(int extra){
+    if(rel_pending_n + extra <= rel_pending_cap) return 1;
+    int cap = rel_pending_cap ? rel_pending_cap : 64;
+    while(cap < rel_pending_n + extra) cap *= 2;
+    rel_pending_t *q = realloc(rel_pending, cap * sizeof(rel_pending_t));
+    if(!q) return 0;
+    rel_pending = q;
+    int *idx = calloc(2 * cap, sizeof(int));
+    if(!idx) return 0;
+    free(rel_index);
+    rel_index = idx;
+    rel_index_mask = 2 * cap - 1;
+    rel_pending_cap = cap;
+    for(int i = 0; i < rel_pending_n; i++)
+        rel_index[rel_index_slot(rel_pending[i].port, rel_pending[i].seq)] = i + 1;
+    return 1;
+}
+
+// Próximo seq de un espacio (con rel_lock tomado): los envíos a un puerto usan
+// 31 bits y los de grupo llevan además RELIABLE_GROUP_BIT
+static unsigned rel_next_seq(rel_peer_t *p, unsigned space){
+    p->tx_seq = (p->tx_seq + 1) & ~RELIABLE_GROUP_BIT;
+    if(p->tx_seq == 0) p->tx_seq = 1;
+    return p->tx_seq | space;
+}
+
+static void rel_pending_add(int sock, int port, unsigned seq, const char *buf, int len, double now){
+    rel_pending_t *e = &rel_pending[rel_pending_n++];
+    e->sock = sock;
+    e->port = port;
+    e->seq = seq;
+    e->tries = 1;
+    e->next = now + RELIABLE_RTO_MS / 1000.0;
+    e->len = len;
+    memcpy(e->buf, buf, len + 1);
+    rel_index[rel_index_slot(port, seq)] = rel_pending_n;
+}
+
+int send_msg_reliable(int sock, int port, msg_t *m){
+    pthread_once(&rel_once, rel_init);
+    sem_wait(&rel_lock);
+    rel_peer_t *p = rel_peer(port);
+    if(!p || !rel_pending_reserve(1)){
+        sem_post(&rel_lock);
+        m->seq = 0;
+        return send_msg(sock, port, m);   // sin memoria: mejor esfuerzo
+    }
+    m->seq = rel_next_seq(p, 0);
+    char buf[MAX_MSG];
+    int len = msg_encode(m, buf, sizeof(buf));
+    rel_pending_add(sock, port, m->seq, buf, len, rel_now());
+    int res = send_raw(sock, port, buf, len);
+    sem_post(&rel_lock);
     return res;
 }
 
-int recv_msg(int sock, msg_t *m, struct sockaddr_in *from){
+// ---------- grupos multicast por swarm ----------
+// 239.1.x.y con x.y = swarm, todos en el mismo puerto; cada socket de grupo recibe
+// solo los grupos a los que se unió (IP_MULTICAST_ALL=0)
+static in_addr_t swarm_group_addr(int swarm){
+    return htonl(0xEF010000u | ((unsigned)swarm & 0xFFFFu));
+}
+
+int port_for_swarm_group(int base){ return base + 3; }
+
+// Socket por el que se confirma lo recibido en cada descriptor (+1; 0 = el mismo)
+#define SOCK_TRACK_FDS 1024
+static int sock_ack_via[SOCK_TRACK_FDS];
+
+static int group_membership(int fd, int swarm, int opt){
+    struct ip_mreq mr;
+    mr.imr_multiaddr.s_addr = swarm_group_addr(swarm);
+    mr.imr_interface.s_addr = inet_addr(HOST);
+    return setsockopt(fd, IPPROTO_IP, opt, &mr, sizeof(mr));
+}
+
+int group_open(int base, int swarm, int ack_sock){
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(fd < 0) return -1;
+    int on = 1, off = 0;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_ALL, &off, sizeof(off));
+    struct sockaddr_in a; memset(&a,0,sizeof(a));
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(INADDR_ANY);
+    a.sin_port = htons(port_for_swarm_group(base));
+    if(bind(fd, (struct sockaddr*)&a, sizeof(a)) < 0 || group_membership(fd, swarm, IP_ADD_MEMBERSHIP) < 0 ||
+       fd >= SOCK_TRACK_FDS){
+        close(fd);
+        return -1;
+    }
+    sock_ack_via[fd] = ack_sock + 1;
+    return fd;
+}
+
+int group_move(int fd, int old_swarm, int new_swarm){
+    if(fd < 0 || old_swarm == new_swarm) return 0;
+    group_membership(fd, old_swarm, IP_DROP_MEMBERSHIP);
+    return group_membership(fd, new_swarm, IP_ADD_MEMBERSHIP);
+}
+
+// Prueba (una vez por proceso) que un datagrama multicast por loopback vuelve
+static int group_ok = -1, group_disabled = 0;
+static pthread_once_t group_once = PTHREAD_ONCE_INIT;
+
+static void group_probe(void){
+    group_ok = 0;
+    int rx = socket(AF_INET, SOCK_DGRAM, 0), tx = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in a; memset(&a,0,sizeof(a));
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(INADDR_ANY);
+    socklen_t len = sizeof(a);
+    if(rx >= 0 && tx >= 0 && bind(rx, (struct sockaddr*)&a, sizeof(a)) == 0 &&
+       getsockname(rx, (struct sockaddr*)&a, &len) == 0){
+        struct ip_mreq mr;
+        mr.imr_multiaddr.s_addr = inet_addr("239.2.0.1");
+        mr.imr_interface.s_addr = inet_addr(HOST);
+        struct in_addr lo; lo.s_addr = inet_addr(HOST);
+        unsigned char loop = 1;
+        a.sin_addr = mr.imr_multiaddr;
+        if(setsockopt(rx, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mr, sizeof(mr)) == 0 &&
+           setsockopt(tx, IPPROTO_IP, IP_MULTICAST_IF, &lo, sizeof(lo)) == 0 &&
+           setsockopt(tx, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) == 0 &&
+           sendto(tx, "?", 1, 0, (struct sockaddr*)&a, sizeof(a)) == 1){
+            struct pollfd pfd = { rx, POLLIN, 0 };
+            group_ok = poll(&pfd, 1, 200) > 0;
+        }
+    }
+    if(rx >= 0) close(rx);
+    if(tx >= 0) close(tx);
+}
+
+int group_available(const char *params_path){
+    char v[16];
+    if(params_path && params_get_string(params_path, "SWARM_MULTICAST", v, sizeof(v)) && atoi(v) == 0)
+        group_disabled = 1;
+    if(group_disabled) return 0;
+    pthread_once(&group_once, group_probe);
+    return group_ok;
+}
+
+// Un datagrama al grupo multicast del swarm por loopback
+static int group_sendto(int sock, int base, int swarm, const char *buf, int len){
+    struct in_addr lo; lo.s_addr = inet_addr(HOST);
+    unsigned char loop = 1;
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, &lo, sizeof(lo));
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+    struct sockaddr_in to; memset(&to,0,sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = swarm_group_addr(swarm);
+    to.sin_port = htons(port_for_swarm_group(base));
+    return sendto(sock, buf, len, 0, (struct sockaddr*)&to, sizeof(to));
+}
+
+int send_msg_group(int sock, int base, int swarm, const int *members, int n, msg_t *m){
+    if(n <= 0) return 0;
+    pthread_once(&group_once, group_probe);
+    pthread_once(&rel_once, rel_init);
+    sem_wait(&rel_lock);
+    rel_peer_t *p = group_ok > 0 && !group_disabled ? rel_peer(-(swarm + 1)) : NULL;
+    if(!p || !rel_pending_reserve(n)){
+        sem_post(&rel_lock);
+        // sin multicast: un envío confiable por integrante
+        for(int i = 0; i < n; i++) send_msg_reliable(sock, port_for_drone(base, members[i]), m);
+        return n;
+    }
+    m->seq = rel_next_seq(p, RELIABLE_GROUP_BIT);
+    char buf[MAX_MSG];
+    int len = msg_encode(m, buf, sizeof(buf));
+    // un pendiente por integrante: el que no confirme recibe reintentos por unicast
+    double now = rel_now();
+    for(int i = 0; i < n; i++) rel_pending_add(sock, port_for_drone(base, members[i]), m->seq, buf, len, now);
+    sem_post(&rel_lock);
+    return group_sendto(sock, base, swarm, buf, len);
+}
+
+int send_msg_group_unreliable(int sock, int base, int swarm, const int *members, int n, msg_t *m){
+    if(n <= 0) return 0;
+    pthread_once(&group_once, group_probe);
+    if(group_ok <= 0 || group_disabled){
+        for(int i = 0; i < n; i++) send_msg(sock, port_for_drone(base, members[i]), m);
+        return n;
+    }
     char buf[MAX_MSG];
-    socklen_t fromlen = sizeof(struct sockaddr_in);
-    int r = recvfrom(sock, buf, sizeof(buf)-1, 0, (struct sockaddr*)from, &fromlen);
-    if(r<=0) return r;
-    buf[r]=0;
-    // parse
-    int t, s, d;
-    char txt[200];
-    if(sscanf(buf,"%d|%d|%d|%199[^\n]", &t, &s, &d, txt) >= 3){
-        m->type = (msg_type_t)t;
-        m->swarm_id = s;
-        m->drone_id = d;
-        if(strlen(txt)) strncpy(m->text, txt, sizeof(m->text)-1);
+    m->seq = 0;
+    int len = msg_encode(m, buf, sizeof(buf));
+    return group_sendto(sock, base, swarm, buf, len);
+}
+
+int reliable_tick(void){
+    pthread_once(&rel_once, rel_init);
+    sem_wait(&rel_lock);
+    double now = rel_now(), next = -1;
+    for(int i = 0; i < rel_pending_n; ){
+        rel_pending_t *e = &rel_pending[i];
+        if(e->next <= now){
+            if(e->tries >= RELIABLE_MAX_TRIES){
+                fprintf(stderr, "[RELIABLE] sin ACK del puerto %d tras %d intentos: %s\n",
+                        e->port, e->tries, e->buf);
+                rel_dropped++;
+                rel_pending_remove(i);
+                continue;
+            }
+            send_raw(e->sock, e->port, e->buf, e->len);
+            rel_retx++;
+            int rto = RELIABLE_RTO_MS << e->tries;
+            if(rto > RELIABLE_MAX_RTO_MS) rto = RELIABLE_MAX_RTO_MS;
+            e->tries++;
+            e->next = now + rto / 1000.0;
+        }
+        if(next < 0 || e->next < next) next = e->next;
+        i++;
     }
+    sem_post(&rel_lock);
+    if(next < 0) return -1;
+    int ms = (int)((next - now) * 1000) + 1;
+    return ms > 0 ? ms : 0;
+}
+
+static void *reliable_thread(void *arg){
+    (void)arg;
+    while(1){
+        int ms = reliable_tick();
+        usleep((ms < 0 || ms > 50 ? 50 : ms) * 1000);
+    }
+    return NULL;
+}
+
+void reliable_start(void){
+    pthread_t t;
+    if(sim_thread_create(&t, reliable_thread, NULL) == 0) pthread_detach(t);
+}
+
+static int rel_pending_for(int sock){
+    int n = 0;
+    sem_wait(&rel_lock);
+    for(int i = 0; i < rel_pending_n; i++) if(rel_pending[i].sock == sock) n++;
+    sem_post(&rel_lock);
+    return n;
+}
+
+void reliable_flush(int sock, int timeout_ms){
+    pthread_once(&rel_once, rel_init);
+    double end = rel_now() + timeout_ms / 1000.0;
+    msg_view_t v; struct sockaddr_in from;
+    while(rel_pending_for(sock) > 0 && rel_now() < end){
+        int ms = reliable_tick();
+        if(ms < 0 || ms > 10) ms = 10;
+        struct pollfd pfd = { sock, POLLIN, 0 };
+        if(poll(&pfd, 1, ms) > 0) recv_view(sock, &v, &from);
+    }
+}
+
+void reliable_stats(int *pending, unsigned long *retransmits, unsigned long *dropped, unsigned long *duplicates){
+    pthread_once(&rel_once, rel_init);
+    sem_wait(&rel_lock);
+    if(pending) *pending = rel_pending_n;
+    if(retransmits) *retransmits = rel_retx;
+    if(dropped) *dropped = rel_dropped;
+    if(duplicates) *duplicates = rel_dups;
+    sem_post(&rel_lock);
+}
+
+// Último contador de descartes (SO_RXQ_OVFL) visto en cada descriptor
+static unsigned sock_ovfl[SOCK_TRACK_FDS];
+
+// Buffer de recepción de cada hilo: las vistas de recv_view apuntan aquí
+static __thread char rx_buf[MAX_DGRAM];
+
+int recv_view(int sock, msg_view_t *m, struct sockaddr_in *from){
+    char cbuf[CMSG_SPACE(sizeof(uint32_t))];
+    for(;;){
+        struct iovec iov = { rx_buf, sizeof(rx_buf)-1 };
+        struct msghdr mh; memset(&mh,0,sizeof(mh));
+        mh.msg_name = from;
+        mh.msg_namelen = sizeof(struct sockaddr_in);
+        mh.msg_iov = &iov;
+        mh.msg_iovlen = 1;
+        mh.msg_control = cbuf;
+        mh.msg_controllen = sizeof(cbuf);
+        int r = recvmsg(sock, &mh, 0);
+        if(r<=0) return r;
+        // el kernel adjunta el total de datagramas descartados si SO_RXQ_OVFL está activo
+        for(struct cmsghdr *c = CMSG_FIRSTHDR(&mh); c; c = CMSG_NXTHDR(&mh, c)){
+            if(c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_RXQ_OVFL && sock < SOCK_TRACK_FDS){
+                uint32_t drops;
+                memcpy(&drops, CMSG_DATA(c), sizeof(drops));
+                __atomic_store_n(&sock_ovfl[sock], drops, __ATOMIC_RELAXED);
+            }
+        }
+        rx_buf[r]=0;
+        if(msg_parse(rx_buf, r, m) < 0) return 0;   // datagrama malformado: se ignora
+        int port = ntohs(from->sin_port);
+        if(m->type == MSG_ACK){
+            rel_acked(port, m->seq);
+            continue;
+        }
+        if(m->seq != 0){
+            // lo recibido por un grupo se confirma desde el socket propio del integrante
+            int asock = sock < SOCK_TRACK_FDS && sock_ack_via[sock] ? sock_ack_via[sock] - 1 : sock;
+            char ack[32];
+            int n = snprintf(ack, sizeof(ack), "%d|0|0|%u|", (int)MSG_ACK, m->seq);
+            send_raw(asock, port, ack, n);
+            // los seqs de grupo tienen su propia ventana por emisor
+            int key = (m->seq & RELIABLE_GROUP_BIT) ? port + 65536 : port;
+            if(!rel_accept(key, m->seq)) continue;   // duplicado de un reintento
+        }
+        return r;
+    }
+}
+
+int recv_msg(int sock, msg_t *m, struct sockaddr_in *from){
+    msg_view_t v;
+    int r = recv_view(sock, &v, from);
+    if(r > 0) msg_from_view(&v, m);
     return r;
 }
 
+int params_get_string(const char *path, const char *key, char *out, size_t outlen){
+    FILE *f = fopen(path, "r");
+    if(!f) return 0;
+    int found = 0;
+    char line[256];
+    while(fgets(line, sizeof(line), f)){
+        if(line[0] == '#') continue;
+        char k[80], v[200];
+        if(sscanf(line, "%79[^=]=%199s", k, v) == 2 && strcmp(k, key) == 0){
+            snprintf(out, outlen, "%s", v);
+            found = 1;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
 int port_for_center(int base){ return base + 1; }
 int port_for_truck(int base, int truck_id){ return base + 100 + truck_id; }
 int port_for_drone(int base, int drone_global_id){ return base + 1000 + drone_global_id; }
 int port_for_artillery(int base){ return base + 2; }
+int port_for_agent(int base, int worker){ return base + 10 + worker; }
+int port_for_center_shard(int base, int shard){ return shard > 0 ? base + 80 + shard : base + 1; }
+
+// ---------- modo distribuido ----------
+static int net_n = 0, net_base = 0, net_swarms = 1;
+static in_addr_t net_addrs[MAX_WORKERS];
+static char net_names[MAX_WORKERS][INET_ADDRSTRLEN];
+static in_addr_t net_center = 0;     // 0 = aún sin net_load: HOST
+static int net_shards = 1;
+
+int net_load(const char *params_path){
+    char v[200];
+    net_center = inet_addr(HOST);
+    if(params_get_string(params_path, "CENTER_HOST", v, sizeof(v)) && inet_addr(v) != INADDR_NONE)
+        net_center = inet_addr(v);
+    net_base = params_get_string(params_path, "BASE_PORT", v, sizeof(v)) ? atoi(v) : 40000;
+    net_swarms = params_get_string(params_path, "NUM_SWARMS", v, sizeof(v)) && atoi(v) > 0 ? atoi(v) : 1;
+    net_shards = params_get_string(params_path, "CENTER_SHARDS", v, sizeof(v)) ? atoi(v) : 1;
+    if(net_shards < 1) net_shards = 1;
+    if(net_shards > MAX_CENTER_SHARDS) net_shards = MAX_CENTER_SHARDS;
+    if(net_shards > net_swarms) net_shards = net_swarms;
+    net_n = 0;
+    if(!params_get_string(params_path, "WORKERS", v, sizeof(v))) return 0;
+    char *save;
+    for(char *t = strtok_r(v, ",", &save); t && net_n < MAX_WORKERS; t = strtok_r(NULL, ",", &save)){
+        struct in_addr a;
+        if(!inet_aton(t, &a)){
+            fprintf(stderr, "WORKERS: dirección inválida '%s', se ignora\n", t);
+            continue;
+        }
+        net_addrs[net_n] = a.s_addr;
+        snprintf(net_names[net_n], sizeof(net_names[net_n]), "%s", inet_ntoa(a));
+        net_n++;
+    }
+    if(net_n > 0) group_disabled = 1;   // loopback multicast: un solo nodo
+    return net_n;
+}
+
+int net_workers(void){ return net_n; }
+
+int center_shards(void){ return net_shards; }
+
+int center_shard_of_swarm(int swarm){
+    if(net_shards <= 1 || swarm < 0 || swarm >= net_swarms) return 0;
+    return (int)((long)swarm * net_shards / net_swarms);
+}
+
+int net_worker_of_swarm(int swarm){
+    if(net_n == 0 || swarm < 0 || swarm >= net_swarms) return -1;
+    return (int)((long)swarm * net_n / net_swarms);
+}
+
+const char *net_worker_addr(int worker){
+    return worker >= 0 && worker < net_n ? net_names[worker] : HOST;
+}
+
+in_addr_t net_addr_for_port(int port){
+    if(net_center == 0) return inet_addr(HOST);
+    int k = -1, off = port - net_base;
+    if(net_n > 0){
+        if(off > 1000) k = net_worker_of_swarm((off - 1000 - 1) / 100);   // drone: gid = swarm*100 + i + 1
+        else if(off >= 100 && off < 1000) k = net_worker_of_swarm(off - 100);
+        else if(off >= 10 && off < 10 + net_n) k = off - 10;
+    }
+    return k >= 0 ? net_addrs[k] : net_center;
+}
+
+int sim_budget = 0;
+size_t sim_thread_stack = 0;
 
+int budget_load(const char *params_path){
+    char v[16];
+    sim_budget = params_get_string(params_path, "MEM_BUDGET", v, sizeof(v)) && atoi(v) > 0;
+    sim_thread_stack = sim_budget ? SIM_BUDGET_STACK : 0;
+    return sim_budget;
+}
+
+int sim_thread_create(pthread_t *t, void *(*fn)(void *), void *arg){
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if(sim_thread_stack) pthread_attr_setstacksize(&attr, sim_thread_stack);
+    int rc = pthread_create(t, &attr, fn, arg);
+    pthread_attr_destroy(&attr);
+    return rc;
+}
+
+int budget_rcvbuf_bytes(int senders){
+    int bytes = senders * SIM_BUDGET_BACKLOG * SIM_BUDGET_PER_MSG;
+    return bytes < 4096 ? 4096 : bytes;
+}
+
+int budget_rcvbuf(int sock, int senders){
+    if(!sim_budget) return 0;
+    int bytes = budget_rcvbuf_bytes(senders);
+    // el kernel duplica el valor pedido para contabilizar su propio overhead
+    int req = bytes / 2;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &req, sizeof(req));
+    return bytes;
+}
+
+
+// Pide 'bytes' de buffer: primero sin el tope de net.core.[rw]mem_max (requiere
+// CAP_NET_ADMIN) y si no se puede, con el tope. El kernel duplica lo pedido.
+static void sock_setbuf(int sock, int opt, int force_opt, int bytes){
+    int req = bytes / 2;
+    if(setsockopt(sock, SOL_SOCKET, force_opt, &req, sizeof(req)) < 0)
+        setsockopt(sock, SOL_SOCKET, opt, &req, sizeof(req));
+}
+
+int sock_tune(int sock, const char *params_path){
+    char v[32];
+    int on = 1;
+    setsockopt(sock, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on));
+    if(params_get_string(params_path, "SOCK_RCVBUF", v, sizeof(v)) && atoi(v) > 0)
+        sock_setbuf(sock, SO_RCVBUF, SO_RCVBUFFORCE, atoi(v));
+    if(params_get_string(params_path, "SOCK_SNDBUF", v, sizeof(v)) && atoi(v) > 0)
+        sock_setbuf(sock, SO_SNDBUF, SO_SNDBUFFORCE, atoi(v));
+    int eff = 0;
+    socklen_t len = sizeof(eff);
+    getsockopt(sock, SOL_SOCKET, SO_RCVBUF, &eff, &len);
+    return eff;
+}
+
+unsigned long sock_drops(int sock){
+    if(sock < 0 || sock >= SOCK_TRACK_FDS) return 0;
+    return __atomic_load_n(&sock_ovfl[sock], __ATOMIC_RELAXED);
+}
+
+int sock_queue_fill(int sock, int *queued, int *rcvbuf){
+    uint32_t mi[SK_MEMINFO_VARS];
+    socklen_t len = sizeof(mi);
+    if(getsockopt(sock, SOL_SOCKET, SO_MEMINFO, mi, &len) < 0) return -1;
+    if(queued) *queued = mi[SK_MEMINFO_RMEM_ALLOC];
+    if(rcvbuf) *rcvbuf = mi[SK_MEMINFO_RCVBUF];
+    return mi[SK_MEMINFO_RCVBUF] ? (int)(100.0 * mi[SK_MEMINFO_RMEM_ALLOC] / mi[SK_MEMINFO_RCVBUF]) : 0;
+}
@@ -17,6 +17,7 @@
 #include <errno.h>
 
 #define MAX_MSG 256
+#define MAX_DGRAM 1400    // datagrama más grande que se recibe (lotes de POS del worker_agent)
 #define HOST "127.0.0.1"
 
 typedef enum {
@@ -24,6 +25,9 @@ typedef enum {
     MSG_COMMAND,      // commands from CC to drone
     MSG_STATUS,       // status from drone to CC
     MSG_ARTILLERY,    // from artillery to CC or drone
+    MSG_PING,         // eco de latencia: CC/artillería responden igual al emisor
+    MSG_ACK,          // confirmación de un mensaje confiable (seq); la consume recv_msg
+    MSG_POS_BATCH,    // worker_agent -> artillería: "gid swarm x y;..." (drone_id = cantidad)
 } msg_type_t;
 
 typedef struct {
@@ -31,17 +35,121 @@ typedef struct {
     int swarm_id;
     int truck_id;
     int drone_id;
+    unsigned seq;     // != 0: mensaje confiable (se confirma con MSG_ACK)
     char text[200];
 } msg_t;
 
+// Mensaje recibido decodificado en el lugar: text apunta al buffer de recepción del
+// hilo (terminado en NUL) y vale hasta la próxima recepción de ese mismo hilo
+typedef struct {
+    msg_type_t type;
+    int swarm_id;
+    int drone_id;
+    unsigned seq;
+    const char *text;
+    int text_len;
+} msg_view_t;
+
 int make_udp_socket();
+int msg_encode(const msg_t *m, char *buf, size_t len);
+int msg_decode(const char *buf, msg_t *m);
+int msg_parse(char *buf, int len, msg_view_t *v);
 int send_msg(int sock, int port, msg_t *m);
+// Datagrama ya codificado (hasta MAX_DGRAM) a la dirección de port
+int send_datagram(int sock, int port, const char *buf, int n);
+// Reenvía una vista recibida (ecos) sin pasar por msg_t; seq 0
+int send_view(int sock, int port, const msg_view_t *v);
+// Recibe el próximo mensaje de la aplicación: confirma los confiables, descarta
+// duplicados y procesa los ACK sin devolverlos. recv_view no copia; recv_msg
+// copia la vista a un msg_t para quien necesite conservarlo.
+int recv_view(int sock, msg_view_t *m, struct sockaddr_in *from);
 int recv_msg(int sock, msg_t *m, struct sockaddr_in *from);
 
+// Entrega confiable para comandos (la telemetría sigue con send_msg):
+// número de secuencia por destino, ACK automático en recv_msg y reintentos con
+// espera exponencial (RELIABLE_RTO_MS, x2 por intento) hasta RELIABLE_MAX_TRIES.
+#define RELIABLE_RTO_MS    100
+#define RELIABLE_MAX_RTO_MS 2000
+#define RELIABLE_MAX_TRIES 6
+#define RELIABLE_WINDOW    64     // seqs recientes recordados por emisor
+int send_msg_reliable(int sock, int port, msg_t *m);
+// Reenvía lo vencido; devuelve ms hasta el próximo reintento (-1 si no hay pendientes)
+int reliable_tick(void);
+// Hilo que llama reliable_tick (para procesos con hilos; los de bucle de eventos lo llaman ellos)
+void reliable_start(void);
+// Espera (leyendo sock) a que se confirmen los pendientes de sock, hasta timeout_ms.
+// Consume los mensajes que lleguen: usar al terminar o si nadie más lee el socket.
+void reliable_flush(int sock, int timeout_ms);
+void reliable_stats(int *pending, unsigned long *retransmits, unsigned long *dropped, unsigned long *duplicates);
+
+// Grupos multicast por swarm en loopback (239.1.x.y, puerto base+3): un solo envío
+// llega a todo el swarm. Cada integrante queda pendiente por separado y el que no
+// confirma recibe reintentos por unicast; sin multicast (o SWARM_MULTICAST=0) se
+// envía uno por uno. members son ids globales de drones.
+#define RELIABLE_GROUP_BIT 0x80000000u   // seq de grupo: ventana aparte en el receptor
+int send_msg_group(int sock, int base, int swarm, const int *members, int n, msg_t *m);
+// Igual pero sin confirmación (un solo datagrama, seq 0): para comandos idempotentes
+int send_msg_group_unreliable(int sock, int base, int swarm, const int *members, int n, msg_t *m);
+// Socket unido al grupo del swarm; lo recibido se confirma desde ack_sock (-1 si falla)
+int group_open(int base, int swarm, int ack_sock);
+int group_move(int fd, int old_swarm, int new_swarm);
+// Lee SWARM_MULTICAST y prueba el multicast por loopback; 1 si send_msg_group lo usará
+int group_available(const char *params_path);
+
+// Busca KEY=valor (texto) en params.txt; devuelve 1 si existe
+int params_get_string(const char *path, const char *key, char *out, size_t outlen);
+
 int port_for_center(int base);
 int port_for_truck(int base, int truck_id);
 int port_for_drone(int base, int drone_global_id);
 int port_for_artillery(int base);
+int port_for_swarm_group(int base);
+int port_for_agent(int base, int worker);
+// Centro particionado (CENTER_SHARDS=n): el shard k tiene un bloque contiguo de swarms
+// y escucha en port_for_center_shard(base, k); el shard 0 usa port_for_center
+#define MAX_CENTER_SHARDS 20
+int port_for_center_shard(int base, int shard);
+int center_shards(void);                 // 1 sin CENTER_SHARDS (o antes de net_load)
+int center_shard_of_swarm(int swarm);    // 0 con un solo shard
+
+// Modo distribuido (WORKERS=dir1,dir2,... en params.txt): trucks y drones corren en
+// nodos de trabajo, cada uno con un worker_agent que los lanza a pedido del centro.
+// El nodo k tiene un bloque contiguo de swarms (net_worker_of_swarm) y la dirección de
+// cada proceso sale de su puerto: trucks y drones -> nodo de su swarm original,
+// agente k -> nodo k, centro, artillería y el resto -> CENTER_HOST (HOST por defecto).
+// Sin WORKERS todo queda en HOST. Los grupos multicast por loopback no cruzan nodos:
+// en modo distribuido los comandos de swarm van por unicast.
+#define MAX_WORKERS 64
+int net_load(const char *params_path);   // cantidad de workers (0 = todo local); lee también CENTER_SHARDS
+int net_workers(void);
+int net_worker_of_swarm(int swarm);      // -1 sin WORKERS
+in_addr_t net_addr_for_port(int port);   // dirección (orden de red) de quien usa port
+const char *net_worker_addr(int worker);
+
+// Modo presupuesto de memoria (MEM_BUDGET=1 en params.txt): pilas de hilos chicas
+// y buffers de recepción dimensionados por la cantidad de emisores esperados
+#define SIM_BUDGET_STACK   (128 * 1024)
+#define SIM_BUDGET_PER_MSG 1024          // costo en el buffer del kernel por datagrama chico
+#define SIM_BUDGET_BACKLOG 4             // datagramas en cola por emisor
+extern int sim_budget;                   // 1 si MEM_BUDGET=1
+extern size_t sim_thread_stack;          // 0 = tamaño por defecto del sistema
+
+int  budget_load(const char *params_path);
+int  sim_thread_create(pthread_t *t, void *(*fn)(void *), void *arg);
+// Buffer de recepción para 'senders' emisores y su aplicación con SO_RCVBUF
+// (esta última solo en modo presupuesto; devuelve los bytes pedidos o 0)
+int  budget_rcvbuf_bytes(int senders);
+int  budget_rcvbuf(int sock, int senders);
+
+// Buffers de socket desde params.txt (SOCK_RCVBUF / SOCK_SNDBUF en bytes; sin la clave
+// queda el valor del sistema o el del modo presupuesto) y conteo de descartes del kernel
+// con SO_RXQ_OVFL. Devuelve el SO_RCVBUF efectivo.
+int  sock_tune(int sock, const char *params_path);
+// Datagramas descartados por cola llena (lo actualiza recv_msg al recibir)
+unsigned long sock_drops(int sock);
+// Ocupación de la cola de recepción en % del buffer (-1 si no se puede leer);
+// opcionalmente los bytes encolados y el tamaño del buffer
+int  sock_queue_fill(int sock, int *queued, int *rcvbuf);
 
 #endif
 
@@ -1,10 +1,22 @@
 // control_center.c (version con fallo de artilleria CORREGIDO)
 #include "common.h"
+#include "log.h"
+#include "journal.h"
+#include "alloc.h"
+#include "targets.h"
+#include "memstats.h"
+#include "reload.h"
+#include "checkpoint.h"
 #include <semaphore.h>
 #include <math.h>
 #include <time.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <strings.h>
+#include <sys/un.h>
+#include <sys/stat.h>
 
-#define MAX_SWARMS 100
 #define MAX_DRONES_PER_SWARM 5
 
 typedef struct {
@@ -23,6 +35,9 @@ typedef struct {
     int in_reassembly;  // flag: en proceso de reconformación
     int is_destroyed;   // flag: swarm autodestruido
     int camera_reported; // NEW: para evitar doble reporte de cámara
+    double pos_x, pos_y; // última posición reportada por algún drone del swarm
+    int on_target_list;  // enlazado en la lista de su blanco (vivo y con blanco)
+    int prev_on_target, next_on_target;
 } swarm_t;
 
 char *params_path = NULL;
@@ -34,19 +49,69 @@ int ASSEMBLY_SIZE = 5;
 int RANDOM_SEED = 0;
 double C = 100.0;
 int MAX_WAIT_REASSEMBLY = 5;
-
-swarm_t swarms[MAX_SWARMS];
+int SPAWN_TRUCKS = 1;
+int memstats_mode = 0;   // --memstats: RSS por rol y por drone junto al estado
+// Modelo de vuelo/defensa usado por la asignación de blancos
+double VX = 5.0, B = 20.0, A = 50.0;
+int ARTILLERY_RATE = 2;
+// Telemetría adaptativa de órbita: período base/máximo y umbrales de ocupación de la cola (%)
+int TELEMETRY_MS = 100, TELEMETRY_MAX_MS = 1600;
+int TELEMETRY_HIGH = 50, TELEMETRY_LOW = 10;
+int telemetry_ms = 100;   // período vigente pedido a los drones
+alloc_model_t alloc_model;
+volatile int realloc_pending = 0; // se perdió un swarm o cayó un blanco: re-resolver
+
+swarm_t *swarms = NULL;   // NUM_SWARMS entradas, reservadas en main
+// Centro particionado (CENTER_SHARDS): este proceso atiende los swarms [swarm_lo, swarm_hi);
+// con un solo shard son todos
+int shard_id = 0;
+int swarm_lo = 0, swarm_hi = 0;
+char shard_suffix[16] = "";   // "_k" en los nombres de archivo del shard k>0
+
+// Vista de cada swarm para los reportes de estado: la publica quien modifica el swarm
+// (con sem_swarms tomado) y el hilo principal la lee sin tomar locks, con un seqlock
+// por entrada; version cambia en cada publicación y permite reportar solo diferencias
+typedef struct {
+    unsigned seq;        // impar mientras se escribe
+    unsigned version;
+    int active_count, assembled, in_reassembly, is_destroyed;
+    int target_id, target_destroyed;
+    double target_x, target_y;
+    time_t reassembly_start;
+    int drone_ids[MAX_DRONES_PER_SWARM];
+} swarm_view_t;
+
+swarm_view_t *swarm_views = NULL;
+unsigned *status_versions = NULL;   // versión de cada swarm en el último reporte
+#define STATUS_MAX_DIFF 50          // swarms cambiados que se listan por reporte
+volatile sig_atomic_t full_status_requested = 0;   // SIGUSR1: volcado completo
 int center_sock;
+unsigned long msgs_dispatched = 0;   // mensajes despachados por el listener
+double mission_start = 0;           // reloj monotónico al arrancar
+char control_path[108] = "";        // CONTROL_SOCKET, vacío si no hay socket de control
+char checkpoint_dir[200] = "";      // CHECKPOINT_DIR, vacío si no hay instantáneas
+char checkpoint_name[32] = "center.ckpt";   // center_<k>.ckpt en el shard k>0
+unsigned long checkpoints_written = 0;
+double checkpoint_ms = 0;           // duración de la última (fork + escritura del hijo)
 
-// Mapa consistente target_id -> (x,y)
-typedef struct { double x,y; } target_pos_t;
-static target_pos_t targets_catalog[256]; // soporta hasta 256 blancos
+// Catálogo target_id -> (x,y, prioridad) y estado vivo de cada blanco
+target_set_t targets;
 
 // Semáforos
 sem_t sem_swarms;        // protege swarms[]
 sem_t sem_reassign_line; // sección crítica de reasignación entre swarms
 
 // ---------- util ----------
+static double now_mono(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline int swarm_owned(int i){
+    return i >= swarm_lo && i < swarm_hi;
+}
+
 static inline void notify_artillery_down(int drone_id){
     msg_t a; memset(&a,0,sizeof(a));
     a.type = MSG_ARTILLERY;
@@ -72,52 +137,289 @@ void load_params(const char *path) {
             if(strcmp(key,"BASE_PORT")==0) BASE_PORT=val;
             if(strcmp(key,"RANDOM_SEED")==0) RANDOM_SEED=val;
             if(strcmp(key,"MAX_WAIT_REASSEMBLY")==0) MAX_WAIT_REASSEMBLY=val;
+            if(strcmp(key,"SPAWN_TRUCKS")==0) SPAWN_TRUCKS=val;
+            if(strcmp(key,"ARTILLERY_RATE")==0) ARTILLERY_RATE=val;
+            if(strcmp(key,"TELEMETRY_MS")==0) TELEMETRY_MS=val;
+            if(strcmp(key,"TELEMETRY_MAX_MS")==0) TELEMETRY_MAX_MS=val;
+            if(strcmp(key,"TELEMETRY_HIGH")==0) TELEMETRY_HIGH=val;
+            if(strcmp(key,"TELEMETRY_LOW")==0) TELEMETRY_LOW=val;
         }
-        else if(sscanf(line,"%[^=]=%lf", key, &dval)==2) {
+        // los reales también se leen con %lf ("C=100.0" ya matchea %d arriba)
+        if(sscanf(line,"%[^=]=%lf", key, &dval)==2) {
             if(strcmp(key,"C")==0) C=dval;
+            if(strcmp(key,"VX")==0) VX=dval;
+            if(strcmp(key,"B")==0) B=dval;
+            if(strcmp(key,"A")==0) A=dval;
         }
     }
     fclose(f);
 }
 
-// Genera un catálogo determinista de blancos: MISMO ID → MISMAS COORDS
+// Catálogo de blancos: TARGETS_FILE (CSV x,y[,prioridad[,requeridos]] o binario) si está
+// configurado; si no, NUM_TARGETS blancos deterministas en x=C (MISMO ID → MISMAS COORDS)
 static void build_targets_catalog(void){
+    targets_free(&targets);
+    char path[256];
+    if(params_path && params_get_string(params_path, "TARGETS_FILE", path, sizeof(path))){
+        int n = targets_load(&targets, path, ASSEMBLY_SIZE);
+        if(n > 0){
+            NUM_TARGETS = targets.count;
+            LOGI("Cargados %d blancos desde %s", NUM_TARGETS, path);
+            return;
+        }
+        LOGW("No se pudieron cargar blancos de %s, se generan %d en x=C", path, NUM_TARGETS);
+        targets_free(&targets);
+    }
     // X fijo en C, Y espaciado uniforme en [10, 100-10]
-    if(NUM_TARGETS > 256) NUM_TARGETS = 256;
     double y0 = 10.0, y1 = 90.0;
     for(int t=0; t<NUM_TARGETS; ++t){
         double frac = (NUM_TARGETS<=1)?0.0: (double)t/(double)(NUM_TARGETS-1);
-        targets_catalog[t].x = C;
-        targets_catalog[t].y = y0 + (y1 - y0)*frac;
+        targets_add(&targets, C, y0 + (y1 - y0)*frac, 1, ASSEMBLY_SIZE);
+    }
+    targets_build_index(&targets);
+}
+
+// ---------- tabla de blancos: swarms vivos por blanco (se asume sem_swarms tomado) ----------
+static void target_unlink(int i){
+    swarm_t *s = &swarms[i];
+    if(!s->on_target_list) return;
+    target_t *t = &targets.items[s->target_id];
+    if(s->prev_on_target >= 0) swarms[s->prev_on_target].next_on_target = s->next_on_target;
+    else t->first_swarm = s->next_on_target;
+    if(s->next_on_target >= 0) swarms[s->next_on_target].prev_on_target = s->prev_on_target;
+    t->n_swarms--;
+    s->on_target_list = 0;
+}
+
+// Publica el estado de swarms[i] en su vista (con sem_swarms tomado)
+static void swarm_publish(int i){
+    if(!swarm_views) return;
+    swarm_view_t *v = &swarm_views[i];
+    const swarm_t *sw = &swarms[i];
+    __atomic_store_n(&v->seq, v->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    v->active_count = sw->active_count;
+    v->assembled = sw->assembled;
+    v->in_reassembly = sw->in_reassembly;
+    v->is_destroyed = sw->is_destroyed;
+    v->target_id = sw->target_id;
+    v->target_destroyed = sw->target_destroyed;
+    v->target_x = sw->target_x;
+    v->target_y = sw->target_y;
+    v->reassembly_start = sw->reassembly_start;
+    memcpy(v->drone_ids, sw->drone_global_ids, sizeof(v->drone_ids));
+    v->version++;
+    __atomic_store_n(&v->seq, v->seq + 1, __ATOMIC_RELEASE);
+}
+
+// Copia consistente de la vista i sin locks: se reintenta si un escritor la tocó
+static void swarm_view_read(int i, swarm_view_t *out){
+    const swarm_view_t *v = &swarm_views[i];
+    for(;;){
+        unsigned s1 = __atomic_load_n(&v->seq, __ATOMIC_ACQUIRE);
+        if(s1 & 1) continue;
+        memcpy(out, v, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if(__atomic_load_n(&v->seq, __ATOMIC_RELAXED) == s1) return;
+    }
+}
+
+static void set_swarm_target(int i, int tid){
+    swarm_t *s = &swarms[i];
+    target_unlink(i);
+    s->target_id = tid;
+    s->target_x = targets.items[tid].x;
+    s->target_y = targets.items[tid].y;
+    s->target_destroyed = targets.items[tid].destroyed;
+
+    target_t *t = &targets.items[tid];
+    s->prev_on_target = -1;
+    s->next_on_target = t->first_swarm;
+    if(t->first_swarm >= 0) swarms[t->first_swarm].prev_on_target = i;
+    t->first_swarm = i;
+    t->n_swarms++;
+    s->on_target_list = 1;
+    swarm_publish(i);
+}
+
+// El swarm quedó sin drones: deja de contar como carga de su blanco y se re-resuelve
+static void swarm_lost(int i){
+    target_unlink(i);
+    realloc_pending = 1;
+}
+
+// Swarms que todavía no despegaron: su blanco se puede cambiar sin avisar a nadie
+// (el TARGET viaja al truck recién con el TAKEOFF)
+static int swarm_reallocatable(int i){
+    return !swarms[i].is_destroyed && swarms[i].active_count > 0 && swarms[i].assembled < 2;
+}
+
+// Copia de la entrada de la asignación: se arma con sem_swarms tomado y se resuelve
+// sin él (el listener y los despachos no esperan al auction)
+typedef struct {
+    alloc_model_t model;
+    alloc_target_t *tg;
+    alloc_swarm_t *sw;
+    int *idx;       // swarm del center de cada fila de sw
+    int *out;
+    int ns;
+} alloc_job_t;
+
+static void alloc_job_free(alloc_job_t *j){
+    free(j->tg); free(j->sw); free(j->idx); free(j->out);
+}
+
+// Arma la entrada con los swarms reasignables; los que ya están en vuelo cuentan como
+// carga fija sobre su blanco. Con launch los swarms de otros shards entran como recién
+// lanzados (ver assign_targets). Se asume sem_swarms tomado; devuelve -1 sin memoria.
+static int alloc_job_snapshot(alloc_job_t *j, int launch){
+    memset(j, 0, sizeof(*j));
+    j->model = alloc_model;
+    j->tg = calloc(NUM_TARGETS, sizeof(alloc_target_t));
+    j->sw = malloc(NUM_SWARMS * sizeof(alloc_swarm_t));
+    j->idx = malloc(NUM_SWARMS * sizeof(int));
+    j->out = malloc(NUM_SWARMS * sizeof(int));
+    if(!j->tg || !j->sw || !j->idx || !j->out) return -1;
+
+    for(int t = 0; t < NUM_TARGETS; t++) {
+        j->tg[t].x = targets.items[t].x;
+        j->tg[t].y = targets.items[t].y;
+        j->tg[t].required = targets.items[t].required;
+        j->tg[t].destroyed = targets.items[t].destroyed;
+        j->tg[t].priority = targets.items[t].priority;
+    }
+    for(int i = 0; i < NUM_SWARMS; i++) {
+        alloc_swarm_t *s = &j->sw[j->ns];
+        if(launch && !swarm_owned(i)) {
+            s->x = B;
+            s->y = 0.0;
+            s->drones = ASSEMBLY_SIZE;
+        } else if(swarm_reallocatable(i)) {
+            s->x = swarms[i].pos_x;
+            s->y = swarms[i].pos_y;
+            s->drones = swarms[i].active_count;
+        } else {
+            if(swarms[i].on_target_list) j->tg[swarms[i].target_id].load++;
+            continue;
+        }
+        j->idx[j->ns++] = i;
     }
+    return 0;
+}
+
+// Índice de alloc_solve: la grilla del catálogo (las posiciones no cambian durante la
+// misión y el costo lo calcula alloc sobre la copia, así que se consulta sin sem_swarms)
+static int alloc_nearest(void *index, double x, double y, double (*cost)(int t, void *cctx),
+                         double dist_scale, double extra_min, void *cctx,
+                         int want, int *out, double *out_cost){
+    return targets_nearest(index, x, y, cost, dist_scale, extra_min, cctx, want, out, out_cost);
+}
+
+// Aplica el resultado (sem_swarms tomado). Un swarm que despegó o se perdió mientras se
+// resolvía, o cuyo blanco cayó, queda como está: esos cambios ya dejaron realloc_pending.
+// Devuelve la cantidad de swarms cuyo blanco cambió.
+static int alloc_job_apply(const alloc_job_t *j){
+    int changed = 0;
+    for(int n = 0; n < j->ns; n++) {
+        int i = j->idx[n], tid = j->out[n];
+        if(tid < 0 || !swarm_owned(i) || !swarm_reallocatable(i)) continue;
+        if(tid == swarms[i].target_id || targets.items[tid].destroyed) continue;
+        set_swarm_target(i, tid);
+        changed++;
+
+        LOGI("Swarm %d asignado a Blanco %d en (%.1f, %.1f) costo=%.1f",
+               i, tid, swarms[i].target_x, swarms[i].target_y,
+               alloc_cost(&j->model, &j->sw[n], &j->tg[tid], 0));
+        journal_append(JEV_SWARM_TARGET, i, 0, tid, swarms[i].target_x, swarms[i].target_y);
+    }
+    return changed;
+}
+
+// Resuelve la asignación swarms->blancos para los swarms reasignables: copia con
+// sem_swarms, auction sin él y vuelve a tomarlo para aplicar.
+// Devuelve la cantidad de swarms cuyo blanco cambió.
+static int solve_target_allocation(int launch){
+    alloc_job_t j;
+    int changed = 0;
+    sem_wait(&sem_swarms);
+    int rc = alloc_job_snapshot(&j, launch);
+    sem_post(&sem_swarms);
+    if(rc == 0) rc = alloc_solve(&j.model, j.sw, j.ns, j.tg, NUM_TARGETS, alloc_nearest, &targets, j.out);
+    if(rc < 0) {
+        LOGE("Asignación de blancos: sin memoria");
+    } else {
+        sem_wait(&sem_swarms);
+        changed = alloc_job_apply(&j);
+        sem_post(&sem_swarms);
+    }
+    alloc_job_free(&j);
+    return changed;
 }
 
-void assign_random_targets() {
-    printf("[CENTER] Asignando %d enjambres a %d blancos disponibles\n", NUM_SWARMS, NUM_TARGETS);
+void assign_targets() {
+    LOGI("Asignando %d enjambres a %d blancos disponibles", swarm_hi - swarm_lo, NUM_TARGETS);
+    const live_params_t *lp = live_params();
+    sem_wait(&sem_swarms);
+    alloc_model_init(&alloc_model, lp->VX, B, A, lp->W, lp->ARTILLERY_RATE);
     for(int i = 0; i < NUM_SWARMS; i++) {
-        int tid = i % NUM_TARGETS;   // ✅ round-robin, no random
+        target_unlink(i);
+        swarms[i].target_id = -1;
+    }
+    sem_post(&sem_swarms);
+    // Centro particionado: cada shard resuelve el reparto de todos los swarms (recién
+    // lanzados son iguales en todos los shards, así que todos llegan al mismo) y se queda
+    // con el de los suyos. Las re-resoluciones posteriores son de cada shard.
+    solve_target_allocation(1);
+    sem_wait(&sem_swarms);
+    for(int i = swarm_lo; i < swarm_hi; i++) swarm_publish(i);
+    sem_post(&sem_swarms);
+}
 
-        swarms[i].target_id = tid;
-        swarms[i].target_x = targets_catalog[tid].x;
-        swarms[i].target_y = targets_catalog[tid].y;
-        swarms[i].target_destroyed = 0;
+// Re-resuelve tras perder un swarm o destruir un blanco (una vez por tick)
+void reallocate_targets() {
+    if(!realloc_pending) return;
+    realloc_pending = 0;
+    int changed = solve_target_allocation(0);
+    if(changed > 0) LOGI("Reasignación de blancos: %d swarms cambiaron de blanco", changed);
+}
 
-        printf("[CENTER] Swarm %d asignado a Blanco %d en (%.1f, %.1f)\n",
-               i, tid, swarms[i].target_x, swarms[i].target_y);
+// Lanza el truck de un swarm con args después del tid: fork/exec local o, en modo
+// distribuido, "SPAWN tid args..." al worker_agent del nodo que tiene el swarm.
+// Devuelve el pid local, 0 si lo lanza un agente o -1.
+pid_t launch_truck(int swarm_id, char **args, int nargs){
+    char tid[16];
+    snprintf(tid, sizeof(tid), "%d", swarm_id);
+    int worker = net_worker_of_swarm(swarm_id);
+    if(worker >= 0){
+        msg_t m; memset(&m,0,sizeof(m));
+        m.type = MSG_COMMAND;
+        m.swarm_id = swarm_id;
+        size_t len = snprintf(m.text, sizeof(m.text), "SPAWN %s", tid);
+        for(int k = 0; k < nargs && len < sizeof(m.text); k++)
+            len += snprintf(m.text + len, sizeof(m.text) - len, " %s", args[k]);
+        send_msg_reliable(center_sock, port_for_agent(BASE_PORT, worker), &m);
+        return 0;
+    }
+    pid_t pid = fork();
+    if(pid == 0){
+        char *argv[4 + 2 * MAX_DRONES_PER_SWARM + 8];
+        int na = 0;
+        argv[na++] = "truck"; argv[na++] = params_path; argv[na++] = tid;
+        for(int k = 0; k < nargs && na < (int)(sizeof(argv) / sizeof(argv[0])) - 1; k++) argv[na++] = args[k];
+        argv[na] = NULL;
+        execv("./truck", argv);
+        perror("execv truck");
+        exit(1);
     }
+    if(pid < 0) perror("fork truck");
+    return pid;
 }
 
 void spawn_trucks_and_drones() {
-    for(int i=0;i<NUM_SWARMS;i++){
-        pid_t pid = fork();
-        if(pid==0){
-            char tid[16], ppath[256];
-            snprintf(tid,sizeof(tid),"%d",i);
-            snprintf(ppath,sizeof(ppath),"%s",params_path);
-            execl("./truck","truck", ppath, tid, (char*)NULL);
-            perror("execl truck");
-            exit(1);
-        } else if(pid>0) {
+    for(int i = swarm_lo; i < swarm_hi; i++){
+        // SPAWN_TRUCKS=0: los trucks son externos (p.ej. loadgen), solo se registra el swarm
+        pid_t pid = SPAWN_TRUCKS ? launch_truck(i, NULL, 0) : 0;
+        if(pid>=0) {
             sem_wait(&sem_swarms);
             swarms[i].swarm_id = i;
             swarms[i].truck_pid = pid;
@@ -128,43 +430,118 @@ void spawn_trucks_and_drones() {
             swarms[i].in_reassembly = 0;
             swarms[i].is_destroyed = 0;
             swarms[i].camera_reported = 0;
+            swarms[i].pos_x = B;   // centro de la órbita de ensamble
+            swarms[i].pos_y = 0.0;
             for(int j=0;j<ASSEMBLY_SIZE;j++) {
                 swarms[i].drone_global_ids[j]=0;
                 swarms[i].drone_terminated[j]=0;
             }
+            swarm_publish(i);
             sem_post(&sem_swarms);
-        } else {
-            perror("fork truck");
         }
     }
-    assign_random_targets();
+    assign_targets();
 }
 
-void try_reconform_or_autodestruct(int swarm_id);
+// Línea de estado de un swarm (sin '\n'); la usan el reporte periódico y el socket de control
+static int format_swarm_line(char *buf, size_t len, int i, const swarm_view_t *v, time_t now) {
+    int n = snprintf(buf, len, "Swarm %d: active=%d assembled=%d target=%d(%.1f,%.1f)%s drones:",
+                     i, v->active_count, v->assembled, v->target_id, v->target_x, v->target_y,
+                     v->target_destroyed ? "[DESTRUIDO]" : "[ENTERO]");
+    for(int j=0;j<ASSEMBLY_SIZE && n < (int)len;j++)
+        if(v->drone_ids[j] != 0) n += snprintf(buf + n, len - n, " %d", v->drone_ids[j]);
+    if(v->in_reassembly && !v->is_destroyed && n < (int)len)
+        n += snprintf(buf + n, len - n, " [RECONFORMANDO:%lds]", (long)(now - v->reassembly_start));
+    if(v->is_destroyed && n < (int)len)
+        n += snprintf(buf + n, len - n, " [AUTODESTRUIDO]");
+    return n;
+}
 
-void print_status() {
-    sem_wait(&sem_swarms);
-    printf("=== CENTER STATUS ===\n");
-    for(int i=0;i<NUM_SWARMS;i++){
-        printf("Swarm %d: active=%d assembled=%d target=%d(%.1f,%.1f)%s drones:",
-               i, swarms[i].active_count, swarms[i].assembled,
-               swarms[i].target_id, swarms[i].target_x, swarms[i].target_y,
-               swarms[i].target_destroyed ? "[DESTRUIDO]" : "[ENTERO]");
-        for(int j=0;j<ASSEMBLY_SIZE;j++) {
-            if(swarms[i].drone_global_ids[j] != 0) {
-                printf(" %d", swarms[i].drone_global_ids[j]);
-            }
-        }
-        if(swarms[i].in_reassembly && !swarms[i].is_destroyed) {
-            time_t elapsed = time(NULL) - swarms[i].reassembly_start;
-            printf(" [RECONFORMANDO:%lds]", elapsed);
-        }
-        if(swarms[i].is_destroyed) {
-            printf(" [AUTODESTRUIDO]");
+static void print_swarm_line(int i, const swarm_view_t *v, time_t now) {
+    char line[256];
+    format_swarm_line(line, sizeof(line), i, v, now);
+    printf("%s\n", line);
+}
+
+// Totales por estado, acumulados vista a vista
+typedef struct {
+    int alive, drones, assembling, flying, reassembling, destroyed;
+} status_totals_t;
+
+static void totals_add(status_totals_t *t, const swarm_view_t *v){
+    if(v->is_destroyed) t->destroyed++;
+    else if(v->active_count > 0){
+        t->alive++;
+        t->drones += v->active_count;
+        if(v->in_reassembly) t->reassembling++;
+        else if(v->assembled == 2) t->flying++;
+        else t->assembling++;
+    }
+}
+
+static int targets_destroyed_count(void){
+    int n = 0;
+    for(int t = 0; t < NUM_TARGETS; t++) n += __atomic_load_n(&targets.items[t].destroyed, __ATOMIC_RELAXED);
+    return n;
+}
+
+// Estado a partir de las vistas, sin tomar sem_swarms: totales y solo los swarms
+// que cambiaron desde el reporte anterior (hasta STATUS_MAX_DIFF); full lista todos
+void print_status(int full) {
+    status_totals_t tot = {0};
+    int changed = 0, listed = 0;
+    time_t now = time(NULL);
+    if(center_shards() > 1)
+        printf("=== CENTER STATUS shard %d (swarms %d..%d)%s ===\n", shard_id, swarm_lo, swarm_hi - 1,
+               full ? " (completo)" : "");
+    else
+        printf("=== CENTER STATUS%s ===\n", full ? " (completo)" : "");
+    for(int i = swarm_lo; i < swarm_hi; i++){
+        swarm_view_t v;
+        swarm_view_read(i, &v);
+        totals_add(&tot, &v);
+        int diff = v.version != status_versions[i];
+        status_versions[i] = v.version;
+        changed += diff;
+        if(full || (diff && listed < STATUS_MAX_DIFF)){
+            print_swarm_line(i, &v, now);
+            listed++;
         }
-        printf("\n");
     }
-    sem_post(&sem_swarms);
+    if(!full && changed > listed)
+        printf("... y %d swarms más con cambios (kill -USR1 %d para el estado completo)\n",
+               changed - listed, (int)getpid());
+    printf("Swarms: %d/%d vivos (ensamblando=%d en_vuelo=%d reconformando=%d) autodestruidos=%d "
+           "drones=%d blancos destruidos=%d/%d cambios=%d\n",
+           tot.alive, swarm_hi - swarm_lo, tot.assembling, tot.flying, tot.reassembling, tot.destroyed,
+           tot.drones, targets_destroyed_count(), NUM_TARGETS, changed);
+    int pending; unsigned long retx, dropped, dups;
+    reliable_stats(&pending, &retx, &dropped, &dups);
+    printf("Comandos confiables: pendientes=%d reintentos=%lu sin_ack=%lu duplicados=%lu\n",
+           pending, retx, dropped, dups);
+    int queued = 0, rcvbuf = 0;
+    int fill = sock_queue_fill(center_sock, &queued, &rcvbuf);
+    printf("Socket: cola=%d/%d kB (%d%%) descartes=%lu telemetría=%d ms\n",
+           queued / 1024, rcvbuf / 1024, fill, sock_drops(center_sock), telemetry_ms);
+}
+
+// RSS de todos los procesos de la simulación y configuración de presupuesto
+void print_memstats() {
+    memstats_t ms;
+    if(memstats_collect(&ms) < 0) {
+        LOGW("memstats: /proc no disponible");
+        return;
+    }
+    memstats_print(stdout, &ms);
+    int nd = ASSEMBLY_SIZE * NUM_SWARMS;
+    if(sim_budget)
+        printf("Presupuesto para %d drones: pila de hilos %zu kB, SO_RCVBUF center %d kB, "
+               "truck %d kB, drone %d kB, artillería %d kB\n",
+               nd, sim_thread_stack / 1024,
+               budget_rcvbuf_bytes(nd + NUM_SWARMS + 2) / 1024, budget_rcvbuf_bytes(ASSEMBLY_SIZE + 2) / 1024,
+               budget_rcvbuf_bytes(3) / 1024, budget_rcvbuf_bytes(nd + 1) / 1024);
+    else
+        printf("Sin presupuesto (MEM_BUDGET=0): pilas y SO_RCVBUF por defecto del sistema\n");
 }
 
 static void send_target_to_truck_coords(int swarm_id, double tx, double ty, int tid) {
@@ -173,7 +550,7 @@ static void send_target_to_truck_coords(int swarm_id, double tx, double ty, int
     cmd.swarm_id = swarm_id;
     snprintf(cmd.text,sizeof(cmd.text),"TARGET %.1f %.1f %d", tx, ty, tid);
     int truck_port = port_for_truck(BASE_PORT, swarm_id);
-    send_msg(center_sock, truck_port, &cmd);
+    send_msg_reliable(center_sock, truck_port, &cmd);
 }
 
 void send_target_to_truck(int swarm_id) {
@@ -187,16 +564,114 @@ void send_target_to_truck(int swarm_id) {
     send_target_to_truck_coords(swarm_id, tx, ty, tid);
 }
 
+// Blanco y TAKEOFF al truck del swarm (el truck lo reenvía a su grupo)
+static void send_takeoff(int swarm_id) {
+    journal_append(JEV_TAKEOFF, swarm_id, 0, 0, 0, 0);
+    send_target_to_truck(swarm_id);
+
+    msg_t cmd; memset(&cmd,0,sizeof(cmd));
+    cmd.type = MSG_COMMAND;
+    cmd.swarm_id = swarm_id;
+    snprintf(cmd.text,sizeof(cmd.text),"TAKEOFF");
+    int truck_port = port_for_truck(BASE_PORT, swarm_id);
+    send_msg_reliable(center_sock, truck_port, &cmd);
+}
+
+// ---------- redirección de swarms en vuelo ----------
+typedef struct {
+    int swarm_id;
+    int tid;
+    double tx, ty;
+    int drone_ids[MAX_DRONES_PER_SWARM];
+} retarget_t;
+
+typedef struct { alloc_swarm_t sw; } best_target_ctx_t;
+
+static double best_target_cost(int t, void *p){
+    best_target_ctx_t *c = p;
+    alloc_target_t tg = { targets.items[t].x, targets.items[t].y, targets.items[t].required,
+                          targets.items[t].n_swarms, 0, targets.items[t].priority };
+    return alloc_cost(&alloc_model, &c->sw, &tg, 0);
+}
+
+// Mejor blanco vivo para un swarm en vuelo según el modelo de costo (sem_swarms tomado);
+// la búsqueda por anillos del índice corta apenas la distancia no puede mejorar el costo
+static int best_target_for(int i){
+    best_target_ctx_t c = { { swarms[i].pos_x, swarms[i].pos_y, swarms[i].active_count } };
+    return targets_best(&targets, c.sw.x, c.sw.y, best_target_cost, 1.0 / alloc_model.vx,
+                        -alloc_model.priority_cost * targets.max_priority, &c);
+}
+
+// Marca el blanco destruido y redirige solo los swarms en vuelo de su lista
+// (los que no despegaron se re-resuelven en reallocate_targets). Se asume
+// sem_swarms tomado; out debe tener lugar para n_swarms del blanco (sin out, por falta
+// de memoria, el blanco se marca igual pero no se redirige a nadie).
+// Devuelve la cantidad de swarms redirigidos.
+static int mark_target_destroyed(int tid, int by_swarm, retarget_t *out){
+    target_t *t = &targets.items[tid];
+    if(t->destroyed) return 0;
+    t->destroyed = 1;
+    realloc_pending = 1;
+
+    int n = 0;
+    for(int i = t->first_swarm, next; i >= 0; i = next) {
+        next = swarms[i].next_on_target;
+        swarms[i].target_destroyed = 1;
+        swarm_publish(i);
+        if(!out || i == by_swarm || swarms[i].assembled < 2) continue;
+
+        int nt = best_target_for(i);
+        if(nt < 0) continue;   // no quedan blancos: sigue hacia el actual
+        set_swarm_target(i, nt);
+
+        retarget_t *r = &out[n++];
+        r->swarm_id = i;
+        r->tid = nt;
+        r->tx = swarms[i].target_x;
+        r->ty = swarms[i].target_y;
+        for(int j = 0; j < MAX_DRONES_PER_SWARM; j++)
+            r->drone_ids[j] = (j < ASSEMBLY_SIZE) ? swarms[i].drone_global_ids[j] : 0;
+
+        LOGI("Swarm %d redirigido de Blanco %d (destruido) a Blanco %d en (%.1f, %.1f)",
+             i, tid, nt, r->tx, r->ty);
+        journal_append(JEV_RETARGET, i, 0, nt, r->tx, r->ty);
+    }
+    return n;
+}
+
+// Ids no nulos de una lista de slots, compactados en out; devuelve cuántos
+static int live_ids(const int *ids, int n, int *out){
+    int k = 0;
+    for(int j = 0; j < n; j++) if(ids[j] != 0) out[k++] = ids[j];
+    return k;
+}
+
+// TARGET al truck (actualiza su blanco) y RETARGET directo al grupo del swarm
+static void send_retargets(const retarget_t *r, int n){
+    for(int k = 0; k < n; k++) {
+        send_target_to_truck_coords(r[k].swarm_id, r[k].tx, r[k].ty, r[k].tid);
+        int members[MAX_DRONES_PER_SWARM];
+        int nm = live_ids(r[k].drone_ids, MAX_DRONES_PER_SWARM, members);
+        msg_t cmd; memset(&cmd,0,sizeof(cmd));
+        cmd.type = MSG_COMMAND;
+        cmd.swarm_id = r[k].swarm_id;
+        snprintf(cmd.text,sizeof(cmd.text),"RETARGET %.1f %.1f %d", r[k].tx, r[k].ty, r[k].tid);
+        send_msg_group(center_sock, BASE_PORT, r[k].swarm_id, members, nm, &cmd);
+    }
+}
+
 // Remueve por ID global buscando en todos los swarms (se asume sem_swarms tomado por el caller)
 int remove_drone_from_swarm_by_id(int drone_id) {
     int found_swarm = -1;
-    for(int i = 0; i < NUM_SWARMS; i++) {
+    for(int i = swarm_lo; i < swarm_hi; i++) {
         if(swarms[i].is_destroyed) continue;
         for(int j = 0; j < ASSEMBLY_SIZE; j++) {
             if(swarms[i].drone_global_ids[j] == drone_id) {
                 swarms[i].drone_terminated[j] = 1;
                 swarms[i].drone_global_ids[j] = 0;
                 if(swarms[i].active_count > 0) swarms[i].active_count--;
+                if(swarms[i].active_count == 0) swarm_lost(i);
+                swarm_publish(i);
                 found_swarm = i;
                 return found_swarm;
             }
@@ -207,13 +682,15 @@ int remove_drone_from_swarm_by_id(int drone_id) {
 
 // Remueve por (swarm, drone) directo (se asume sem_swarms tomado por el caller)
 void remove_drone_from_swarm(int swarm_id, int drone_id) {
-    if(swarm_id < 0 || swarm_id >= NUM_SWARMS) return;
+    if(!swarm_owned(swarm_id)) return;
     if(swarms[swarm_id].is_destroyed) return;
     for(int j=0; j<ASSEMBLY_SIZE; j++) {
         if(swarms[swarm_id].drone_global_ids[j] == drone_id) {
             swarms[swarm_id].drone_terminated[j] = 1;
             swarms[swarm_id].drone_global_ids[j] = 0;
             if(swarms[swarm_id].active_count > 0) swarms[swarm_id].active_count--;
+            if(swarms[swarm_id].active_count == 0) swarm_lost(swarm_id);
+            swarm_publish(swarm_id);
             break;
         }
     }
@@ -225,8 +702,10 @@ void start_reassembly_process(int swarm_id) {
     if(!swarms[swarm_id].in_reassembly && !swarms[swarm_id].is_destroyed) {
         swarms[swarm_id].in_reassembly = 1;
         swarms[swarm_id].reassembly_start = time(NULL);
-        printf("[CENTER] Swarm %d inicia proceso de reconformación (timeout: %ds)\n",
-               swarm_id, MAX_WAIT_REASSEMBLY);
+        swarm_publish(swarm_id);
+        LOGI("Swarm %d inicia proceso de reconformación (timeout: %ds)",
+               swarm_id, live_params()->MAX_WAIT_REASSEMBLY);
+        journal_append(JEV_REASSEMBLY_START, swarm_id, 0, swarms[swarm_id].active_count, 0, 0);
     }
     sem_post(&sem_swarms);
 }
@@ -238,7 +717,9 @@ void complete_reassembly_process(int swarm_id) {
         swarms[swarm_id].in_reassembly = 0;
         swarms[swarm_id].reassembly_start = 0;
         swarms[swarm_id].assembled = 0; // permite nuevo ensamblaje/TAKEOFF si se completó
-        printf("[CENTER] Swarm %d completó reconformación exitosamente\n", swarm_id);
+        swarm_publish(swarm_id);
+        LOGI("Swarm %d completó reconformación exitosamente", swarm_id);
+        journal_append(JEV_REASSEMBLY_COMPLETE, swarm_id, 0, swarms[swarm_id].active_count, 0, 0);
     }
     sem_post(&sem_swarms);
 }
@@ -252,19 +733,14 @@ void autodestruct_swarm_drones(int swarm_id) {
     }
     sem_post(&sem_swarms);
 
-    for(int j = 0; j < ASSEMBLY_SIZE; j++) {
-        if(snapshot_ids[j] != 0) {
-            int drone_id = snapshot_ids[j];
-            int drone_port = port_for_drone(BASE_PORT, drone_id);
-            msg_t cmd; memset(&cmd,0,sizeof(cmd));
-            cmd.type = MSG_COMMAND;
-            cmd.swarm_id = swarm_id;
-            cmd.drone_id = drone_id;
-            snprintf(cmd.text,sizeof(cmd.text),"AUTODESTRUCT_ALL");
-            send_msg(center_sock, drone_port, &cmd);
-            printf("[CENTER] Enviando AUTODESTRUCT_ALL a drone %d (puerto %d)\n", drone_id, drone_port);
-        }
-    }
+    int members[MAX_DRONES_PER_SWARM];
+    int nm = live_ids(snapshot_ids, ASSEMBLY_SIZE, members);
+    msg_t cmd; memset(&cmd,0,sizeof(cmd));
+    cmd.type = MSG_COMMAND;
+    cmd.swarm_id = swarm_id;
+    snprintf(cmd.text,sizeof(cmd.text),"AUTODESTRUCT_ALL");
+    send_msg_group(center_sock, BASE_PORT, swarm_id, members, nm, &cmd);
+    LOGI("Enviando AUTODESTRUCT_ALL a los %d drones del swarm %d", nm, swarm_id);
 
     // Comando también al truck para compatibilidad
     msg_t truck_cmd; memset(&truck_cmd,0,sizeof(truck_cmd));
@@ -272,7 +748,7 @@ void autodestruct_swarm_drones(int swarm_id) {
     truck_cmd.swarm_id = swarm_id;
     snprintf(truck_cmd.text,sizeof(truck_cmd.text),"AUTODESTRUCT_ALL");
     int truck_port = port_for_truck(BASE_PORT, swarm_id);
-    send_msg(center_sock, truck_port, &truck_cmd);
+    send_msg_reliable(center_sock, truck_port, &truck_cmd);
 }
 
 // Función auxiliar para verificar si un swarm necesita reconformación
@@ -282,153 +758,367 @@ int swarm_needs_reassembly(int swarm_id) {
             !swarms[swarm_id].is_destroyed);
 }
 
-// Reasigna un drone desde un swarm donante a uno objetivo.
-// Regla: solo se puede donar desde swarms incompletos (no tomar de swarms completos).
-void reassign_one_from(int donor_id, int target_id) {
-    if(donor_id < 0 || donor_id >= NUM_SWARMS) return;
-    if(target_id < 0 || target_id >= NUM_SWARMS) return;
-    if(donor_id == target_id) return;
+// ---------- planificador global de reconformación ----------
+// Una vez por tick se juntan todos los swarms incompletos y se resuelve la
+// consolidación de una vez: con D drones disponibles se completan floor(D/ASSEMBLY_SIZE)
+// swarms, eligiendo como receptores a los que menos drones necesitan, y cada
+// donante se asigna al grupo de receptores (mismo blanco) con menor distancia
+// de vuelo desde su última posición, buscado con el índice de grilla de los blancos.
+// Todo el plan se aplica bajo un único sem_swarms y los mensajes se envían después.
 
-    sem_wait(&sem_reassign_line);
-    sem_wait(&sem_swarms);
+typedef struct {
+    int drone_id;
+    int from, to;
+    double tx, ty;
+    int tid;
+} reassembly_move_t;
 
-    if(swarms[donor_id].is_destroyed || swarms[target_id].is_destroyed) {
-        sem_post(&sem_swarms);
-        sem_post(&sem_reassign_line);
-        return;
-    }
+typedef struct {
+    int swarm;      // swarm donante
+    double cost;    // distancia al grupo receptor más cercano
+} plan_donor_t;
 
-    // target debe estar incompleto; donor debe estar incompleto (>0 y < ASSEMBLY_SIZE)
-    int target_needs = (swarms[target_id].active_count < ASSEMBLY_SIZE);
-    int donor_can_give = (swarms[donor_id].active_count > 0 &&
-                          swarms[donor_id].active_count < ASSEMBLY_SIZE);
+typedef struct {
+    int first, count;   // rango en el arreglo de receptores (ordenados por blanco)
+    int cursor;         // primer receptor del grupo que aún necesita drones
+} plan_group_t;
+
+// Orden de receptores: más drones primero (menos movimientos), luego el que lleva más tiempo esperando
+static int cmp_reassembly_candidates(const void *a, const void *b){
+    const swarm_t *x = &swarms[*(const int*)a], *y = &swarms[*(const int*)b];
+    if(x->active_count != y->active_count) return y->active_count - x->active_count;
+    if(x->reassembly_start != y->reassembly_start) return (x->reassembly_start < y->reassembly_start) ? -1 : 1;
+    return x->swarm_id - y->swarm_id;
+}
 
-    if(!target_needs || !donor_can_give) {
-        sem_post(&sem_swarms);
-        sem_post(&sem_reassign_line);
-        return;
-    }
+static int cmp_by_target(const void *a, const void *b){
+    const swarm_t *x = &swarms[*(const int*)a], *y = &swarms[*(const int*)b];
+    if(x->target_id != y->target_id) return x->target_id - y->target_id;
+    return x->swarm_id - y->swarm_id;
+}
 
-    int drone_id = 0;
-    int donor_slot = -1;
-    for(int j = 0; j < ASSEMBLY_SIZE; j++) {
-        if(swarms[donor_id].drone_global_ids[j] != 0 &&
-           swarms[donor_id].drone_terminated[j] == 0) {
-            drone_id = swarms[donor_id].drone_global_ids[j];
-            donor_slot = j;
+static int cmp_plan_donors(const void *a, const void *b){
+    const plan_donor_t *x = a, *y = b;
+    return (x->cost > y->cost) - (x->cost < y->cost);
+}
+
+// Avanza el cursor del grupo; 0 si ya no le quedan receptores incompletos
+static int plan_group_open(plan_group_t *g, const int *recv){
+    while(g->cursor < g->first + g->count && swarms[recv[g->cursor]].active_count >= ASSEMBLY_SIZE)
+        g->cursor++;
+    return g->cursor < g->first + g->count;
+}
+
+// Los grupos se buscan con el índice de grilla del catálogo por la posición de su blanco
+typedef struct {
+    plan_group_t *groups;
+    const int *recv;
+    const int *group_of;    // grupo de cada blanco (-1 = sin receptores)
+    double x, y;            // posición del donante
+} plan_index_t;
+
+static double plan_group_dist(int t, void *p){
+    plan_index_t *ix = p;
+    int g = ix->group_of[t];
+    if(g < 0 || !plan_group_open(&ix->groups[g], ix->recv)) return INFINITY;
+    return hypot(targets.items[t].x - ix->x, targets.items[t].y - ix->y);
+}
+
+// Últimos grupos abiertos más cercanos a un punto, de menor a mayor distancia. Los grupos
+// solo se cierran, así que el primero de la lista que sigue abierto es el más cercano y
+// los donantes en el mismo punto la reusan; solo si se agota se pide una el doble de larga.
+typedef struct {
+    double x, y;
+    int *t;
+    double *c;
+    int len, pos, want;
+} plan_near_t;
+
+#define PLAN_NEAR_INIT 4
+
+static int plan_near_query(plan_near_t *nr, plan_index_t *ix){
+    int *t = realloc(nr->t, nr->want * sizeof(int));
+    if(!t) return -1;
+    nr->t = t;
+    double *c = realloc(nr->c, nr->want * sizeof(double));
+    if(!c) return -1;
+    nr->c = c;
+    nr->len = targets_nearest(&targets, ix->x, ix->y, plan_group_dist, 1.0, 0, ix, nr->want, nr->t, nr->c);
+    nr->pos = 0;
+    return 0;
+}
+
+// Grupo abierto (con receptores incompletos) más cercano al donante y su distancia en
+// *dist, -1 si no queda ninguno. Los receptores sin blanco (target_id -1, el primer grupo
+// por el orden de cmp_by_target) no están en el índice y se comparan aparte.
+static int nearest_open_group(plan_group_t *groups, int ng, const int *recv, const int *group_of,
+                              plan_near_t *nr, const swarm_t *donor, double *dist){
+    plan_index_t ix = { groups, recv, group_of, donor->pos_x, donor->pos_y };
+    int best = -1;
+    if(nr->want == 0 || nr->x != ix.x || nr->y != ix.y) {
+        nr->x = ix.x;
+        nr->y = ix.y;
+        nr->want = PLAN_NEAR_INIT;
+        if(plan_near_query(nr, &ix) < 0) nr->len = nr->want = 0;
+    }
+    for(;;) {
+        while(nr->pos < nr->len && !plan_group_open(&groups[group_of[nr->t[nr->pos]]], recv)) nr->pos++;
+        if(nr->pos < nr->len) {
+            best = group_of[nr->t[nr->pos]];
+            *dist = nr->c[nr->pos];
             break;
         }
+        if(nr->len < nr->want) break;   // el índice no tiene más grupos abiertos
+        nr->want *= 2;
+        if(plan_near_query(nr, &ix) < 0) { nr->len = nr->want = 0; break; }
     }
-
-    if(drone_id == 0) {
-        sem_post(&sem_swarms);
-        sem_post(&sem_reassign_line);
-        return;
+    if(ng > 0 && swarms[recv[groups[0].first]].target_id < 0 && plan_group_open(&groups[0], recv)) {
+        const swarm_t *rs = &swarms[recv[groups[0].first]];
+        double c = hypot(rs->target_x - donor->pos_x, rs->target_y - donor->pos_y);
+        if(best < 0 || c < *dist) { best = 0; *dist = c; }
     }
+    return best;
+}
 
-    int target_slot = -1;
+// Mueve un drone del donante al receptor (se asume sem_swarms tomado)
+static int move_one_drone(int donor_id, int target_id, reassembly_move_t *mv){
+    int donor_slot = -1, target_slot = -1;
     for(int j = 0; j < ASSEMBLY_SIZE; j++) {
-        if(swarms[target_id].drone_global_ids[j] == 0) {
-            target_slot = j;
+        if(swarms[donor_id].drone_global_ids[j] != 0 && swarms[donor_id].drone_terminated[j] == 0) {
+            donor_slot = j;
             break;
         }
     }
-
-    if(target_slot == -1) {
-        sem_post(&sem_swarms);
-        sem_post(&sem_reassign_line);
-        return;
+    for(int j = 0; j < ASSEMBLY_SIZE; j++) {
+        if(swarms[target_id].drone_global_ids[j] == 0) { target_slot = j; break; }
     }
+    if(donor_slot < 0 || target_slot < 0) return 0;
 
-    // mover: quitar del donante
+    int drone_id = swarms[donor_id].drone_global_ids[donor_slot];
     swarms[donor_id].drone_global_ids[donor_slot] = 0;
     swarms[donor_id].drone_terminated[donor_slot] = 0;
     if(swarms[donor_id].active_count > 0) swarms[donor_id].active_count--;
-    if(swarms[donor_id].active_count < ASSEMBLY_SIZE) {
-        swarms[donor_id].assembled = 0;
-    }
+    if(swarms[donor_id].active_count == 0) swarm_lost(donor_id);
+    swarms[donor_id].assembled = 0;
 
-    // y agregar al objetivo
     swarms[target_id].drone_global_ids[target_slot] = drone_id;
     swarms[target_id].drone_terminated[target_slot] = 0;
     swarms[target_id].active_count++;
-    if(swarms[target_id].active_count >= ASSEMBLY_SIZE) {
-        swarms[target_id].assembled = 0; // permitirá un nuevo ensamblaje->TAKEOFF
-    }
+    swarm_publish(donor_id);
+    swarm_publish(target_id);
 
-    // snapshot de coords del target para asegurarnos de RETARGET correcto
-    double tx = swarms[target_id].target_x;
-    double ty = swarms[target_id].target_y;
-    int    tid = swarms[target_id].target_id;
+    mv->drone_id = drone_id;
+    mv->from = donor_id;
+    mv->to = target_id;
+    mv->tx = swarms[target_id].target_x;
+    mv->ty = swarms[target_id].target_y;
+    mv->tid = swarms[target_id].target_id;
 
-    // ✅ CLAVE: Verificar si el donante ahora necesita reconformación
-    int donor_now_needs_reassembly = swarm_needs_reassembly(donor_id);
-    int donor_already_in_reassembly = swarms[donor_id].in_reassembly;
-
-    printf("[CENTER] Reassigned drone %d from swarm %d (slot %d) to swarm %d (slot %d)\n",
+    LOGI("Reassigned drone %d from swarm %d (slot %d) to swarm %d (slot %d)",
            drone_id, donor_id, donor_slot, target_id, target_slot);
+    journal_append(JEV_REASSIGN, donor_id, drone_id, target_id, mv->tx, mv->ty);
+    return drone_id;
+}
 
-    sem_post(&sem_swarms);
+static int cmp_moves_by_from(const void *a, const void *b){
+    const reassembly_move_t *x = a, *y = b;
+    return x->from - y->from;
+}
+
+static int cmp_moves_by_to(const void *a, const void *b){
+    const reassembly_move_t *x = a, *y = b;
+    return x->to - y->to;
+}
 
-    // Notificar BOTH trucks para evitar estados fantasmas:
-    // 1) El donante sabe que cedió un dron
-    msg_t cmd_d; memset(&cmd_d,0,sizeof(cmd_d));
-    cmd_d.type = MSG_COMMAND;
-    cmd_d.swarm_id = donor_id;
-    snprintf(cmd_d.text, sizeof(cmd_d.text), "REASSIGN_ONE_TO %d", target_id);
-    int donor_truck_port = port_for_truck(BASE_PORT, donor_id);
-    send_msg(center_sock, donor_truck_port, &cmd_d);
-
-    // 2) El receptor recibe/actualiza TARGET y fuerza retargeting del dron reasignado
-    send_target_to_truck_coords(target_id, tx, ty, tid);
-
-    // 3) Aviso directo al dron reasignado para que no "ataque" coordenadas antiguas
-    int drone_port = port_for_drone(BASE_PORT, drone_id);
-    msg_t cmd_dr; memset(&cmd_dr,0,sizeof(cmd_dr));
-    cmd_dr.type = MSG_COMMAND;
-    cmd_dr.swarm_id = target_id;
-    cmd_dr.drone_id = drone_id;
-    snprintf(cmd_dr.text,sizeof(cmd_dr.text),"RETARGET %.1f %.1f %d", tx, ty, tid);
-    send_msg(center_sock, drone_port, &cmd_dr);
-
-    // ✅ NUEVA LÓGICA: Si el donante ahora necesita reconformación, iniciarla
-    if(donor_now_needs_reassembly && !donor_already_in_reassembly) {
-        printf("[CENTER] Donor swarm %d now needs reassembly after donation\n", donor_id);
-        start_reassembly_process(donor_id);
-        // Intentar reconformar inmediatamente en un hilo separado o marcar para proceso posterior
+// Envía a cada truck la lista de ids del rango [first,last) con el prefijo dado,
+// partiendo en varios mensajes si no cabe en un solo texto
+static void send_truck_roster_cmd(int swarm_id, const char *prefix,
+                                  const reassembly_move_t *mv, int first, int last){
+    msg_t cmd; memset(&cmd,0,sizeof(cmd));
+    cmd.type = MSG_COMMAND;
+    cmd.swarm_id = swarm_id;
+    int port = port_for_truck(BASE_PORT, swarm_id);
+
+    int len = snprintf(cmd.text, sizeof(cmd.text), "%s", prefix);
+    int base = len, n = 0;
+    for(int i = first; i < last; i++) {
+        char id[16];
+        int l = snprintf(id, sizeof(id), " %d", mv[i].drone_id);
+        if(len + l >= (int)sizeof(cmd.text)) {
+            send_msg_reliable(center_sock, port, &cmd);
+            len = base;
+            cmd.text[len] = 0;
+            n = 0;
+        }
+        memcpy(cmd.text + len, id, l + 1);
+        len += l;
+        n++;
     }
+    if(n > 0) send_msg_reliable(center_sock, port, &cmd);
+}
 
-    sem_post(&sem_reassign_line);
+static void send_drone_reassign(const reassembly_move_t *mv){
+    msg_t cmd; memset(&cmd,0,sizeof(cmd));
+    cmd.type = MSG_COMMAND;
+    cmd.swarm_id = mv->to;
+    cmd.drone_id = mv->drone_id;
+    snprintf(cmd.text, sizeof(cmd.text), "REASSIGN %d %.1f %.1f %d",
+             mv->to, mv->tx, mv->ty, mv->tid);
+    send_msg_reliable(center_sock, port_for_drone(BASE_PORT, mv->drone_id), &cmd);
 }
 
-// Recorre vecinos incrementales L/R para intentar completar el swarm objetivo
-void reconform_from_neighbors(int target_id) {
-    int step = 1;
-    while(step < NUM_SWARMS) {
-        int l = target_id - step;
-        int r = target_id + step;
-        if(l>=0){
-            sem_wait(&sem_swarms);
-            int need = (swarms[target_id].active_count < ASSEMBLY_SIZE && !swarms[target_id].is_destroyed);
-            sem_post(&sem_swarms);
-            if(!need) {
-                complete_reassembly_process(target_id);
-                return;
-            }
-            reassign_one_from(l, target_id);
+// Un mensaje por dron movido y uno (o pocos, si la lista es larga) por truck afectado:
+//   dron:           "REASSIGN <swarm> <x> <y> <target>"
+//   truck donante:  "RELEASE <id> <id> ..."
+//   truck receptor: "ADOPT <x> <y> <target> <id> <id> ..."
+static void send_reassignment_batch(reassembly_move_t *mv, int nm){
+    for(int i = 0; i < nm; i++) send_drone_reassign(&mv[i]);
+
+    qsort(mv, nm, sizeof(reassembly_move_t), cmp_moves_by_from);
+    for(int i = 0, j; i < nm; i = j) {
+        for(j = i; j < nm && mv[j].from == mv[i].from; j++);
+        send_truck_roster_cmd(mv[i].from, "RELEASE", mv, i, j);
+    }
+
+    qsort(mv, nm, sizeof(reassembly_move_t), cmp_moves_by_to);
+    for(int i = 0, j; i < nm; i = j) {
+        for(j = i; j < nm && mv[j].to == mv[i].to; j++);
+        char prefix[64];
+        snprintf(prefix, sizeof(prefix), "ADOPT %.1f %.1f %d", mv[i].tx, mv[i].ty, mv[i].tid);
+        send_truck_roster_cmd(mv[i].to, prefix, mv, i, j);
+    }
+}
+
+// Devuelve la cantidad de drones movidos en este tick
+int plan_reassembly(void) {
+    int *cand = malloc(NUM_SWARMS * sizeof(int));
+    if(!cand) return 0;
+    int nc = 0, total = 0;
+
+    sem_wait(&sem_reassign_line);
+    sem_wait(&sem_swarms);
+
+    time_t now = time(NULL);
+    for(int i = swarm_lo; i < swarm_hi; i++) {
+        if(!swarm_needs_reassembly(i)) continue;
+        if(!swarms[i].in_reassembly) {
+            swarms[i].in_reassembly = 1;
+            swarms[i].reassembly_start = now;
+            swarm_publish(i);
+            LOGI("Swarm %d inicia proceso de reconformación (timeout: %ds)", i, live_params()->MAX_WAIT_REASSEMBLY);
+            journal_append(JEV_REASSEMBLY_START, i, 0, swarms[i].active_count, 0, 0);
         }
-        if(r<NUM_SWARMS){
-            sem_wait(&sem_swarms);
-            int need = (swarms[target_id].active_count < ASSEMBLY_SIZE && !swarms[target_id].is_destroyed);
-            sem_post(&sem_swarms);
-            if(!need) {
-                complete_reassembly_process(target_id);
-                return;
-            }
-            reassign_one_from(r, target_id);
+        cand[nc++] = i;
+        total += swarms[i].active_count;
+    }
+
+    int k = total / ASSEMBLY_SIZE;  // swarms completos alcanzables
+    if(nc < 2 || k == 0) {
+        sem_post(&sem_swarms);
+        sem_post(&sem_reassign_line);
+        free(cand);
+        return 0;
+    }
+
+    plan_group_t *groups = malloc(k * sizeof(plan_group_t));
+    plan_donor_t *order = malloc((nc - k) * sizeof(plan_donor_t));
+    reassembly_move_t *moves = malloc(total * sizeof(reassembly_move_t));
+    int *group_of = malloc(NUM_TARGETS * sizeof(int));
+    if(!groups || !order || !moves || !group_of) {
+        sem_post(&sem_swarms);
+        sem_post(&sem_reassign_line);
+        free(group_of);
+        free(moves);
+        free(order);
+        free(groups);
+        free(cand);
+        return 0;
+    }
+
+    qsort(cand, nc, sizeof(int), cmp_reassembly_candidates);
+    int *recv = cand, nr = k;
+    int *donors = cand + k, nd = nc - k;
+    qsort(recv, nr, sizeof(int), cmp_by_target);
+
+    // grupos de receptores con el mismo blanco: mismo costo desde cualquier donante
+    int ng = 0;
+    for(int r = 0; r < nr; r++) {
+        if(ng == 0 || swarms[recv[r]].target_id != swarms[recv[groups[ng-1].first]].target_id) {
+            groups[ng].first = r;
+            groups[ng].count = 0;
+            groups[ng].cursor = r;
+            ng++;
+        }
+        groups[ng-1].count++;
+    }
+    for(int t = 0; t < NUM_TARGETS; t++) group_of[t] = -1;
+    for(int g = 0; g < ng; g++) {
+        int tid = swarms[recv[groups[g].first]].target_id;
+        if(tid >= 0 && tid < NUM_TARGETS) group_of[tid] = g;
+    }
+
+    // donantes más cercanos a algún blanco primero; cada uno vacía hacia el grupo abierto más cercano
+    plan_near_t near = { 0 };
+    for(int d = 0; d < nd; d++) {
+        order[d].swarm = donors[d];
+        order[d].cost = 0;
+        nearest_open_group(groups, ng, recv, group_of, &near, &swarms[donors[d]], &order[d].cost);
+    }
+    qsort(order, nd, sizeof(plan_donor_t), cmp_plan_donors);
+
+    int nm = 0;
+    for(int d = 0; d < nd; d++) {
+        int donor = order[d].swarm;
+        int g = -1;
+        double dist;
+        while(swarms[donor].active_count > 0) {
+            // se recalcula el grupo solo cuando el actual se llenó
+            if(g < 0 || swarms[recv[groups[g].cursor]].active_count >= ASSEMBLY_SIZE)
+                g = nearest_open_group(groups, ng, recv, group_of, &near, &swarms[donor], &dist);
+            if(g < 0) break;
+            if(!move_one_drone(donor, recv[groups[g].cursor], &moves[nm])) break;
+            nm++;
         }
-        step++;
     }
+
+    for(int r = 0; r < nr; r++) {
+        swarm_t *sw = &swarms[recv[r]];
+        if(sw->active_count >= ASSEMBLY_SIZE && sw->in_reassembly) {
+            sw->in_reassembly = 0;
+            sw->reassembly_start = 0;
+            sw->assembled = 0; // permite nuevo ensamblaje/TAKEOFF si se completó
+            swarm_publish(recv[r]);
+            LOGI("Swarm %d completó reconformación exitosamente", sw->swarm_id);
+            journal_append(JEV_REASSEMBLY_COMPLETE, sw->swarm_id, 0, sw->active_count, 0, 0);
+        }
+    }
+    for(int d = 0; d < nd; d++) {
+        swarm_t *sw = &swarms[donors[d]];
+        if(sw->active_count == 0) {
+            sw->in_reassembly = 0;
+            sw->reassembly_start = 0;
+            swarm_publish(donors[d]);
+        }
+    }
+
+    if(nm > 0)
+        LOGI("Plan de reconformación: %d incompletos, %d completados, %d drones movidos",
+             nc, nr, nm);
+
+    sem_post(&sem_swarms);
+
+    if(nm > 0) send_reassignment_batch(moves, nm);
+
+    sem_post(&sem_reassign_line);
+
+    free(near.t);
+    free(near.c);
+    free(group_of);
+    free(moves);
+    free(order);
+    free(groups);
+    free(cand);
+    return nm;
 }
 
 // Marca y envía autodestrucción de todos los drones del swarm tras timeout
@@ -438,17 +1128,20 @@ void autodestruct_swarm(int swarm_id) {
     if(swarms[swarm_id].active_count <= 0 || swarms[swarm_id].is_destroyed) {
         swarms[swarm_id].in_reassembly = 0;
         swarms[swarm_id].reassembly_start = 0;
+        swarm_publish(swarm_id);
         sem_post(&sem_swarms);
         return;
     }
 
-    printf("[CENTER] TIMEOUT: Swarm %d no pudo reconformarse en %ds - AUTODESTRUYENDO\n",
-           swarm_id, MAX_WAIT_REASSEMBLY);
+    LOGW("TIMEOUT: Swarm %d no pudo reconformarse en %ds - AUTODESTRUYENDO",
+           swarm_id, live_params()->MAX_WAIT_REASSEMBLY);
+    journal_append(JEV_REASSEMBLY_TIMEOUT, swarm_id, 0, swarms[swarm_id].active_count, 0, 0);
 
     swarms[swarm_id].is_destroyed = 1;
     swarms[swarm_id].in_reassembly = 0;
     swarms[swarm_id].reassembly_start = 0;
     swarms[swarm_id].assembled = 0;
+    swarm_publish(swarm_id);
 
     sem_post(&sem_swarms);
 
@@ -460,77 +1153,35 @@ void autodestruct_swarm(int swarm_id) {
             int did = swarms[swarm_id].drone_global_ids[j];
             swarms[swarm_id].drone_global_ids[j] = 0;
             swarms[swarm_id].drone_terminated[j] = 1;
-            printf("[CENTER] Swarm %d autodestruye drone %d por timeout\n", swarm_id, did);
+            LOGI("Swarm %d autodestruye drone %d por timeout", swarm_id, did);
              // limpieza artillería inmediata
         }
     }
     swarms[swarm_id].active_count = 0;
+    swarm_lost(swarm_id);
+    swarm_publish(swarm_id);
     sem_post(&sem_swarms);
 }
 
-// ✅ NUEVA FUNCIÓN: Verifica si hay swarms donantes que ahora necesitan reconformación
-void check_donor_swarms_for_reassembly() {
-    for(int i = 0; i < NUM_SWARMS; i++) {
-        sem_wait(&sem_swarms);
-        int needs_reassembly = swarm_needs_reassembly(i);
-        int already_in_reassembly = swarms[i].in_reassembly;
-        sem_post(&sem_swarms);
-
-        if(needs_reassembly && !already_in_reassembly) {
-            printf("[CENTER] Detected donor swarm %d needs reassembly - starting process\n", i);
-            start_reassembly_process(i);
-            try_reconform_or_autodestruct(i);
-        }
-    }
-}
-
-// Revisa periódicamente timeouts SOLO si el swarm está efectivamente en reconformación
+// Autodestruye los swarms que siguen incompletos tras MAX_WAIT_REASSEMBLY
+// (la reconformación en sí la resuelve plan_reassembly en el mismo tick)
 void check_reassembly_timeouts() {
-    for(int i = 0; i < NUM_SWARMS; i++) {
+    time_t now = time(NULL);
+    int max_wait = live_params()->MAX_WAIT_REASSEMBLY;
+    for(int i = swarm_lo; i < swarm_hi; i++) {
         sem_wait(&sem_swarms);
-        int is_incomplete = (swarms[i].active_count > 0 && swarms[i].active_count < ASSEMBLY_SIZE);
-        int in_reassembly = swarms[i].in_reassembly;
-        int is_destroyed = swarms[i].is_destroyed;
-        time_t started = swarms[i].reassembly_start;
+        int expired = swarm_needs_reassembly(i) && swarms[i].in_reassembly &&
+                      (now - swarms[i].reassembly_start >= max_wait + 2); // margen de gracia
         sem_post(&sem_swarms);
 
-        if(is_incomplete && !is_destroyed) {
-            if(in_reassembly) {
-                time_t elapsed = time(NULL) - started;
-                int should_timeout = (elapsed >= (MAX_WAIT_REASSEMBLY + 2)); // margen de gracia
-                if(should_timeout) {
-                    autodestruct_swarm(i);
-                } else {
-                    // mientras no haya timeout, intenta reconformar si existen donantes incompletos
-                    int can_try = 0;
-                    sem_wait(&sem_swarms);
-                    for(int k=0;k<NUM_SWARMS;k++){
-                        if(k==i) continue;
-                        if(!swarms[k].is_destroyed &&
-                           swarms[k].active_count > 0 &&
-                           swarms[k].active_count < ASSEMBLY_SIZE) { can_try=1; break; }
-                    }
-                    sem_post(&sem_swarms);
-                    if(can_try) try_reconform_or_autodestruct(i);
-                }
-            } else {
-                // ✅ El swarm está incompleto pero aún no ha declarado IN_REASSEMBLY
-                // Esto puede pasar con swarms donantes - iniciar su proceso
-                printf("[CENTER] Swarm %d is incomplete but not in reassembly - starting process\n", i);
-                start_reassembly_process(i);
-                try_reconform_or_autodestruct(i);
-            }
-        }
+        if(expired) autodestruct_swarm(i);
     }
-    
-    // ✅ Verificar swarms donantes que puedan necesitar reconformación
-    check_donor_swarms_for_reassembly();
 }
 
 int all_drones_finished(){
     int finished = 1;
     sem_wait(&sem_swarms);
-    for(int i=0;i<NUM_SWARMS;i++){
+    for(int i = swarm_lo; i < swarm_hi; i++){
         if(swarms[i].active_count > 0){
             finished = 0;
             break;
@@ -540,248 +1191,1478 @@ int all_drones_finished(){
     return finished;
 }
 
-void try_reconform_or_autodestruct(int swarm_id) {
-    sem_wait(&sem_swarms);
-    if(swarms[swarm_id].is_destroyed) {
-        sem_post(&sem_swarms);
-        return;
+// ---------- centro particionado (CENTER_SHARDS) ----------
+// Con CENTER_SHARDS=n el centro corre como n procesos. El shard k atiende los swarms
+// [swarm_lo, swarm_hi) en port_for_center_shard(BASE_PORT, k): lanza sus trucks, recibe
+// los mensajes de sus drones y resuelve su reconformación y sus re-asignaciones de blanco.
+// Entre shards viajan MSG_COMMAND:
+//   "SYNC k vivos sid:n:tid:x:y ..."  k>0 -> 0 cada tick: drones vivos y swarms que siguen
+//                                     incompletos después del plan local
+//   "GIVE donante receptor n"         0 -> shard del donante: ceder hasta n drones
+//   "ADOPT receptor id id ..."        shard del donante -> shard del receptor
+//   "TARGET_DESTROYED tid"            al resto de los shards: marca el blanco y redirige
+//   "EXIT"                            0 -> k>0: la misión terminó
+// El shard 0 completa swarms con los incompletos de todos los shards (como plan_reassembly)
+// y decide el fin de la misión cuando ningún shard tiene drones vivos.
+#define SHARD_MAX_CAND 8
+#define SHARD_REPORT_TTL 3.0   // segundos: un SYNC más viejo no cuenta
+
+typedef struct { int shard, sid, count, tid; double x, y; } shard_cand_t;
+
+typedef struct {
+    double last_seen;       // now_mono del último SYNC, 0 si nunca llegó
+    int alive;              // drones vivos en el shard
+    int ncand;
+    shard_cand_t cand[SHARD_MAX_CAND];
+} shard_report_t;
+
+static shard_report_t shard_reports[MAX_CENTER_SHARDS];
+sem_t sem_shards;                // protege shard_reports
+volatile int shard_exit = 0;     // EXIT recibido del shard 0
+
+static void shard_send(int shard, const char *text){
+    msg_t m; memset(&m,0,sizeof(m));
+    m.type = MSG_COMMAND;
+    snprintf(m.text, sizeof(m.text), "%s", text);
+    send_msg_reliable(center_sock, port_for_center_shard(BASE_PORT, shard), &m);
+}
+
+// Drones vivos del shard y sus swarms incompletos en reconformación (se asume sem_swarms tomado)
+static int shard_local_state(shard_cand_t *out, int max, int *alive){
+    int n = 0;
+    *alive = 0;
+    for(int i = swarm_lo; i < swarm_hi; i++) {
+        swarm_t *s = &swarms[i];
+        *alive += s->active_count;
+        if(n < max && s->in_reassembly && swarm_needs_reassembly(i) && s->target_id >= 0) {
+            shard_cand_t c = { shard_id, i, s->active_count, s->target_id, s->pos_x, s->pos_y };
+            out[n++] = c;
+        }
     }
-    sem_post(&sem_swarms);
+    return n;
+}
 
-    int can_reconform = 0;
+// Incorpora al swarm propio recv drones cedidos por otro swarm: REASSIGN a cada uno con el
+// blanco vigente del receptor y ADOPT a su truck. Los que ya no caben (el receptor se
+// completó o se autodestruyó mientras tanto) se autodestruyen.
+static void shard_adopt(int recv, const int *ids, int n){
+    reassembly_move_t mv[MAX_DRONES_PER_SWARM];
+    int rejected[MAX_DRONES_PER_SWARM];
+    int nm = 0, nr = 0;
     sem_wait(&sem_swarms);
-    for(int i=0; i<NUM_SWARMS; i++) {
-        if(i == swarm_id) continue;
-        if(swarms[i].active_count > 0 && swarms[i].active_count < ASSEMBLY_SIZE && !swarms[i].is_destroyed) {
-            can_reconform = 1;
-            break;
+    swarm_t *s = &swarms[recv];
+    for(int k = 0; k < n && k < MAX_DRONES_PER_SWARM; k++) {
+        int slot = -1;
+        if(!s->is_destroyed && s->active_count < ASSEMBLY_SIZE)
+            for(int j = 0; j < ASSEMBLY_SIZE; j++)
+                if(s->drone_global_ids[j] == 0) { slot = j; break; }
+        if(slot < 0) { rejected[nr++] = ids[k]; continue; }
+        s->drone_global_ids[slot] = ids[k];
+        s->drone_terminated[slot] = 0;
+        s->active_count++;
+        reassembly_move_t m = { ids[k], -1, recv, s->target_x, s->target_y, s->target_id };
+        mv[nm++] = m;
+        LOGI("Adopted drone %d into swarm %d (slot %d)", ids[k], recv, slot);
+    }
+    if(nm > 0) {
+        if(s->active_count >= ASSEMBLY_SIZE && s->in_reassembly) {
+            s->in_reassembly = 0;
+            s->reassembly_start = 0;
+            s->assembled = 0; // permite nuevo ensamblaje/TAKEOFF si se completó
+            LOGI("Swarm %d completó reconformación exitosamente", recv);
+            journal_append(JEV_REASSEMBLY_COMPLETE, recv, 0, s->active_count, 0, 0);
         }
+        swarm_publish(recv);
     }
     sem_post(&sem_swarms);
 
-    if(can_reconform) {
-        printf("[CENTER] Swarm %d intenta reconformarse...\n", swarm_id);
-        reconform_from_neighbors(swarm_id);
+    for(int k = 0; k < nm; k++) send_drone_reassign(&mv[k]);
+    if(nm > 0) {
+        char prefix[64];
+        snprintf(prefix, sizeof(prefix), "ADOPT %.1f %.1f %d", mv[0].tx, mv[0].ty, mv[0].tid);
+        send_truck_roster_cmd(recv, prefix, mv, 0, nm);
+    }
+    for(int k = 0; k < nr; k++) {
+        LOGW("Drone %d cedido al swarm %d no tiene lugar: AUTODESTRUCT_ALL", rejected[k], recv);
+        msg_t cmd; memset(&cmd,0,sizeof(cmd));
+        cmd.type = MSG_COMMAND;
+        cmd.drone_id = rejected[k];
+        snprintf(cmd.text, sizeof(cmd.text), "AUTODESTRUCT_ALL");
+        send_msg_reliable(center_sock, port_for_drone(BASE_PORT, rejected[k]), &cmd);
+    }
+}
 
-        sem_wait(&sem_swarms);
-        int completed = (swarms[swarm_id].active_count >= ASSEMBLY_SIZE && !swarms[swarm_id].is_destroyed);
-        sem_post(&sem_swarms);
+// Cede hasta n drones del swarm propio donor al swarm recv (de este u otro shard)
+static void shard_give(int donor, int recv, int n){
+    if(!swarm_owned(donor) || recv < 0 || recv >= NUM_SWARMS || n <= 0) return;
+    reassembly_move_t mv[MAX_DRONES_PER_SWARM];
+    int ids[MAX_DRONES_PER_SWARM];
+    int nm = 0;
 
-        if(completed) {
-            complete_reassembly_process(swarm_id);
+    sem_wait(&sem_reassign_line);
+    sem_wait(&sem_swarms);
+    swarm_t *s = &swarms[donor];
+    if(s->in_reassembly && !s->is_destroyed) {
+        for(int j = 0; j < ASSEMBLY_SIZE && nm < n; j++) {
+            if(s->drone_global_ids[j] == 0 || s->drone_terminated[j]) continue;
+            ids[nm] = s->drone_global_ids[j];
+            mv[nm].drone_id = ids[nm];
+            mv[nm].from = donor;
+            mv[nm].to = recv;
+            s->drone_global_ids[j] = 0;
+            if(s->active_count > 0) s->active_count--;
+            journal_append(JEV_REASSIGN, donor, ids[nm], recv, 0, 0);
+            nm++;
+        }
+        if(nm > 0) {
+            s->assembled = 0;
+            if(s->active_count == 0) {
+                s->in_reassembly = 0;
+                s->reassembly_start = 0;
+                swarm_lost(donor);
+            }
+            swarm_publish(donor);
         }
-    } else {
-        printf("[CENTER] No hay enjambres disponibles para reconformar swarm %d - esperando timeout\n", swarm_id);
     }
-}
+    sem_post(&sem_swarms);
 
-void *listener_thread(void *arg) {
-    (void)arg;
-    struct sockaddr_in from;
-    msg_t m;
-    while(1){
-        if(recv_msg(center_sock,&m,&from)<=0) {
-            usleep(100000);
-            continue;
+    if(nm > 0) {
+        int to_shard = center_shard_of_swarm(recv);
+        LOGI("Swarm %d cede %d drones al swarm %d (shard %d)", donor, nm, recv, to_shard);
+        send_truck_roster_cmd(donor, "RELEASE", mv, 0, nm);
+        if(to_shard == shard_id) shard_adopt(recv, ids, nm);
+        else {
+            char text[MAX_MSG];
+            int len = snprintf(text, sizeof(text), "ADOPT %d", recv);
+            for(int k = 0; k < nm; k++) len += snprintf(text + len, sizeof(text) - len, " %d", ids[k]);
+            shard_send(to_shard, text);
         }
+    }
+    sem_post(&sem_reassign_line);
+}
 
-        if(m.type==MSG_HELLO) {
-            int gid = m.drone_id;
-            int sid = m.swarm_id;
+static int cmp_shard_cands(const void *a, const void *b){
+    const shard_cand_t *x = a, *y = b;
+    if(x->count != y->count) return y->count - x->count;
+    return x->sid - y->sid;
+}
 
-            sem_wait(&sem_swarms);
-            if(!swarms[sid].is_destroyed) {
-                int found = 0;
-                for(int j=0;j<ASSEMBLY_SIZE;j++){
-                    if(swarms[sid].drone_global_ids[j]==gid) { found=1; break; }
-                }
-                if(!found){
-                    for(int j=0;j<ASSEMBLY_SIZE;j++){
-                        if(swarms[sid].drone_global_ids[j]==0){
-                            swarms[sid].drone_global_ids[j]=gid;
-                            swarms[sid].drone_terminated[j]=0;
-                            break;
-                        }
+// Shard 0: con D drones en swarms incompletos de todos los shards se completan
+// floor(D/ASSEMBLY_SIZE), los que más drones tienen; cada receptor toma drones de los
+// donantes más cercanos a su blanco. Tras emitir cesiones espera dos ticks: los SYNC que
+// ya estaban en vuelo no las reflejan.
+static void shard_coordinate(void){
+    static int cooldown = 0;
+    if(cooldown > 0) { cooldown--; return; }
+
+    shard_cand_t all[MAX_CENTER_SHARDS * SHARD_MAX_CAND];
+    int alive, nc, total = 0;
+    sem_wait(&sem_swarms);
+    nc = shard_local_state(all, SHARD_MAX_CAND, &alive);
+    sem_post(&sem_swarms);
+    double now = now_mono();
+    sem_wait(&sem_shards);
+    for(int k = 1; k < center_shards(); k++) {
+        const shard_report_t *r = &shard_reports[k];
+        if(r->last_seen == 0 || now - r->last_seen > SHARD_REPORT_TTL) continue;
+        memcpy(all + nc, r->cand, r->ncand * sizeof(shard_cand_t));
+        nc += r->ncand;
+    }
+    sem_post(&sem_shards);
+    for(int c = 0; c < nc; c++) total += all[c].count;
+
+    int k = total / ASSEMBLY_SIZE;  // swarms completos alcanzables
+    if(nc < 2 || k == 0) return;
+
+    qsort(all, nc, sizeof(shard_cand_t), cmp_shard_cands);
+    shard_cand_t *donors = all + k;
+    int nd = nc - k, moved = 0, across = 0;
+    for(int r = 0; r < k; r++) {
+        int need = ASSEMBLY_SIZE - all[r].count;
+        double tx = targets.items[all[r].tid].x, ty = targets.items[all[r].tid].y;
+        while(need > 0) {
+            int best = -1;
+            double best_cost = 0;
+            for(int d = 0; d < nd; d++) {
+                if(donors[d].count == 0) continue;
+                double c = hypot(tx - donors[d].x, ty - donors[d].y);
+                if(best < 0 || c < best_cost) { best = d; best_cost = c; }
+            }
+            if(best < 0) break;
+            shard_cand_t *d = &donors[best];
+            int n = d->count < need ? d->count : need;
+            if(d->shard == 0) shard_give(d->sid, all[r].sid, n);
+            else {
+                char text[64];
+                snprintf(text, sizeof(text), "GIVE %d %d %d", d->sid, all[r].sid, n);
+                shard_send(d->shard, text);
+            }
+            d->count -= n;
+            need -= n;
+            moved += n;
+            if(d->shard != all[r].shard) across += n;
+        }
+    }
+    if(moved > 0) {
+        LOGI("Plan entre shards: %d incompletos, %d a completar, %d drones cedidos (%d entre shards)",
+             nc, k, moved, across);
+        cooldown = 2;
+    }
+}
+
+// Shard k>0: estado para el coordinador (sin confirmación: se repite cada tick)
+static void shard_report(void){
+    shard_cand_t cand[SHARD_MAX_CAND];
+    int alive;
+    sem_wait(&sem_swarms);
+    int nc = shard_local_state(cand, SHARD_MAX_CAND, &alive);
+    sem_post(&sem_swarms);
+
+    msg_t m; memset(&m,0,sizeof(m));
+    m.type = MSG_COMMAND;
+    int len = snprintf(m.text, sizeof(m.text), "SYNC %d %d", shard_id, alive);
+    for(int c = 0; c < nc && len < (int)sizeof(m.text) - 48; c++)
+        len += snprintf(m.text + len, sizeof(m.text) - len, " %d:%d:%d:%.1f:%.1f",
+                        cand[c].sid, cand[c].count, cand[c].tid, cand[c].x, cand[c].y);
+    send_msg(center_sock, port_for_center_shard(BASE_PORT, 0), &m);
+}
+
+// Un tick del centro particionado: el shard 0 coordina y los demás le informan
+void shard_tick(void){
+    if(center_shards() <= 1) return;
+    if(shard_id == 0) shard_coordinate();
+    else shard_report();
+}
+
+// Rango [lo, hi) de swarms del shard k
+void shard_range(int k, int *lo, int *hi){
+    *lo = NUM_SWARMS;
+    *hi = 0;
+    for(int i = 0; i < NUM_SWARMS; i++)
+        if(center_shard_of_swarm(i) == k) {
+            if(i < *lo) *lo = i;
+            *hi = i + 1;
+        }
+}
+
+// Shard 0: todos los demás informaron, en un SYNC reciente, que no les quedan drones
+int shards_finished(void){
+    double now = now_mono();
+    int done = 1;
+    sem_wait(&sem_shards);
+    for(int k = 1; k < center_shards(); k++) {
+        const shard_report_t *r = &shard_reports[k];
+        if(r->last_seen == 0 || now - r->last_seen > SHARD_REPORT_TTL || r->alive > 0) done = 0;
+    }
+    sem_post(&sem_shards);
+    return done;
+}
+
+static void shard_broadcast_target_destroyed(int tid){
+    char text[32];
+    snprintf(text, sizeof(text), "TARGET_DESTROYED %d", tid);
+    for(int k = 0; k < center_shards(); k++)
+        if(k != shard_id) shard_send(k, text);
+}
+
+// Mensajes de otros shards
+static void shard_dispatch(const msg_view_t *m){
+    int a, b, n, used;
+    if(sscanf(m->text, "SYNC %d %d%n", &a, &b, &used) == 2) {
+        if(shard_id != 0 || a <= 0 || a >= center_shards()) return;
+        shard_report_t r;
+        memset(&r, 0, sizeof(r));
+        r.last_seen = now_mono();
+        r.alive = b;
+        const char *p = m->text + used;
+        shard_cand_t c;
+        while(r.ncand < SHARD_MAX_CAND &&
+              sscanf(p, " %d:%d:%d:%lf:%lf%n", &c.sid, &c.count, &c.tid, &c.x, &c.y, &used) == 5) {
+            p += used;
+            if(c.sid < 0 || c.sid >= NUM_SWARMS || c.tid < 0 || c.tid >= NUM_TARGETS ||
+               c.count <= 0 || c.count >= ASSEMBLY_SIZE) continue;
+            c.shard = a;
+            r.cand[r.ncand++] = c;
+        }
+        sem_wait(&sem_shards);
+        shard_reports[a] = r;
+        sem_post(&sem_shards);
+    }
+    else if(sscanf(m->text, "GIVE %d %d %d", &a, &b, &n) == 3) {
+        shard_give(a, b, n);
+    }
+    else if(sscanf(m->text, "ADOPT %d%n", &a, &used) == 1 && swarm_owned(a)) {
+        int ids[MAX_DRONES_PER_SWARM], nid = 0;
+        const char *p = m->text + used;
+        while(nid < MAX_DRONES_PER_SWARM && sscanf(p, "%d%n", &ids[nid], &used) == 1) {
+            p += used;
+            nid++;
+        }
+        if(nid > 0) shard_adopt(a, ids, nid);
+    }
+    else if(sscanf(m->text, "TARGET_DESTROYED %d", &a) == 1 && a >= 0 && a < NUM_TARGETS) {
+        retarget_t *rt = NULL;
+        int nrt = 0;
+        sem_wait(&sem_swarms);
+        if(!targets.items[a].destroyed) {
+            LOGI("* BLANCO %d DESTRUIDO (informado por otro shard) *", a);
+            rt = malloc((targets.items[a].n_swarms + 1) * sizeof(retarget_t));
+            nrt = mark_target_destroyed(a, -1, rt);
+        }
+        sem_post(&sem_swarms);
+        send_retargets(rt, nrt);
+        free(rt);
+    }
+    else if(strcmp(m->text, "EXIT") == 0) {
+        shard_exit = 1;
+    }
+}
+
+// Despacha un mensaje recibido por el centro (separado del bucle para poder medirlo)
+void dispatch_message(const msg_view_t *m, struct sockaddr_in *from) {
+    if(m->type==MSG_PING) {
+        // eco inmediato: como el listener es FIFO, el PONG confirma que todo
+        // lo recibido antes ya fue procesado (usado por loadgen)
+        send_view(center_sock, ntohs(from->sin_port), m);
+    }
+    else if((m->type==MSG_HELLO || m->type==MSG_STATUS) && !swarm_owned(m->swarm_id)) {
+        // inválido, o de un swarm de otro shard
+        LOGW("Mensaje con swarm inválido %d (drone %d): %s", m->swarm_id, m->drone_id, m->text);
+    }
+    else if(m->type==MSG_COMMAND) {
+        shard_dispatch(m);
+    }
+    else if(m->type==MSG_HELLO) {
+        int gid = m->drone_id;
+        int sid = m->swarm_id;
+
+        sem_wait(&sem_swarms);
+        if(!swarms[sid].is_destroyed) {
+            int found = 0;
+            for(int j=0;j<ASSEMBLY_SIZE;j++){
+                if(swarms[sid].drone_global_ids[j]==gid) { found=1; break; }
+            }
+            if(!found){
+                for(int j=0;j<ASSEMBLY_SIZE;j++){
+                    if(swarms[sid].drone_global_ids[j]==0){
+                        swarms[sid].drone_global_ids[j]=gid;
+                        swarms[sid].drone_terminated[j]=0;
+                        break;
                     }
                 }
+                swarm_publish(sid);
+            }
+        }
+        sem_post(&sem_swarms);
+
+        LOGI("HELLO drone %d (swarm %d): %s", gid, sid, m->text);
+        journal_append(JEV_HELLO, sid, gid, 0, 0, 0);
+    }
+    else if(m->type==MSG_STATUS) {
+        // POS e IN_ASSEMBLY llegan cada 100ms por dron: solo en nivel DEBUG
+        if(strncmp(m->text,"POS ",4)==0 || strcmp(m->text,"IN_ASSEMBLY")==0)
+            LOGD("STATUS swarm:%d drone:%d -> %s", m->swarm_id, m->drone_id, m->text);
+        else
+            LOGI("STATUS swarm:%d drone:%d -> %s", m->swarm_id, m->drone_id, m->text);
+
+        if(strncmp(m->text,"POS ",4)==0){
+            double x, y;
+            if(sscanf(m->text + 4, "%lf %lf", &x, &y) == 2){
+                sem_wait(&sem_swarms);
+                swarms[m->swarm_id].pos_x = x;
+                swarms[m->swarm_id].pos_y = y;
+                sem_post(&sem_swarms);
+            }
+        }
+        // antes que la rama genérica de "DETONATED", que también la contiene
+        else if(strstr(m->text,"ARRIVED_DETONATED")){
+            // Un dron llegó y detonó -> marcar blanco destruido y redirigir a los que aún van hacia él
+            retarget_t *rt = NULL;
+            int nrt = 0, destroyed_tid = -1;
+            sem_wait(&sem_swarms);
+            if(!swarms[m->swarm_id].is_destroyed) {
+                // "ARRIVED_DETONATED <tid>": el swarm pudo ser redirigido mientras el dron llegaba
+                int tid = swarms[m->swarm_id].target_id;
+                sscanf(m->text, "ARRIVED_DETONATED %d", &tid);
+                if(tid == swarms[m->swarm_id].target_id) swarms[m->swarm_id].target_destroyed = 1;
+                if(tid >= 0 && tid < NUM_TARGETS && !targets.items[tid].destroyed) {
+                    LOGI("* BLANCO %d DESTRUIDO por drone %d *", tid, m->drone_id);
+                    journal_append(JEV_TARGET_DESTROYED, m->swarm_id, m->drone_id, tid, 0, 0);
+                    rt = malloc((targets.items[tid].n_swarms + 1) * sizeof(retarget_t));
+                    nrt = mark_target_destroyed(tid, m->swarm_id, rt);
+                    destroyed_tid = tid;
+                }
+                remove_drone_from_swarm(m->swarm_id, m->drone_id);
+                swarm_publish(m->swarm_id);
+                journal_append(JEV_TERMINATED, m->swarm_id, m->drone_id, TERM_DETONATED, 0, 0);
             }
             sem_post(&sem_swarms);
+            send_retargets(rt, nrt);
+            free(rt);
+            if(destroyed_tid >= 0) shard_broadcast_target_destroyed(destroyed_tid);
+        }
+        else if(strstr(m->text,"DETONATED") || strstr(m->text,"FUEL_ZERO_AUTODESTRUCT") ||
+           strstr(m->text,"LINK_PERMANENT_LOSS") || strstr(m->text,"SHOT_DOWN_BY_ARTILLERY") ||
+           strstr(m->text,"CAMERA_AUTODESTRUCT")){
+            sem_wait(&sem_swarms);
+            int found_swarm = remove_drone_from_swarm_by_id(m->drone_id);
+            if(found_swarm >= 0) {
+                LOGI("Drone %d del swarm %d terminado. Activos restantes: %d",
+                       m->drone_id, found_swarm, swarms[found_swarm].active_count);
+                journal_append(JEV_TERMINATED, found_swarm, m->drone_id,
+                               term_cause_from_text(m->text), 0, 0);
+            }
+            sem_post(&sem_swarms);
+             // limpieza en artillería (Error 6)
+        }
+        else if(strstr(m->text,"CAMERA_REPORTED")){
+            sem_wait(&sem_swarms);
+            if(!swarms[m->swarm_id].is_destroyed && !swarms[m->swarm_id].camera_reported){
+                swarm_t *sw = &swarms[m->swarm_id];
+                sw->camera_reported = 1;
+
+                // Contar cuántos drones del enjambre llegaron efectivamente al blanco
+                // (los que no fueron terminados antes de llegar)
+                int drones_that_attacked = ASSEMBLY_SIZE - sw->active_count;
+
+                // Determinar estado del blanco basándose en efectividad del ataque
+                const char* target_status_str;
+                if(drones_that_attacked >= ASSEMBLY_SIZE-1) {
+                    target_status_str = "DESTRUIDO";           // Enjambre completo = destrucción total
+                } else if(drones_that_attacked >= 2) {
+                    target_status_str = "PARCIALMENTE_DESTRUIDO"; // 2+ drones = daño parcial
+                } else {
+                    target_status_str = "ENTERO";              // 1 drone = sin daño significativo
+                }
+                int tid = sw->target_id;
+                double tx = sw->target_x, ty = sw->target_y;
+
+                // el CAMERA_AUTODESTRUCT posterior ya no lo encuentra en el swarm: la baja
+                // queda en el diario aquí para que el replay también lo dé por muerto
+                remove_drone_from_swarm(m->swarm_id, m->drone_id);
+                swarm_publish(m->swarm_id);
+                journal_append(JEV_CAMERA_REPORT, m->swarm_id, m->drone_id, drones_that_attacked, tx, ty);
+                journal_append(JEV_TERMINATED, m->swarm_id, m->drone_id, TERM_CAMERA, 0, 0);
+                sem_post(&sem_swarms);
 
-            printf("[CENTER] HELLO drone %d (swarm %d): %s\n", gid, sid, m.text);
+                LOGI("* REPORTE DE CAMARA *");
+                LOGI("* BLANCO %d: %s (%d drones atacaron) *", tid, target_status_str, drones_that_attacked);
+            } else {
+                sem_post(&sem_swarms);
+            }
         }
-        else if(m.type==MSG_STATUS) {
-            printf("[CENTER] STATUS swarm:%d drone:%d -> %s\n", m.swarm_id, m.drone_id, m.text);
+        else if(strstr(m->text,"IN_ASSEMBLY")){
+            sem_wait(&sem_swarms);
+            if(!swarms[m->swarm_id].is_destroyed) {
+                int count = 0;
+                for(int j=0;j<ASSEMBLY_SIZE;j++)
+                    if(swarms[m->swarm_id].drone_global_ids[j]!=0) count++;
+                if(count==ASSEMBLY_SIZE && swarms[m->swarm_id].assembled == 0){
+                    swarms[m->swarm_id].assembled = 1;
+                    swarm_publish(m->swarm_id);
+                }
+                int assembled_now = (swarms[m->swarm_id].assembled == 1);
+                sem_post(&sem_swarms);
 
-            if(strstr(m.text,"DETONATED") || strstr(m.text,"FUEL_ZERO_AUTODESTRUCT") ||
-               strstr(m.text,"LINK_PERMANENT_LOSS") || strstr(m.text,"SHOT_DOWN_BY_ARTILLERY") ||
-               strstr(m.text,"CAMERA_AUTODESTRUCT")){
-                sem_wait(&sem_swarms);
-                int found_swarm = remove_drone_from_swarm_by_id(m.drone_id);
-                if(found_swarm >= 0) {
-                    printf("[CENTER] Drone %d del swarm %d terminado. Activos restantes: %d\n",
-                           m.drone_id, found_swarm, swarms[found_swarm].active_count);
+                if(assembled_now){
+                    LOGI("Swarm %d assembled and ready -> TAKEOFF", m->swarm_id);
+                    send_takeoff(m->swarm_id);
+
+                    sem_wait(&sem_swarms);
+                    swarms[m->swarm_id].assembled = 2; // TAKEOFF enviado
+                    swarm_publish(m->swarm_id);
+                    sem_post(&sem_swarms);
                 }
+            } else {
                 sem_post(&sem_swarms);
-                 // limpieza en artillería (Error 6)
             }
-            else if(strstr(m.text,"ARRIVED_DETONATED")){
-                // Un dron llegó y detonó -> marcar blanco destruido del swarm correspondiente
+        }
+        else if(strstr(m->text,"IN_REASSEMBLY")){
+            sem_wait(&sem_swarms);
+            int need = (swarms[m->swarm_id].active_count < ASSEMBLY_SIZE &&
+                       swarms[m->swarm_id].active_count > 0 &&
+                       !swarms[m->swarm_id].is_destroyed);
+            int already_in_reassembly = swarms[m->swarm_id].in_reassembly;
+            sem_post(&sem_swarms);
+
+            // el plan se resuelve en el próximo tick de plan_reassembly
+            if(need && !already_in_reassembly){
+                start_reassembly_process(m->swarm_id);
+            }
+        }
+    }
+    else if(m->type==MSG_ARTILLERY){
+        LOGI("ARTILLERY MSG: %s", m->text);
+        if(strstr(m->text,"SHOT_DOWN")){
+            int did;
+            if(sscanf(m->text,"DRONE %d",&did)==1){
                 sem_wait(&sem_swarms);
-                if(!swarms[m.swarm_id].is_destroyed) {
-                    swarms[m.swarm_id].target_destroyed = 1;
-                    remove_drone_from_swarm(m.swarm_id, m.drone_id);
-                    printf("[CENTER] * BLANCO %d DESTRUIDO por drone %d *\n",
-                           swarms[m.swarm_id].target_id, m.drone_id);
+                int found_swarm = remove_drone_from_swarm_by_id(did);
+                if(found_swarm >= 0) {
+                    LOGI("Drone %d removido del swarm %d por artillería", did, found_swarm);
+                    journal_append(JEV_TERMINATED, found_swarm, did, TERM_ARTILLERY, 0, 0);
                 }
                 sem_post(&sem_swarms);
                 
             }
-          
-else if(strstr(m.text,"CAMERA_REPORTED")){
-        
-    sem_wait(&sem_swarms);
-    if(!swarms[m.swarm_id].is_destroyed && !swarms[m.swarm_id].camera_reported){
-        swarms[m.swarm_id].camera_reported = 1;
-        
-        // Contar cuántos drones del enjambre llegaron efectivamente al blanco
-        // (los que no fueron terminados antes de llegar)
-       int drones_that_attacked = 5 - swarms[m.swarm_id].active_count;
-        
-        
-        
-        
-        // Determinar estado del blanco basándose en efectividad del ataque
-        const char* target_status_str;
-        if(drones_that_attacked >= ASSEMBLY_SIZE-1) {
-            target_status_str = "DESTRUIDO";           // Enjambre completo = destrucción total
-        } else if(drones_that_attacked >= 2) {
-            target_status_str = "PARCIALMENTE_DESTRUIDO"; // 2+ drones = daño parcial
-        } else {
-            target_status_str = "ENTERO";              // 1 drone = sin daño significativo
         }
-        
-        remove_drone_from_swarm(m.swarm_id, m.drone_id);
+    }
+}
+
+// Comando directo al grupo de cada swarm con drones vivos; devuelve a cuántos swarms.
+// Sin reliable va un único datagrama por swarm y no queda nada pendiente de ACK.
+static int broadcast_to_swarms(const char *text, int reliable){
+    int notified = 0;
+    for(int i = swarm_lo; i < swarm_hi; i++){
+        int members[MAX_DRONES_PER_SWARM], nm = 0;
+        sem_wait(&sem_swarms);
+        if(!swarms[i].is_destroyed) nm = live_ids(swarms[i].drone_global_ids, ASSEMBLY_SIZE, members);
         sem_post(&sem_swarms);
+        if(nm == 0) continue;
+        msg_t cmd; memset(&cmd,0,sizeof(cmd));
+        cmd.type = MSG_COMMAND;
+        cmd.swarm_id = i;
+        snprintf(cmd.text,sizeof(cmd.text),"%s", text);
+        if(reliable) send_msg_group(center_sock, BASE_PORT, i, members, nm, &cmd);
+        else send_msg_group_unreliable(center_sock, BASE_PORT, i, members, nm, &cmd);
+        notified++;
+    }
+    return notified;
+}
 
-        printf("[CENTER] * REPORTE DE CAMARA *\n");
-        printf("[CENTER] * BLANCO %d: %s (%d drones atacaron) *\n",
-               swarms[m.swarm_id].target_id, target_status_str, drones_that_attacked);
-        
-    } else {
+// RATE lo envía este hilo y no el listener: recorrer los swarms con la cola llena solo
+// demoraría más la lectura. Va sin confirmación (es idempotente) y mientras el período no
+// sea el base se repite cada TELEMETRY_REFRESH_S por si algún dron perdió el anterior.
+#define TELEMETRY_REFRESH_S 5
+static sem_t sem_rate;
+
+void *telemetry_rate_thread(void *arg){
+    (void)arg;
+    int sent = TELEMETRY_MS;
+    while(1){
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += TELEMETRY_REFRESH_S;
+        int woken = sem_timedwait(&sem_rate, &ts) == 0;
+        int ms = __atomic_load_n(&telemetry_ms, __ATOMIC_RELAXED);
+        if(woken ? ms == sent : ms == TELEMETRY_MS) continue;
+        char text[32];
+        snprintf(text, sizeof(text), "RATE %d", ms);
+        broadcast_to_swarms(text, 0);
+        sent = ms;
+    }
+    return NULL;
+}
+
+// Aplica un cambio de parámetros en caliente (recarga de params.txt o socket de control):
+// modelo de asignación, CONFIG a los drones con Q/Z/VX/VY y, si lo pidió el operador, W a
+// la artillería (ante una recarga del archivo la artillería lo relee por su cuenta).
+// Devuelve a cuántos swarms se envió CONFIG.
+static int apply_live_params(const live_params_t *old, const live_params_t *now, int to_artillery){
+    if(now->W != old->W || now->VX != old->VX || now->ARTILLERY_RATE != old->ARTILLERY_RATE){
+        sem_wait(&sem_swarms);
+        alloc_model_init(&alloc_model, now->VX, B, A, now->W, now->ARTILLERY_RATE);
+        realloc_pending = 1;
         sem_post(&sem_swarms);
     }
+    if(to_artillery && now->W != old->W){
+        msg_t cmd; memset(&cmd,0,sizeof(cmd));
+        cmd.type = MSG_ARTILLERY;
+        snprintf(cmd.text, sizeof(cmd.text), "SET W %d", now->W);
+        send_msg_reliable(center_sock, port_for_artillery(BASE_PORT), &cmd);
+    }
+    char kv[200], text[MAX_MSG];
+    if(live_params_diff(old, now, LIVE_DRONE_KEYS, kv, sizeof(kv)) == 0) return 0;
+    snprintf(text, sizeof(text), "CONFIG %s", kv);
+    return broadcast_to_swarms(text, 1);
+}
+
+// Contrapresión: cada 100 ms mira la cola de center_sock. Si supera TELEMETRY_HIGH o el
+// kernel descartó datagramas, duplica el período de telemetría (hasta TELEMETRY_MAX_MS);
+// tras 3 s con la cola bajo TELEMETRY_LOW lo reduce a la mitad hasta volver al base.
+// Histéresis: tras una subida no vuelve a subir hasta que la cola baje de TELEMETRY_HIGH o
+// pasen 2 s (lo ya encolado sigue llegando al período viejo). El envío lo hace
+// telemetry_rate_thread; aquí solo se decide y se le avisa.
+static void telemetry_adapt(void){
+    static double last_sample = 0, last_change = 0, calm_since = 0;
+    static unsigned long last_drops = 0;
+    static int armed = 1;
+    double now = now_mono();
+    if(now - last_sample < 0.1) return;
+    if(last_sample == 0) calm_since = last_change = now;
+    last_sample = now;
+
+    int fill = sock_queue_fill(center_sock, NULL, NULL);
+    unsigned long drops = sock_drops(center_sock);
+    int want = telemetry_ms;
+    if(fill < TELEMETRY_HIGH || now - last_change >= 2.0) armed = 1;
+    if(fill >= TELEMETRY_HIGH || drops > last_drops){
+        calm_since = now;
+        if(armed && now - last_change >= 0.5 && telemetry_ms < TELEMETRY_MAX_MS)
+            want = telemetry_ms * 2 < TELEMETRY_MAX_MS ? telemetry_ms * 2 : TELEMETRY_MAX_MS;
+    } else if(fill > TELEMETRY_LOW){
+        calm_since = now;
+    } else if(now - calm_since >= 3.0 && now - last_change >= 3.0 && telemetry_ms > TELEMETRY_MS){
+        want = telemetry_ms / 2 > TELEMETRY_MS ? telemetry_ms / 2 : TELEMETRY_MS;
+    }
+    if(want != telemetry_ms){
+        if(want > telemetry_ms)
+            LOGW("Cola de recepción al %d%% (%lu descartes nuevos): telemetría %d -> %d ms",
+                 fill, drops - last_drops, telemetry_ms, want);
+        else
+            LOGI("Cola de recepción al %d%%: telemetría %d -> %d ms", fill, telemetry_ms, want);
+        __atomic_store_n(&telemetry_ms, want, __ATOMIC_RELAXED);
+        last_change = now;
+        armed = 0;
+        sem_post(&sem_rate);
+    }
+    last_drops = drops;
+}
+
+void *listener_thread(void *arg) {
+    (void)arg;
+    struct sockaddr_in from;
+    msg_view_t m;
+    // con timeout para que la contrapresión se evalúe también sin tráfico
+    struct timeval tv = { 0, 200000 };
+    setsockopt(center_sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    while(1){
+        int r = recv_view(center_sock,&m,&from);
+        telemetry_adapt();
+        if(r<=0){
+            if(r<0 && errno!=EAGAIN && errno!=EWOULDBLOCK && errno!=EINTR) usleep(100000);
+            continue;
+        }
+        dispatch_message(&m, &from);
+        __atomic_fetch_add(&msgs_dispatched, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
 }
-            else if(strstr(m.text,"IN_ASSEMBLY")){
-                sem_wait(&sem_swarms);
-                if(!swarms[m.swarm_id].is_destroyed) {
-                    int count = 0;
-                    for(int j=0;j<ASSEMBLY_SIZE;j++)
-                        if(swarms[m.swarm_id].drone_global_ids[j]!=0) count++;
-                    if(count==ASSEMBLY_SIZE && swarms[m.swarm_id].assembled == 0){
-                        swarms[m.swarm_id].assembled = 1;
-                    }
-                    int assembled_now = (swarms[m.swarm_id].assembled == 1);
-                    sem_post(&sem_swarms);
 
-                    if(assembled_now){
-                        printf("[CENTER] Swarm %d assembled and ready -> TAKEOFF\n", m.swarm_id);
-                        send_target_to_truck(m.swarm_id);
+// ---------- socket de control del operador ----------
+// CONTROL_SOCKET=<ruta> abre un socket UNIX local (stream). Cada pedido es una línea; la
+// respuesta son cero o más líneas y termina con "OK" o "ERR <motivo>". Las consultas se
+// arman con las vistas de los swarms y contadores atómicos (sin tomar sem_swarms); los
+// comandos usan los mismos caminos que el listener. Un único hilo atiende con poll() y
+// sockets no bloqueantes: un cliente lento solo acumula su propia salida pendiente.
+#define CTL_MAX_CLIENTS 8
+#define CTL_MAX_LINE 256
+#define CTL_MAX_OUT (4 << 20)    // salida pendiente máxima por cliente
+#define CTL_MAX_LIST 1000        // filas por pedido de SWARMS/TARGETS
 
-                        msg_t cmd; memset(&cmd,0,sizeof(cmd));
-                        cmd.type = MSG_COMMAND;
-                        cmd.swarm_id = m.swarm_id;
-                        snprintf(cmd.text,sizeof(cmd.text),"TAKEOFF");
-                        int truck_port = port_for_truck(BASE_PORT, m.swarm_id);
-                        send_msg(center_sock, truck_port, &cmd);
+typedef struct {
+    int fd;               // -1 = libre
+    int closing;          // el cliente cerró su lado: se cierra al vaciar la salida
+    int ckpt_wait;        // CHECKPOINT en curso (1) o en cola tras el en curso (2)
+    char in[CTL_MAX_LINE + 1];
+    int in_len;
+    char *out;
+    size_t out_len, out_off, out_cap;
+} ctl_client_t;
+
+static ctl_client_t ctl_clients[CTL_MAX_CLIENTS];
+
+// CHECKPOINT no escribe desde este hilo: lo pide al hilo de instantáneas (ckpt_request) y
+// su respuesta sale cuando este avisa por ctl_wake. Mientras, ese cliente no lee más
+// pedidos; los que llegan con una escritura ya en curso esperan a la siguiente.
+static int ctl_wake[2] = { -1, -1 };
+static int ctl_ckpt_busy = 0;
+static int ctl_ckpt_rc;
+static double ctl_ckpt_ms;
+
+static void ctl_ckpt_done(int rc, void *arg){
+    (void)arg;
+    ctl_ckpt_rc = rc;
+    ctl_ckpt_ms = checkpoint_ms;
+    char b = 1;
+    if(write(ctl_wake[1], &b, 1) < 0) { /* el pipe solo puede estar lleno: ya hay aviso */ }
+}
 
-                        sem_wait(&sem_swarms);
-                        swarms[m.swarm_id].assembled = 2; // TAKEOFF enviado
-                        sem_post(&sem_swarms);
-                    }
-                } else {
-                    sem_post(&sem_swarms);
-                }
+// Agrega una línea a la salida pendiente del cliente
+static void ctl_printf(ctl_client_t *c, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void ctl_printf(ctl_client_t *c, const char *fmt, ...){
+    char line[512];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(line, sizeof(line) - 1, fmt, ap);
+    va_end(ap);
+    if(n < 0) return;
+    if(n > (int)sizeof(line) - 2) n = sizeof(line) - 2;
+    line[n++] = '\n';
+    if(c->out_len + n > c->out_cap){
+        size_t cap = c->out_cap ? c->out_cap : 4096;
+        while(cap < c->out_len + n) cap *= 2;
+        char *o = realloc(c->out, cap);
+        if(!o) return;
+        c->out = o;
+        c->out_cap = cap;
+    }
+    memcpy(c->out + c->out_len, line, n);
+    c->out_len += n;
+}
+
+// Entero completo en [lo, hi]
+static int ctl_int(const char *s, int lo, int hi, int *out){
+    char *end;
+    if(!s) return 0;
+    long v = strtol(s, &end, 10);
+    if(end == s || *end || v < lo || v > hi) return 0;
+    *out = (int)v;
+    return 1;
+}
+
+static void ctl_cmd_takeoff(ctl_client_t *c, int sid){
+    sem_wait(&sem_swarms);
+    const char *err = swarms[sid].is_destroyed || swarms[sid].active_count == 0 ? "swarm sin drones" :
+                      swarms[sid].assembled != 0 ? "el swarm ya despegó o está despegando" : NULL;
+    int n = swarms[sid].active_count;
+    if(!err){
+        swarms[sid].assembled = 2;   // reservado aquí: el listener ya no lo despega
+        swarm_publish(sid);
+    }
+    sem_post(&sem_swarms);
+    if(err){ ctl_printf(c, "ERR %s", err); return; }
+
+    LOGI("Operador: TAKEOFF forzado del swarm %d con %d/%d drones", sid, n, ASSEMBLY_SIZE);
+    send_takeoff(sid);
+    ctl_printf(c, "swarm=%d drones=%d", sid, n);
+    ctl_printf(c, "OK");
+}
+
+// RETARGET sid [tid]: sin tid elige el mejor blanco vivo para la posición del swarm
+static void ctl_cmd_retarget(ctl_client_t *c, int sid, int tid){
+    retarget_t r;
+    const char *err = NULL;
+    int flying = 0;
+    sem_wait(&sem_swarms);
+    if(swarms[sid].is_destroyed || swarms[sid].active_count == 0) err = "swarm sin drones";
+    else if(tid < 0 && (tid = best_target_for(sid)) < 0) err = "no quedan blancos vivos";
+    else if(targets.items[tid].destroyed) err = "blanco ya destruido";
+    else {
+        set_swarm_target(sid, tid);
+        flying = swarms[sid].assembled == 2;
+        r.swarm_id = sid;
+        r.tid = tid;
+        r.tx = swarms[sid].target_x;
+        r.ty = swarms[sid].target_y;
+        for(int j = 0; j < MAX_DRONES_PER_SWARM; j++)
+            r.drone_ids[j] = (j < ASSEMBLY_SIZE) ? swarms[sid].drone_global_ids[j] : 0;
+    }
+    sem_post(&sem_swarms);
+    if(err){ ctl_printf(c, "ERR %s", err); return; }
+
+    LOGI("Operador: swarm %d -> Blanco %d en (%.1f, %.1f)", sid, tid, r.tx, r.ty);
+    journal_append(flying ? JEV_RETARGET : JEV_SWARM_TARGET, sid, 0, tid, r.tx, r.ty);
+    if(flying) send_retargets(&r, 1);
+    // uno que no despegó lleva el blanco con el TAKEOFF (una re-resolución puede cambiarlo)
+    ctl_printf(c, "swarm=%d target=%d x=%.1f y=%.1f %s", sid, tid, r.tx, r.ty,
+               flying ? "en_vuelo" : "en_tierra");
+    ctl_printf(c, "OK");
+}
+
+// SET W|Q: se publica como cualquier cambio de parámetros en caliente
+static void ctl_cmd_set(ctl_client_t *c, const char *key, int v){
+    live_params_t *p = live_params_begin();
+    if(strcasecmp(key, "W") == 0) p->W = v;
+    else p->Q = v;
+    const live_params_t *old = live_params_commit(p);
+    int notified = apply_live_params(old, p, 1);
+    LOGI("Operador: W=%d%% Q=%d%% (CONFIG a %d swarms)", p->W, p->Q, notified);
+    ctl_printf(c, "W=%d Q=%d swarms=%d", p->W, p->Q, notified);
+    ctl_printf(c, "OK");
+}
+
+static void ctl_cmd_metrics(ctl_client_t *c){
+    status_totals_t tot = {0};
+    for(int i = swarm_lo; i < swarm_hi; i++){
+        swarm_view_t v;
+        swarm_view_read(i, &v);
+        totals_add(&tot, &v);
+    }
+    int pending; unsigned long retx, dropped, dups;
+    reliable_stats(&pending, &retx, &dropped, &dups);
+    int queued = 0, rcvbuf = 0;
+    int fill = sock_queue_fill(center_sock, &queued, &rcvbuf);
+    ctl_printf(c, "uptime_s=%.1f", now_mono() - mission_start);
+    ctl_printf(c, "mensajes=%lu", __atomic_load_n(&msgs_dispatched, __ATOMIC_RELAXED));
+    ctl_printf(c, "swarms=%d swarms_vivos=%d ensamblando=%d en_vuelo=%d reconformando=%d autodestruidos=%d",
+               swarm_hi - swarm_lo, tot.alive, tot.assembling, tot.flying, tot.reassembling, tot.destroyed);
+    ctl_printf(c, "drones=%d", tot.drones);
+    ctl_printf(c, "shard=%d shards=%d swarm_desde=%d swarm_hasta=%d",
+               shard_id, center_shards(), swarm_lo, swarm_hi - 1);
+    ctl_printf(c, "blancos=%d blancos_destruidos=%d", NUM_TARGETS, targets_destroyed_count());
+    ctl_printf(c, "confiables_pendientes=%d reintentos=%lu sin_ack=%lu duplicados=%lu",
+               pending, retx, dropped, dups);
+    ctl_printf(c, "socket_cola_bytes=%d socket_rcvbuf_bytes=%d socket_cola_pct=%d socket_descartes=%lu",
+               queued, rcvbuf, fill, sock_drops(center_sock));
+    const live_params_t *lp = live_params();
+    ctl_printf(c, "telemetria_ms=%d W=%d Q=%d Z=%d VX=%g max_wait_reassembly=%d params_gen=%u",
+               telemetry_ms, lp->W, lp->Q, lp->Z, lp->VX, lp->MAX_WAIT_REASSEMBLY, lp->generation);
+    ctl_printf(c, "instantaneas=%lu instantanea_ms=%.1f",
+               __atomic_load_n(&checkpoints_written, __ATOMIC_RELAXED), checkpoint_ms);
+    ctl_printf(c, "OK");
+}
+
+// Filas [from, from+count) de una lista numerada, acotadas al total y a CTL_MAX_LIST
+static int ctl_range(char **tok, int nt, int total, int *from, int *to){
+    int count = 100;
+    *from = 0;
+    if(nt > 1 && !ctl_int(tok[1], 0, total, from)) return 0;
+    if(nt > 2 && !ctl_int(tok[2], 1, CTL_MAX_LIST, &count)) return 0;
+    if(count > CTL_MAX_LIST) count = CTL_MAX_LIST;
+    *to = *from + count < total ? *from + count : total;
+    return 1;
+}
+
+static void ctl_target_line(ctl_client_t *c, int t){
+    const target_t *tg = &targets.items[t];
+    ctl_printf(c, "target=%d x=%.1f y=%.1f prioridad=%d destruido=%d swarms=%d", t, tg->x, tg->y,
+               tg->priority, __atomic_load_n(&tg->destroyed, __ATOMIC_RELAXED),
+               __atomic_load_n(&tg->n_swarms, __ATOMIC_RELAXED));
+}
+
+static void ctl_execute(ctl_client_t *c, char *line){
+    char *tok[4], *save;
+    int nt = 0;
+    for(char *t = strtok_r(line, " \t\r", &save); t && nt < 4; t = strtok_r(NULL, " \t\r", &save))
+        tok[nt++] = t;
+    if(nt == 0) return;
+    const char *cmd = tok[0];
+    int a, b, from, to;
+    time_t now = time(NULL);
+
+    if(strcasecmp(cmd, "HELP") == 0){
+        ctl_printf(c, "STATUS                     totales de swarms, drones y blancos");
+        ctl_printf(c, "SWARM id                   estado de un swarm");
+        ctl_printf(c, "SWARMS [desde [cantidad]]  estado de varios swarms (máx. %d)", CTL_MAX_LIST);
+        ctl_printf(c, "DRONE gid                  swarm y posición en el swarm de un drone vivo");
+        ctl_printf(c, "TARGET id                  estado de un blanco");
+        ctl_printf(c, "TARGETS [desde [cantidad]] estado de varios blancos (máx. %d)", CTL_MAX_LIST);
+        ctl_printf(c, "TAKEOFF id                 despega un swarm aunque no esté completo");
+        ctl_printf(c, "RETARGET id [blanco]       redirige un swarm (sin blanco: el mejor vivo)");
+        ctl_printf(c, "SET W|Q n                  cambia W o Q (0..100) en caliente");
+        ctl_printf(c, "METRICS                    contadores en formato clave=valor");
+        ctl_printf(c, "DUMP                       estado completo en el stdout del centro");
+        ctl_printf(c, "CHECKPOINT                 escribe ya la instantánea (CHECKPOINT_DIR)");
+        ctl_printf(c, "OK");
+    }
+    else if(strcasecmp(cmd, "STATUS") == 0){
+        status_totals_t tot = {0};
+        int changed = 0;
+        for(int i = swarm_lo; i < swarm_hi; i++){
+            swarm_view_t v;
+            swarm_view_read(i, &v);
+            totals_add(&tot, &v);
+            changed += v.version != status_versions[i];
+        }
+        ctl_printf(c, "swarms=%d vivos=%d ensamblando=%d en_vuelo=%d reconformando=%d autodestruidos=%d "
+                   "drones=%d blancos=%d destruidos=%d cambios=%d",
+                   swarm_hi - swarm_lo, tot.alive, tot.assembling, tot.flying, tot.reassembling, tot.destroyed,
+                   tot.drones, NUM_TARGETS, targets_destroyed_count(), changed);
+        ctl_printf(c, "OK");
+    }
+    else if(strcasecmp(cmd, "SWARM") == 0){
+        if(nt != 2 || !ctl_int(tok[1], swarm_lo, swarm_hi - 1, &a)){ ctl_printf(c, "ERR uso: SWARM %d..%d", swarm_lo, swarm_hi - 1); return; }
+        swarm_view_t v;
+        char buf[256];
+        swarm_view_read(a, &v);
+        format_swarm_line(buf, sizeof(buf), a, &v, now);
+        ctl_printf(c, "%s", buf);
+        ctl_printf(c, "OK");
+    }
+    else if(strcasecmp(cmd, "SWARMS") == 0){
+        if(!ctl_range(tok, nt, swarm_hi, &from, &to)){ ctl_printf(c, "ERR uso: SWARMS [desde [cantidad]]"); return; }
+        if(from < swarm_lo) from = swarm_lo;   // los de otros shards se consultan en su socket
+        for(int i = from; i < to; i++){
+            swarm_view_t v;
+            char buf[256];
+            swarm_view_read(i, &v);
+            format_swarm_line(buf, sizeof(buf), i, &v, now);
+            ctl_printf(c, "%s", buf);
+        }
+        ctl_printf(c, "OK");
+    }
+    else if(strcasecmp(cmd, "DRONE") == 0){
+        if(nt != 2 || !ctl_int(tok[1], 1, 1 << 30, &a)){ ctl_printf(c, "ERR uso: DRONE gid"); return; }
+        for(int i = swarm_lo; i < swarm_hi; i++){
+            swarm_view_t v;
+            swarm_view_read(i, &v);
+            for(int j = 0; j < ASSEMBLY_SIZE; j++){
+                if(v.drone_ids[j] != a) continue;
+                ctl_printf(c, "drone=%d swarm=%d slot=%d assembled=%d reconformando=%d target=%d(%.1f,%.1f)",
+                           a, i, j, v.assembled, v.in_reassembly && !v.is_destroyed, v.target_id,
+                           v.target_x, v.target_y);
+                ctl_printf(c, "OK");
+                return;
             }
-            else if(strstr(m.text,"IN_REASSEMBLY")){
-                sem_wait(&sem_swarms);
-                int need = (swarms[m.swarm_id].active_count < ASSEMBLY_SIZE &&
-                           swarms[m.swarm_id].active_count > 0 &&
-                           !swarms[m.swarm_id].is_destroyed);
-                int already_in_reassembly = swarms[m.swarm_id].in_reassembly;
-                sem_post(&sem_swarms);
+        }
+        ctl_printf(c, "ERR drone %d no está en ningún swarm (terminado o sin registrar)", a);
+    }
+    else if(strcasecmp(cmd, "TARGET") == 0){
+        if(nt != 2 || !ctl_int(tok[1], 0, NUM_TARGETS - 1, &a)){ ctl_printf(c, "ERR uso: TARGET 0..%d", NUM_TARGETS - 1); return; }
+        ctl_target_line(c, a);
+        ctl_printf(c, "OK");
+    }
+    else if(strcasecmp(cmd, "TARGETS") == 0){
+        if(!ctl_range(tok, nt, NUM_TARGETS, &from, &to)){ ctl_printf(c, "ERR uso: TARGETS [desde [cantidad]]"); return; }
+        for(int t = from; t < to; t++) ctl_target_line(c, t);
+        ctl_printf(c, "OK");
+    }
+    else if(strcasecmp(cmd, "TAKEOFF") == 0){
+        if(nt != 2 || !ctl_int(tok[1], swarm_lo, swarm_hi - 1, &a)){ ctl_printf(c, "ERR uso: TAKEOFF %d..%d", swarm_lo, swarm_hi - 1); return; }
+        ctl_cmd_takeoff(c, a);
+    }
+    else if(strcasecmp(cmd, "RETARGET") == 0){
+        b = -1;
+        if(nt < 2 || nt > 3 || !ctl_int(tok[1], swarm_lo, swarm_hi - 1, &a) ||
+           (nt == 3 && !ctl_int(tok[2], 0, NUM_TARGETS - 1, &b))){
+            ctl_printf(c, "ERR uso: RETARGET %d..%d [0..%d]", swarm_lo, swarm_hi - 1, NUM_TARGETS - 1);
+            return;
+        }
+        ctl_cmd_retarget(c, a, b);
+    }
+    else if(strcasecmp(cmd, "SET") == 0){
+        if(nt != 3 || (strcasecmp(tok[1], "W") && strcasecmp(tok[1], "Q")) || !ctl_int(tok[2], 0, 100, &a)){
+            ctl_printf(c, "ERR uso: SET W|Q 0..100");
+            return;
+        }
+        ctl_cmd_set(c, tok[1], a);
+    }
+    else if(strcasecmp(cmd, "METRICS") == 0) ctl_cmd_metrics(c);
+    else if(strcasecmp(cmd, "DUMP") == 0){
+        full_status_requested = 1;
+        ctl_printf(c, "OK");
+    }
+    else if(strcasecmp(cmd, "CHECKPOINT") == 0){
+        if(!checkpoint_dir[0]){
+            ctl_printf(c, "ERR CHECKPOINT_DIR no está configurado");
+            return;
+        }
+        if(ctl_ckpt_busy){
+            c->ckpt_wait = 2;
+            return;
+        }
+        if(ckpt_request(ctl_ckpt_done, NULL) < 0){
+            ctl_printf(c, "ERR el hilo de instantáneas no está activo");
+            return;
+        }
+        ctl_ckpt_busy = 1;
+        c->ckpt_wait = 1;
+    }
+    else ctl_printf(c, "ERR comando desconocido: %s (HELP lista los comandos)", cmd);
+}
 
-                if(need && !already_in_reassembly){
-                    start_reassembly_process(m.swarm_id);
-                    try_reconform_or_autodestruct(m.swarm_id);
-                }
+static void ctl_close(ctl_client_t *c){
+    close(c->fd);
+    free(c->out);
+    memset(c, 0, sizeof(*c));
+    c->fd = -1;
+}
+
+// Atiende las líneas completas ya leídas, hasta que una quede esperando un CHECKPOINT
+static void ctl_lines(ctl_client_t *c){
+    char *start = c->in, *nl;
+    while(!c->ckpt_wait && (nl = memchr(start, '\n', c->in + c->in_len - start))){
+        *nl = 0;
+        if(c->out_len - c->out_off > CTL_MAX_OUT){ ctl_close(c); return; }   // no lee sus respuestas
+        ctl_execute(c, start);
+        start = nl + 1;
+    }
+    c->in_len -= start - c->in;
+    memmove(c->in, start, c->in_len);
+    if(c->ckpt_wait) return;
+    if(c->closing && c->in_len > 0){
+        // un pedido final sin '\n' también se atiende
+        c->in[c->in_len] = 0;
+        c->in_len = 0;
+        ctl_execute(c, c->in);
+    } else if(c->in_len == CTL_MAX_LINE){
+        ctl_printf(c, "ERR línea de más de %d bytes", CTL_MAX_LINE);
+        c->in_len = 0;
+    }
+}
+
+static void ctl_read(ctl_client_t *c){
+    ssize_t r = read(c->fd, c->in + c->in_len, CTL_MAX_LINE - c->in_len);
+    if(r < 0){
+        if(errno != EAGAIN && errno != EINTR) ctl_close(c);
+        return;
+    }
+    if(r == 0) c->closing = 1;
+    c->in_len += r;
+    ctl_lines(c);
+}
+
+// El hilo de instantáneas terminó: responde a los que esperaban, pide otra escritura para
+// los que quedaron en cola y retoma los pedidos que cada uno tenía detrás
+static void ctl_ckpt_finished(void){
+    char b[16];
+    while(read(ctl_wake[0], b, sizeof(b)) > 0) {}
+    ctl_ckpt_busy = 0;
+    int resume[CTL_MAX_CLIENTS], nr = 0, queued = 0;
+    for(int i = 0; i < CTL_MAX_CLIENTS; i++){
+        ctl_client_t *c = &ctl_clients[i];
+        if(c->fd < 0 || !c->ckpt_wait) continue;
+        if(c->ckpt_wait == 2){ queued = 1; continue; }
+        if(ctl_ckpt_rc < 0) ctl_printf(c, "ERR no se pudo escribir %s/%s", checkpoint_dir, checkpoint_name);
+        else {
+            ctl_printf(c, "%s/%s (%.1f ms)", checkpoint_dir, checkpoint_name, ctl_ckpt_ms);
+            ctl_printf(c, "OK");
+        }
+        c->ckpt_wait = 0;
+        resume[nr++] = i;
+    }
+    if(queued){
+        int ok = ckpt_request(ctl_ckpt_done, NULL) == 0;
+        ctl_ckpt_busy = ok;
+        for(int i = 0; i < CTL_MAX_CLIENTS; i++){
+            ctl_client_t *c = &ctl_clients[i];
+            if(c->fd < 0 || c->ckpt_wait != 2) continue;
+            c->ckpt_wait = ok;
+            if(!ok){
+                ctl_printf(c, "ERR el hilo de instantáneas no está activo");
+                resume[nr++] = i;
             }
         }
-        else if(m.type==MSG_ARTILLERY){
-            printf("[CENTER] ARTILLERY MSG: %s\n", m.text);
-            if(strstr(m.text,"SHOT_DOWN")){
-                int did;
-                if(sscanf(m.text,"DRONE %d",&did)==1){
-                    sem_wait(&sem_swarms);
-                    int found_swarm = remove_drone_from_swarm_by_id(did);
-                    if(found_swarm >= 0) {
-                        printf("[CENTER] Drone %d removido del swarm %d por artillería\n", did, found_swarm);
-                    }
-                    sem_post(&sem_swarms);
-                    
-                }
+    }
+    for(int k = 0; k < nr; k++)
+        if(ctl_clients[resume[k]].fd >= 0) ctl_lines(&ctl_clients[resume[k]]);
+}
+
+static void ctl_flush(ctl_client_t *c){
+    ssize_t r = send(c->fd, c->out + c->out_off, c->out_len - c->out_off, MSG_NOSIGNAL);
+    if(r < 0){
+        if(errno != EAGAIN && errno != EINTR) ctl_close(c);
+        return;
+    }
+    c->out_off += r;
+    if(c->out_off == c->out_len) c->out_off = c->out_len = 0;
+}
+
+static void ctl_accept(int lfd){
+    int fd = accept(lfd, NULL, NULL);
+    if(fd < 0) return;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    for(int i = 0; i < CTL_MAX_CLIENTS; i++){
+        if(ctl_clients[i].fd < 0){
+            ctl_clients[i].fd = fd;
+            return;
+        }
+    }
+    static const char busy[] = "ERR demasiados clientes\n";
+    if(send(fd, busy, sizeof(busy) - 1, MSG_NOSIGNAL) < 0) { /* se cierra igual */ }
+    close(fd);
+}
+
+// Socket de escucha en path (borra uno viejo de una corrida anterior); -1 si falla
+int control_open(const char *path){
+    struct sockaddr_un addr; memset(&addr,0,sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(strlen(path) >= sizeof(addr.sun_path)){
+        LOGW("CONTROL_SOCKET demasiado largo: %s", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0) return -1;
+    unlink(path);
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, CTL_MAX_CLIENTS) < 0){
+        LOGW("No se pudo abrir el socket de control %s: %s", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    chmod(path, 0600);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+void *control_thread(void *arg) {
+    int lfd = *(int *)arg;
+    struct pollfd pfd[CTL_MAX_CLIENTS + 2];
+    int who[CTL_MAX_CLIENTS + 2];
+    for(int i = 0; i < CTL_MAX_CLIENTS; i++) ctl_clients[i].fd = -1;
+    if(pipe(ctl_wake) < 0){
+        LOGW("Socket de control: pipe: %s", strerror(errno));
+        return NULL;
+    }
+    for(int i = 0; i < 2; i++) fcntl(ctl_wake[i], F_SETFL, fcntl(ctl_wake[i], F_GETFL) | O_NONBLOCK);
+    while(1){
+        int np = 0;
+        pfd[np].fd = lfd;
+        pfd[np].events = POLLIN;
+        who[np++] = -1;
+        pfd[np].fd = ctl_wake[0];
+        pfd[np].events = POLLIN;
+        who[np++] = -1;
+        for(int i = 0; i < CTL_MAX_CLIENTS; i++){
+            ctl_client_t *c = &ctl_clients[i];
+            if(c->fd < 0) continue;
+            pfd[np].fd = c->fd;
+            pfd[np].events = (c->closing || c->ckpt_wait ? 0 : POLLIN) | (c->out_len > c->out_off ? POLLOUT : 0);
+            who[np++] = i;
+        }
+        if(poll(pfd, np, -1) < 0){
+            if(errno == EINTR) continue;
+            LOGW("Socket de control: poll: %s", strerror(errno));
+            return NULL;
+        }
+        for(int k = 2; k < np; k++){
+            ctl_client_t *c = &ctl_clients[who[k]];
+            if(pfd[k].revents & (POLLIN | POLLHUP | POLLERR)){
+                // HUP/ERR con la salida sin vaciar o esperando un CHECKPOINT
+                if(c->closing || c->ckpt_wait){ ctl_close(c); continue; }
+                ctl_read(c);
             }
+            if(c->fd >= 0 && c->out_len > c->out_off) ctl_flush(c);
+            if(c->fd >= 0 && c->closing && !c->ckpt_wait && c->out_len == c->out_off) ctl_close(c);
         }
+        if(pfd[1].revents & POLLIN){
+            ctl_ckpt_finished();
+            for(int i = 0; i < CTL_MAX_CLIENTS; i++){
+                ctl_client_t *c = &ctl_clients[i];
+                if(c->fd >= 0 && c->out_len > c->out_off) ctl_flush(c);
+                if(c->fd >= 0 && c->closing && !c->ckpt_wait && c->out_len == c->out_off) ctl_close(c);
+            }
+        }
+        if(pfd[0].revents & POLLIN) ctl_accept(lfd);
     }
     return NULL;
 }
 
+// ---------- instantáneas (CHECKPOINT_DIR) ----------
+// center.ckpt (center_<k>.ckpt en el shard k>0): parámetros vigentes, tabla de swarms y
+// catálogo de blancos con su estado.
+// La escribe cada CHECKPOINT_SECS un hijo de fork() sobre su copia copy-on-write, con
+// sem_swarms tomado solo durante el fork. Con --restore se carga y se relanzan los trucks
+// de los swarms vivos; cada drone retoma su propia instantánea (drone_<gid>.ckpt).
+typedef struct {
+    int num_swarms, num_targets, assembly_size, telemetry_ms;
+    double elapsed;             // segundos de misión al escribir
+    live_params_t params;
+} center_ckpt_t;
+
+static void center_ckpt_lock(void){ sem_wait(&sem_swarms); }
+static void center_ckpt_unlock(void){ sem_post(&sem_swarms); }
+
+// En el hijo del fork: sin locks ni reservas de memoria
+static void center_ckpt_emit(ckpt_out_t *o, void *arg){
+    (void)arg;
+    center_ckpt_t h = { NUM_SWARMS, targets.count, ASSEMBLY_SIZE, telemetry_ms,
+                        now_mono() - mission_start, *live_params() };
+    ckpt_put(o, &h, sizeof(h));
+    ckpt_put(o, swarms, NUM_SWARMS * sizeof(swarm_t));
+    ckpt_put(o, targets.items, targets.count * sizeof(target_t));
+}
+
+// La llama el hilo de instantáneas (periódica o por el comando CHECKPOINT) y main al inicio.
+// 0 o -1.
+int center_checkpoint(void){
+    double t0 = now_mono();
+    if(ckpt_write_forked(checkpoint_dir, checkpoint_name, CKPT_CENTER,
+                         center_ckpt_lock, center_ckpt_unlock, center_ckpt_emit, NULL) < 0){
+        LOGW("No se pudo escribir %s/%s: %s", checkpoint_dir, checkpoint_name, strerror(errno));
+        return -1;
+    }
+    checkpoint_ms = (now_mono() - t0) * 1000;
+    __atomic_fetch_add(&checkpoints_written, 1, __ATOMIC_RELAXED);
+    LOGD("Instantánea %s/%s en %.1f ms", checkpoint_dir, checkpoint_name, checkpoint_ms);
+    return 0;
+}
+
+// Carga center.ckpt en lugar de armar el catálogo y asignar blancos; -1 si no sirve
+int center_restore(void){
+    size_t len;
+    int64_t written_at;
+    char *data = ckpt_read(checkpoint_dir, checkpoint_name, CKPT_CENTER, &len, &written_at);
+    if(!data){
+        LOGE("No hay una instantánea válida en %s/%s", checkpoint_dir, checkpoint_name);
+        return -1;
+    }
+    ckpt_in_t in = { data, len };
+    center_ckpt_t h;
+    if(ckpt_get(&in, &h, sizeof(h)) < 0 || h.num_swarms != NUM_SWARMS || h.assembly_size != ASSEMBLY_SIZE ||
+       ckpt_get(&in, swarms, NUM_SWARMS * sizeof(swarm_t)) < 0 ||
+       in.left != (size_t)h.num_targets * sizeof(target_t)){
+        LOGE("%s/%s no corresponde a esta configuración (NUM_SWARMS=%d ASSEMBLY_SIZE=%d)",
+             checkpoint_dir, checkpoint_name, NUM_SWARMS, ASSEMBLY_SIZE);
+        free(data);
+        return -1;
+    }
+    targets_free(&targets);
+    for(int t = 0; t < h.num_targets; t++){
+        target_t tg;
+        ckpt_get(&in, &tg, sizeof(tg));
+        targets_add(&targets, tg.x, tg.y, tg.priority, tg.required);
+        targets.items[t].destroyed = tg.destroyed;
+        targets.items[t].first_swarm = tg.first_swarm;
+        targets.items[t].n_swarms = tg.n_swarms;
+    }
+    targets_build_index(&targets);
+    NUM_TARGETS = targets.count;
+    free(data);
+
+    live_params_t *p = live_params_begin();
+    *p = h.params;
+    live_params_commit(p);
+    alloc_model_init(&alloc_model, h.params.VX, B, A, h.params.W, h.params.ARTILLERY_RATE);
+    telemetry_ms = h.telemetry_ms;
+    mission_start = now_mono() - h.elapsed;
+
+    int alive = 0, tdestroyed = 0;
+    time_t now = time(NULL);
+    for(int i = swarm_lo; i < swarm_hi; i++){
+        if(swarms[i].in_reassembly) swarms[i].reassembly_start = now;   // el plazo vuelve a correr
+        swarms[i].truck_pid = 0;
+        alive += !swarms[i].is_destroyed && swarms[i].active_count > 0;
+        swarm_publish(i);
+    }
+    for(int t = 0; t < NUM_TARGETS; t++) tdestroyed += targets.items[t].destroyed;
+    LOGI("Misión retomada de %s/%s (de hace %lds, %.0f s de misión): %d/%d swarms vivos, "
+         "%d/%d blancos destruidos", checkpoint_dir, checkpoint_name, (long)(now - written_at), h.elapsed,
+         alive, swarm_hi - swarm_lo, tdestroyed, NUM_TARGETS);
+    return 0;
+}
+
+// Relanza los trucks de los swarms vivos con los drones a retomar: los que el centro
+// tiene registrados en el swarm y, si todavía no despegó, los de su dotación original
+// que ningún swarm tiene registrados (aún no habían enviado HELLO o ya murieron: estos
+// últimos repiten su aviso de muerte y terminan)
+void respawn_trucks_and_drones(void){
+    if(!SPAWN_TRUCKS) return;
+    int max_gid = NUM_SWARMS * 100 + 100;
+    char *claimed = calloc(max_gid, 1);
+    if(!claimed){ perror("calloc"); exit(1); }
+    for(int i = swarm_lo; i < swarm_hi; i++)
+        for(int j = 0; j < ASSEMBLY_SIZE; j++){
+            int gid = swarms[i].drone_global_ids[j];
+            if(gid > 0 && gid < max_gid) claimed[gid] = 1;
+        }
+
+    for(int i = swarm_lo; i < swarm_hi; i++){
+        swarm_t *s = &swarms[i];
+        if(s->is_destroyed || s->active_count == 0) continue;
+        int ids[2 * MAX_DRONES_PER_SWARM];
+        int n = live_ids(s->drone_global_ids, ASSEMBLY_SIZE, ids);
+        if(s->assembled < 2 && !s->in_reassembly)
+            for(int j = 0; j < ASSEMBLY_SIZE; j++){
+                int gid = i * 100 + j + 1;
+                if(!claimed[gid]){ claimed[gid] = 1; ids[n++] = gid; }
+            }
+
+        // truck params tid --restore target x y gid...
+        char tgt[16], tx[32], ty[32], gids[2 * MAX_DRONES_PER_SWARM][16];
+        char *args[4 + 2 * MAX_DRONES_PER_SWARM];
+        int na = 0;
+        snprintf(tgt, sizeof(tgt), "%d", s->target_id);
+        snprintf(tx, sizeof(tx), "%.3f", s->target_x);
+        snprintf(ty, sizeof(ty), "%.3f", s->target_y);
+        args[na++] = "--restore"; args[na++] = tgt; args[na++] = tx; args[na++] = ty;
+        for(int k = 0; k < n; k++){
+            snprintf(gids[k], sizeof(gids[k]), "%d", ids[k]);
+            args[na++] = gids[k];
+        }
+        pid_t pid = launch_truck(i, args, na);
+        s->truck_pid = pid > 0 ? pid : 0;
+    }
+    free(claimed);
+}
+
+#ifndef SIM_NO_MAIN
+static void on_sigusr1(int sig){
+    (void)sig;
+    full_status_requested = 1;
+}
+
+static void on_params_reload(const live_params_t *old, const live_params_t *now){
+    int n = apply_live_params(old, now, 0);
+    if(n > 0) LOGI("CONFIG enviado a %d swarms", n);
+}
+
+// Shard 0: lanza los shards 1..n-1 (./control_center params --shard k) con sus mismas opciones
+void spawn_center_shards(int restore){
+    for(int k = 1; k < center_shards(); k++){
+        char shard[16];
+        snprintf(shard, sizeof(shard), "%d", k);
+        pid_t pid = fork();
+        if(pid == 0){
+            char *argv[8];
+            int na = 0;
+            argv[na++] = "control_center"; argv[na++] = params_path;
+            argv[na++] = "--shard"; argv[na++] = shard;
+            if(restore) argv[na++] = "--restore";
+            if(memstats_mode) argv[na++] = "--memstats";
+            argv[na] = NULL;
+            execv("./control_center", argv);
+            perror("execv control_center");
+            exit(1);
+        }
+        if(pid < 0) perror("fork shard");
+        else {
+            int lo, hi;
+            shard_range(k, &lo, &hi);
+            LOGI("Shard %d (swarms %d..%d, puerto %d) lanzado con PID %d",
+                 k, lo, hi - 1, port_for_center_shard(BASE_PORT, k), pid);
+        }
+    }
+}
+
 int main(int argc, char **argv){
-    if(argc<2){ printf("Uso: control_center params.txt\n"); exit(1); }
+    if(argc<2){ printf("Uso: control_center params.txt [--memstats] [--restore] [--shard k]\n"); exit(1); }
     params_path = argv[1];
+    int restore = 0;
+    for(int i = 2; i < argc; i++){
+        if(strcmp(argv[i], "--memstats") == 0) memstats_mode = 1;
+        if(strcmp(argv[i], "--restore") == 0) restore = 1;
+        if(strcmp(argv[i], "--shard") == 0 && i + 1 < argc) shard_id = atoi(argv[++i]);
+    }
     load_params(params_path);
+    budget_load(params_path);
+    char log_name[16] = "CENTER";
+    if(shard_id > 0) snprintf(log_name, sizeof(log_name), "CENTER-%d", shard_id);
+    log_init(log_name, params_path);
+    live_params_load(params_path);
+    if(net_load(params_path) > 0)
+        for(int k = 0; k < net_workers(); k++){
+            int first = -1, last = -1;
+            for(int i = 0; i < NUM_SWARMS; i++)
+                if(net_worker_of_swarm(i) == k){ if(first < 0) first = i; last = i; }
+            LOGI("Worker %d en %s: swarms %d..%d (worker_agent en puerto %d)",
+                 k, net_worker_addr(k), first, last, port_for_agent(BASE_PORT, k));
+        }
+    swarm_hi = NUM_SWARMS;
+    if(shard_id < 0 || shard_id >= center_shards()){
+        LOGE("--shard %d fuera de 0..%d (CENTER_SHARDS)", shard_id, center_shards() - 1);
+        exit(1);
+    }
+    if(center_shards() > 1){
+        shard_range(shard_id, &swarm_lo, &swarm_hi);
+        if(shard_id > 0){
+            snprintf(shard_suffix, sizeof(shard_suffix), "_%d", shard_id);
+            snprintf(checkpoint_name, sizeof(checkpoint_name), "center%s.ckpt", shard_suffix);
+        }
+        LOGI("Shard %d de %d: swarms %d..%d", shard_id, center_shards(), swarm_lo, swarm_hi - 1);
+    }
+    pid_t coordinator = getppid();   // el shard 0, para los shards k>0
+    int checkpoint_secs;
+    int checkpointing = ckpt_config(params_path, checkpoint_dir, sizeof(checkpoint_dir), &checkpoint_secs);
+    if(restore && !checkpointing){
+        LOGE("--restore requiere CHECKPOINT_DIR en %s", params_path);
+        exit(1);
+    }
+
+    char jdir[200];
+    if(params_get_string(params_path, "JOURNAL_DIR", jdir, sizeof(jdir))){
+        char jpath[256];
+        // al retomar no se trunca el journal de la corrida interrumpida
+        snprintf(jpath, sizeof(jpath), "%s/center%s.%sjournal", jdir, shard_suffix, restore ? "resumed." : "");
+        journal_open(jpath, JSRC_CENTER);
+    }
 
     sem_init(&sem_swarms, 0, 1);
     sem_init(&sem_reassign_line, 0, 1);
+    sem_init(&sem_shards, 0, 1);
+
+    swarms = calloc(NUM_SWARMS, sizeof(swarm_t));
+    swarm_views = calloc(NUM_SWARMS, sizeof(swarm_view_t));
+    status_versions = calloc(NUM_SWARMS, sizeof(unsigned));
+    if(!swarms || !swarm_views || !status_versions){ perror("calloc swarms"); exit(1); }
+    signal(SIGUSR1, on_sigusr1);
 
     srand(RANDOM_SEED ? RANDOM_SEED : time(NULL));
     center_sock = make_udp_socket();
-    int center_port = port_for_center(BASE_PORT);
+    budget_rcvbuf(center_sock, ASSEMBLY_SIZE * NUM_SWARMS + NUM_SWARMS + 2);
+    int rcvbuf = sock_tune(center_sock, params_path);
+    int center_port = port_for_center_shard(BASE_PORT, shard_id);
     struct sockaddr_in addr; memset(&addr,0,sizeof(addr));
     addr.sin_family = AF_INET;
-    addr.sin_addr.s_addr = inet_addr(HOST);
+    addr.sin_addr.s_addr = net_addr_for_port(center_port);
     addr.sin_port = htons(center_port);
     if(bind(center_sock,(struct sockaddr*)&addr,sizeof(addr))<0){
         perror("bind center");
         exit(1);
     }
-    printf("[CENTER] Iniciado en puerto %d\n", center_port);
-
-    // Catálogo consistente de blancos (corrige Error #1)
-    build_targets_catalog();
+    LOGI("Iniciado en puerto %d (SO_RCVBUF %d kB)", center_port, rcvbuf / 1024);
+    telemetry_ms = TELEMETRY_MS;
+    LOGI("Comandos de swarm por %s", group_available(params_path) ? "multicast" : "unicast");
+
+    mission_start = now_mono();
+    if(shard_id == 0) spawn_center_shards(restore);
+    if(restore){
+        if(center_restore() < 0) exit(1);
+        respawn_trucks_and_drones();
+    } else {
+        // Catálogo consistente de blancos (corrige Error #1)
+        build_targets_catalog();
 
-    spawn_trucks_and_drones();
+        spawn_trucks_and_drones();
+    }
 
-    pthread_t lt;
-    pthread_create(&lt,NULL,listener_thread,NULL);
+    pthread_t lt, rt;
+    sem_init(&sem_rate, 0, 0);
+    sim_thread_create(&rt, telemetry_rate_thread, NULL);
+    pthread_detach(rt);
+    sim_thread_create(&lt,listener_thread,NULL);
+    reliable_start();
+
+    static int control_fd = -1;
+    if(params_get_string(params_path, "CONTROL_SOCKET", control_path, sizeof(control_path))){
+        size_t len = strlen(control_path);
+        if(shard_id > 0) snprintf(control_path + len, sizeof(control_path) - len, ".%d", shard_id);
+        if((control_fd = control_open(control_path)) >= 0){
+            pthread_t ct;
+            sim_thread_create(&ct, control_thread, &control_fd);
+            pthread_detach(ct);
+            LOGI("Socket de control en %s (center_ctl %s HELP)", control_path, params_path);
+        }
+    }
+    if(params_watch(params_path, on_params_reload))
+        LOGI("Recarga en caliente de %s habilitada", params_path);
+    if(checkpointing){
+        center_checkpoint();
+        if(ckpt_start(checkpoint_secs, center_checkpoint) == 0)
+            LOGI("Instantáneas en %s/%s cada %d s", checkpoint_dir, checkpoint_name, checkpoint_secs);
+    }
 
     while(1){
         sleep(1);
 
+        plan_reassembly();
+        shard_tick();
         check_reassembly_timeouts();
+        reallocate_targets();
 
         static int status_counter = 0;
+        if(full_status_requested) {
+            full_status_requested = 0;
+            print_status(1);
+        }
         if(++status_counter >= 5) {
-            print_status();
+            print_status(0);
+            if(memstats_mode) print_memstats();
             status_counter = 0;
         }
 
-        if(all_drones_finished()){
-            printf("[CENTER] Todos los drones terminaron. Enviando señal de terminación a artillería...\n");
+        if(shard_id > 0){
+            // termina con el EXIT del shard 0 (o si el shard 0 ya no está)
+            if(shard_exit || getppid() != coordinator){
+                LOGI("Shard %d terminado", shard_id);
+                break;
+            }
+        }
+        else if(all_drones_finished() && shards_finished()){
+            LOGI("Todos los drones terminaron. Enviando señal de terminación a artillería...");
             msg_t term_msg; memset(&term_msg,0,sizeof(term_msg));
             term_msg.type = MSG_ARTILLERY;
             snprintf(term_msg.text,sizeof(term_msg.text),"TERMINATE");
             int artillery_port = port_for_artillery(BASE_PORT);
-            send_msg(center_sock, artillery_port, &term_msg);
+            send_msg_reliable(center_sock, artillery_port, &term_msg);
+            for(int k = 0; k < net_workers(); k++){
+                msg_t bye; memset(&bye,0,sizeof(bye));
+                bye.type = MSG_COMMAND;
+                snprintf(bye.text,sizeof(bye.text),"SHUTDOWN");
+                send_msg_reliable(center_sock, port_for_agent(BASE_PORT, k), &bye);
+            }
+            for(int k = 1; k < center_shards(); k++) shard_send(k, "EXIT");
             sleep(1);
             break;
         }
@@ -791,6 +2672,9 @@ int main(int argc, char **argv){
     pthread_join(lt,NULL);
     sem_destroy(&sem_swarms);
     sem_destroy(&sem_reassign_line);
+    sem_destroy(&sem_shards);
     close(center_sock);
+    if(control_fd >= 0) unlink(control_path);
     return 0;
 }
+#endif
@@ -1,7 +1,14 @@
 // drone.c (con movimiento en Y hacia blanco aleatorio y manejo de autodestrucción)
+// Un solo hilo: máquina de estados explícita movida por un bucle poll() que espera
+// el socket propio y el del grupo del swarm, el próximo paso del estado actual y
+// el agotamiento de combustible.
+//   ORBIT -> WAIT_TARGET -> CRUISE -> DEFENSE <-> LINK_LOST -> CRUISE -> ARRIVED | CAMERA -> DEAD
+// (HIT, AUTODESTRUCT_ALL o falta de combustible llevan a DEAD desde cualquier estado)
 #include "common.h"
+#include "checkpoint.h"
 #include <math.h>
-#include <semaphore.h>
+#include <poll.h>
+#include <fcntl.h>
 
 int BASE_PORT = 40000;
 int Q = 5;   // prob. pérdida de enlace
@@ -14,44 +21,84 @@ double B = 20.0;   // fin zona ensamble
 double A = 50.0;   // fin zona defensa / inicio re-ensamble
 double C = 100.0;  // blanco base X
 
+// Modelo de combustible (% por segundo según maniobra + % por unidad recorrida)
+double FUEL_ORBIT_RATE = 0.7;   // orbitando / esperando blanco
+double FUEL_CRUISE_RATE = 0.8;  // en crucero hacia el blanco
+double FUEL_LOITER_RATE = 1.0;  // en espera sin enlace o filmando
+double FUEL_PER_UNIT = 0.02;
+
 // Identidad / red
 int global_id;
 int swarm_id;
 int sock;
+int gsock = -1;   // grupo multicast del swarm (-1: los comandos de swarm llegan por unicast)
 int center_port;
-
-// Estado compartido
-volatile int have_link = 1;
-volatile int fuel_percent = 100;
-volatile int detonated = 0;
-volatile int reassigned = 0;
-volatile int is_camera = 0;
-volatile int autodestruct_received = 0; // Nuevo flag para autodestrucción
+int pos_port;     // artillería, o en modo distribuido el worker_agent del nodo (agrupa los POS)
+
+typedef enum {
+    ST_ORBIT,        // orbitando en (B,0) hasta TAKEOFF
+    ST_WAIT_TARGET,  // despegó pero aún no tiene blanco
+    ST_CRUISE,       // avanzando fuera de la zona de defensa
+    ST_DEFENSE,      // avanzando dentro de B <= x < A
+    ST_LINK_LOST,    // sin enlace, en espera de recuperarlo (hasta Z intentos)
+    ST_CAMERA,       // en el blanco filmando
+    ST_ARRIVED,      // detonó en el blanco
+    ST_DEAD
+} drone_state_t;
+
+static const char *state_names[] = {
+    "ORBIT", "WAIT_TARGET", "CRUISE", "DEFENSE", "LINK_LOST", "CAMERA", "ARRIVED", "DEAD"
+};
+
+drone_state_t state = ST_ORBIT;
+double next_step = 0.0;     // reloj monotónico del próximo paso del estado
+int entered_defense = 0;
+int announced_reassembly = 0;
+int link_attempts = 0;
+int is_camera = 0;
 
 // Coordenadas del blanco asignado
-volatile double target_x = 100.0;
-volatile double target_y = 0.0;
-volatile int target_id = 0;
-volatile int target_received = 0;
-
-// Semáforos
-sem_t sem_state;    // binario -> mutex
-sem_t sem_takeoff;  // 0 hasta que el centro ordene despegar
-
-pthread_t fuel_thread, weapon_thread, nav_thread;
+double target_x = 100.0;
+double target_y = 0.0;
+int target_id = 0;
+int target_received = 0;
+
+// Combustible: se calcula en forma perezosa al cambiar de modo o moverse
+typedef enum { FUEL_ORBIT, FUEL_CRUISE, FUEL_LOITER } fuel_mode_t;
+double fuel = 100.0;        // % al instante fuel_t
+double fuel_t = 0.0;        // reloj monotónico de la última actualización
+fuel_mode_t fuel_mode = FUEL_ORBIT;
+double fuel_speed = 0.0;    // velocidad nominal del modo, para predecir el agotamiento
 
 // Coordenadas y movimiento
 double x=0.0, y=0.0;
 double vx=10.0;        // velocidad en X (u/seg)
 double vy=10.0;        // velocidad en Y (u/seg)
+int vy_from_vx = 0;    // sin VY en params.txt: VY sigue a VX
 double theta=0.0;     // ángulo para orbitar
 double r=5.0;         // radio órbita
 double theta_step=0.3; // paso angular (rad/seg)
+double telemetry_period = 0.1; // período de órbita/telemetría; el centro lo ajusta con RATE
+unsigned rng;                  // estado de rand_r (va en la instantánea)
 
-static inline void state_lock()   { sem_wait(&sem_state); }
-static inline void state_unlock() { sem_post(&sem_state); }
+// Instantánea propia (CHECKPOINT_DIR/drone_<gid>.ckpt) para retomar con --restore
+char ckpt_dir[200] = "";
+int ckpt_secs = 30;
+char last_status[64] = "";     // último estado confiable enviado: el motivo si murió
 
+// Estado para el centro: confiable (con ACK y reintentos)
 void send_status(const char *txt){
+    msg_t m; memset(&m,0,sizeof(m));
+    m.type = MSG_STATUS;
+    m.swarm_id = swarm_id;
+    m.drone_id = global_id;
+    strncpy(m.text, txt, sizeof(m.text)-1);
+    send_msg_reliable(sock, center_port, &m);
+    snprintf(last_status, sizeof(last_status), "%s", txt);
+}
+
+// Telemetría periódica: sin confirmación, la próxima la reemplaza
+void send_telemetry(const char *txt){
     msg_t m; memset(&m,0,sizeof(m));
     m.type = MSG_STATUS;
     m.swarm_id = swarm_id;
@@ -66,301 +113,384 @@ void send_pos(){
     m.swarm_id = swarm_id;
     m.drone_id = global_id;
     snprintf(m.text, sizeof(m.text), "POS %.1f %.1f", x, y);
-    
+
     // Enviar al centro de control
     send_msg(sock, center_port, &m);
-    
+
     // Enviar también a la artillería
-    int artillery_port = port_for_artillery(BASE_PORT);
-    send_msg(sock, artillery_port, &m);
+    send_msg(sock, pos_port, &m);
+}
+
+static double now_mono(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
 }
 
-int is_detonated(){
-    int v;
-    state_lock(); v = detonated; state_unlock();
-    return v;
+static double fuel_mode_rate(fuel_mode_t mode){
+    return mode == FUEL_ORBIT ? FUEL_ORBIT_RATE :
+           mode == FUEL_CRUISE ? FUEL_CRUISE_RATE : FUEL_LOITER_RATE;
 }
-void set_detonated(){
-    state_lock(); detonated = 1; state_unlock();
+
+// Descuenta el consumo por tiempo desde la última actualización
+static void fuel_update(){
+    double t = now_mono();
+    fuel -= fuel_mode_rate(fuel_mode) * (t - fuel_t);
+    fuel_t = t;
 }
 
-int is_autodestruct_received(){
-    int v;
-    state_lock(); v = autodestruct_received; state_unlock();
-    return v;
+static void fuel_set_mode(fuel_mode_t mode, double speed){
+    fuel_update();
+    fuel_mode = mode;
+    fuel_speed = speed;
 }
-void set_autodestruct_received(){
-    state_lock(); autodestruct_received = 1; state_unlock();
+
+// Descuenta la distancia recorrida en un paso de navegación
+static void fuel_move(double dist){
+    fuel_update();
+    fuel -= FUEL_PER_UNIT * dist;
 }
 
-void perform_autodestruct(){
-    printf("[DRONE %d] Ejecutando autodestrucción por orden del centro de control\n", global_id);
-    send_status("AUTODESTRUCT_CONFIRMED");
-    set_detonated();
-    
-    // Dar tiempo para que el mensaje se envíe
-    usleep(100000); // 100ms
-    
-    // Cancelar todos los threads
-    pthread_cancel(fuel_thread);
-    pthread_cancel(weapon_thread);
-    pthread_cancel(nav_thread);
-    
-    // Limpiar recursos
-    sem_destroy(&sem_state);
-    sem_destroy(&sem_takeoff);
-    close(sock);
-    
-    exit(0);
+// Segundos hasta agotarse si se mantiene el modo y la velocidad actuales
+static double fuel_time_left(){
+    fuel_update();
+    double rate = fuel_mode_rate(fuel_mode) + FUEL_PER_UNIT * fuel_speed;
+    if(fuel <= 0) return 0;
+    return rate > 0 ? fuel / rate : 1e9;
 }
 
-void *fuel_control(void *arg){
-    (void)arg;
-    while(1){
-        // Verificar autodestrucción cada iteración
-        if(is_autodestruct_received()){
-            perform_autodestruct();
-        }
-        
-        sleep(1);
-        state_lock();
-        if(detonated){ state_unlock(); break; }
-        fuel_percent -= 1;
-        int fp = fuel_percent;
-        state_unlock();
-
-        if(fp <= 0){
-            send_status("FUEL_ZERO_AUTODESTRUCT");
-            set_detonated();
-            exit(0);
-        }
+// Período del paso de cada estado (WAIT_TARGET y DEAD no tienen pasos)
+static double state_period(drone_state_t s){
+    switch(s){
+    case ST_ORBIT:     return telemetry_period;
+    case ST_CRUISE:
+    case ST_DEFENSE:
+    case ST_LINK_LOST: return 1.0;
+    case ST_CAMERA:    return 6.0;
+    default:           return 1e9;
     }
-    return NULL;
 }
 
-void *weapon_or_camera(void *arg){
-    (void)arg;
-    // marca de cámara (ejemplo: id 5 de cada bloque de 100)
-    state_lock();
-    if(global_id % 100 == 5) is_camera = 1;
-    state_unlock();
+typedef struct {
+    int swarm_id, state, entered_defense, announced_reassembly, link_attempts;
+    int target_id, target_received, fuel_mode, Q, Z, vy_from_vx;
+    unsigned rng;
+    double fuel, fuel_speed, x, y, theta, target_x, target_y, vx, vy, telemetry_period;
+    char death[64];
+} drone_ckpt_t;
 
-    while(1){
-        // Verificar autodestrucción cada iteración
-        if(is_autodestruct_received()){
-            perform_autodestruct();
-        }
-        
-        sleep(1);
-        if(is_detonated()) break;
+static void drone_ckpt_emit(ckpt_out_t *o, void *arg){
+    ckpt_put(o, arg, sizeof(drone_ckpt_t));
+}
+
+static void drone_checkpoint(void){
+    if(!ckpt_dir[0]) return;
+    fuel_update();
+    drone_ckpt_t c; memset(&c, 0, sizeof(c));
+    c.swarm_id = swarm_id;
+    c.state = state;
+    c.entered_defense = entered_defense;
+    c.announced_reassembly = announced_reassembly;
+    c.link_attempts = link_attempts;
+    c.target_id = target_id;
+    c.target_received = target_received;
+    c.fuel_mode = fuel_mode;
+    c.Q = Q;
+    c.Z = Z;
+    c.vy_from_vx = vy_from_vx;
+    c.rng = rng;
+    c.fuel = fuel;
+    c.fuel_speed = fuel_speed;
+    c.x = x;
+    c.y = y;
+    c.theta = theta;
+    c.target_x = target_x;
+    c.target_y = target_y;
+    c.vx = vx;
+    c.vy = vy;
+    c.telemetry_period = telemetry_period;
+    if(state == ST_DEAD) snprintf(c.death, sizeof(c.death), "%s", last_status);
+    char name[32];
+    snprintf(name, sizeof(name), "drone_%d.ckpt", global_id);
+    if(ckpt_write(ckpt_dir, name, CKPT_DRONE, drone_ckpt_emit, &c) < 0)
+        printf("[DRONE %d] No se pudo escribir %s/%s: %s\n", global_id, ckpt_dir, name, strerror(errno));
+}
+
+// Retoma la instantánea propia; 0 si no hay (el drone arranca de cero). Si el drone ya
+// había muerto repite el aviso (el centro restaurado puede no tenerlo) y termina.
+static int drone_restore(void){
+    char name[32];
+    snprintf(name, sizeof(name), "drone_%d.ckpt", global_id);
+    size_t len;
+    drone_ckpt_t *c = ckpt_read(ckpt_dir, name, CKPT_DRONE, &len, NULL);
+    if(!c) return 0;
+    if(len != sizeof(*c)){ free(c); return 0; }
+    if(c->state == ST_DEAD){
+        printf("[DRONE %d] Ya había terminado (%s)\n", global_id, c->death);
+        if(c->death[0]) send_status(c->death);
+        reliable_flush(sock, 1000);
+        exit(0);
     }
-    return NULL;
+    state = c->state;
+    entered_defense = c->entered_defense;
+    announced_reassembly = c->announced_reassembly;
+    link_attempts = c->link_attempts;
+    target_id = c->target_id;
+    target_received = c->target_received;
+    Q = c->Q;
+    Z = c->Z;
+    vy_from_vx = c->vy_from_vx;
+    rng = c->rng;
+    x = c->x;
+    y = c->y;
+    theta = c->theta;
+    target_x = c->target_x;
+    target_y = c->target_y;
+    vx = c->vx;
+    vy = c->vy;
+    telemetry_period = c->telemetry_period;
+    fuel = c->fuel;
+    fuel_t = now_mono();
+    fuel_mode = c->fuel_mode;
+    fuel_speed = c->fuel_speed;
+    printf("[DRONE %d] Retomado: %s en (%.1f, %.1f), combustible %.1f%%\n",
+           global_id, state_names[state], x, y, fuel);
+    free(c);
+    return 1;
 }
 
-void *simulate_flight(void *arg){
-    (void)arg;
+// Transición: registra el cambio, ajusta el modo de combustible y reinicia el paso
+static void set_state(drone_state_t s, const char *reason){
+    if(s == state) return;
+    printf("[DRONE %d] %s -> %s (%s)\n", global_id, state_names[state], state_names[s], reason);
+    state = s;
+    switch(s){
+    case ST_ORBIT:       fuel_set_mode(FUEL_ORBIT, r * theta_step / 0.1); break;
+    case ST_WAIT_TARGET: fuel_set_mode(FUEL_ORBIT, 0.0); break;
+    case ST_CRUISE:
+    case ST_DEFENSE:     fuel_set_mode(FUEL_CRUISE, hypot(vx, vy)); break;
+    default:             fuel_set_mode(FUEL_LOITER, 0.0); break;
+    }
+    next_step = now_mono() + state_period(s);
+    if(s == ST_DEAD){
+        drone_checkpoint();   // muerto: --restore solo repite el aviso al centro
+        reliable_flush(sock, 1000);   // que el centro reciba el motivo antes de salir
+        close(sock);
+        if(gsock >= 0) close(gsock);
+        exit(0);
+    }
+}
 
-    // 1) Vuelo hasta zona de ensamble (orbitar)
-    // Espera a TAKEOFF con semáforo (centro hace sem_post)
-    while(1){
-        // Verificar autodestrucción cada iteración
-        if(is_autodestruct_received()){
-            perform_autodestruct();
-        }
-        
-        if(is_detonated()) return NULL;
-
-        // Orbitar en torno a (B,0)
-        state_lock();
-        theta += theta_step;
-        x = B + r*cos(theta);
-        y = r*sin(theta);
-        state_unlock();
-
-        send_status("IN_ASSEMBLY");
-        send_pos(); // Envía posición a centro Y artillería
-        // Espera TAKEOFF (tiempo corto para no bloquear totalmente)
-        struct timespec ts;
-        clock_gettime(CLOCK_REALTIME, &ts);
-        ts.tv_nsec += 100000000; // 0.1s
-        if(ts.tv_nsec >= 1000000000){ ts.tv_sec++; ts.tv_nsec-=1000000000; }
-        if(sem_timedwait(&sem_takeoff, &ts) == 0){
-            send_status("TAKEOFF_RECEIVED");
-            break; // salir de órbita y avanzar
+// Termina el drone informando el motivo al centro
+static void die(const char *status, const char *reason){
+    send_status(status);
+    set_state(ST_DEAD, reason);
+}
+
+// Un paso de órbita en torno a (B,0)
+static void step_orbit(){
+    // el paso angular está definido para 0.1 s: se escala con el período vigente
+    theta += theta_step * telemetry_period / 0.1;
+    double nx = B + r*cos(theta), ny = r*sin(theta);
+    fuel_move(hypot(nx - x, ny - y));
+    x = nx;
+    y = ny;
+
+    send_telemetry("IN_ASSEMBLY");
+    send_pos(); // Envía posición a centro Y artillería
+}
+
+// Un paso de avance hacia el blanco: movimiento en X e Y
+static void step_cruise(){
+    // Calcular dirección hacia el blanco
+    double dx = target_x - x;
+    double dy = target_y - y;
+    double distance = sqrt(dx*dx + dy*dy);
+
+    // Si estamos muy cerca del blanco, hemos llegado
+    if(distance < 2.0) { // Aumentar tolerancia
+        if(is_camera){
+            set_state(ST_CAMERA, "en el blanco");
+        } else {
+            // se informa el blanco efectivamente alcanzado (pudo cambiar en vuelo)
+            char txt[64];
+            snprintf(txt, sizeof(txt), "ARRIVED_DETONATED %d", target_id);
+            send_status(txt);
+            set_state(ST_ARRIVED, "en el blanco");
+            set_state(ST_DEAD, "detonado");
         }
+        return;
     }
 
-    // Esperar a recibir coordenadas del blanco antes de avanzar
-    while(!target_received && !is_detonated() && !is_autodestruct_received()) {
-        if(is_autodestruct_received()){
-            perform_autodestruct();
-        }
-        usleep(100000); // 100ms
+    // Mover hacia el blanco con paso fijo para evitar oscilaciones
+    if(distance > 0) {
+        // Normalizar y aplicar velocidad, pero no sobrepasar el blanco
+        double step_x = vx * dx / distance;
+        double step_y = vy * dy / distance;
+
+        // Limitar el paso para no sobrepasar el blanco
+        if(fabs(step_x) > fabs(dx)) step_x = dx;
+        if(fabs(step_y) > fabs(dy)) step_y = dy;
+
+        x += step_x;
+        y += step_y;
+        fuel_move(hypot(step_x, step_y));
     }
 
-    // 2) Avance hacia el blanco: movimiento en X e Y
-    int entered_defense = 0;
-    while(1){
-        // Verificar autodestrucción cada iteración
-        if(is_autodestruct_received()){
-            perform_autodestruct();
-        }
-        
-        if(is_detonated()) return NULL;
-        sleep(1);
-
-        // Obtener coordenadas del blanco
-        state_lock();
-        double tx = target_x;
-        double ty = target_y;
-        state_unlock();
-
-        // Calcular dirección hacia el blanco
-        double dx = tx - x;
-        double dy = ty - y;
-        double distance = sqrt(dx*dx + dy*dy);
-
-        // Si estamos muy cerca del blanco, hemos llegado
-        if(distance < 2.0) { // Aumentar tolerancia
-            state_lock();
-            int cam = is_camera;
-            state_unlock();
-            
-            if(cam){
-                sleep(6);
-                send_status("CAMERA_REPORTED");
-                send_status("CAMERA_AUTODESTRUCT");
-            } else {
-                send_status("ARRIVED_DETONATED");
-            }
-            set_detonated();
-            exit(0);
-        }
+    send_pos(); // Envía posición a centro Y artillería
+
+    if(state == ST_CRUISE && !entered_defense && x >= B && x < A){
+        entered_defense = 1;
+        send_status("ENTERING_DEFENSE");
+        // Notificar a artillería
+        msg_t art; memset(&art,0,sizeof(art));
+        art.type = MSG_ARTILLERY;
+        art.swarm_id = swarm_id;
+        art.drone_id = global_id;
+        snprintf(art.text,sizeof(art.text),"ENTERING_DEFENSE %d", global_id);
+        send_msg(sock, port_for_artillery(BASE_PORT), &art);
+        set_state(ST_DEFENSE, "x >= B");
+    }
 
-        // Mover hacia el blanco con paso fijo para evitar oscilaciones
-        state_lock();
-        if(distance > 0) {
-            // Normalizar y aplicar velocidad, pero no sobrepasar el blanco
-            double norm_dx = dx / distance;
-            double norm_dy = dy / distance;
-            
-            double step_x = vx * norm_dx;
-            double step_y = vy * norm_dy;
-            
-            // Limitar el paso para no sobrepasar el blanco
-            if(fabs(step_x) > fabs(dx)) step_x = dx;
-            if(fabs(step_y) > fabs(dy)) step_y = dy;
-            
-            x += step_x;
-            y += step_y;
-        }
-        double locx = x;
-        state_unlock();
-
-        send_pos(); // Envía posición a centro Y artillería
-
-        if(!entered_defense && locx >= B && locx < A){
-            entered_defense = 1;
-            send_status("ENTERING_DEFENSE");
-            // Notificar a artillería
-            msg_t art; memset(&art,0,sizeof(art));
-            art.type = MSG_ARTILLERY;
-            art.swarm_id = swarm_id;
-            art.drone_id = global_id;
-            snprintf(art.text,sizeof(art.text),"ENTERING_DEFENSE %d", global_id);
-            send_msg(sock, port_for_artillery(BASE_PORT), &art);
-        }
+    // Pérdida de enlace dentro de B->A
+    if(state == ST_DEFENSE && x < A && rand_r(&rng)%100 < Q){
+        link_attempts = 0;
+        send_status("LOST_LINK");
+        set_state(ST_LINK_LOST, "pérdida de enlace");
+        return;
+    }
 
-        // Pérdida de enlace dentro de B->A
-        if(locx >= B && locx < A){
-            if(rand()%100 < Q){
-                state_lock(); have_link = 0; state_unlock();
-                send_status("LOST_LINK");
-                int recovered = 0;
-                for(int w=0;w<Z;w++){
-                    // Verificar autodestrucción durante recuperación
-                    if(is_autodestruct_received()){
-                        perform_autodestruct();
-                    }
-                    sleep(1);
-                    if(rand()%100 < 50){ recovered = 1; break; }
-                }
-                if(!recovered){
-                    send_status("LINK_PERMANENT_LOSS");
-                    set_detonated();
-                    exit(0);
-                } else {
-                    state_lock(); have_link = 1; state_unlock();
-                    send_status("LINK_RESTORED");
-                }
-            }
-        }
+    // Anunciar re-ensamblaje si pasamos de A (solo una vez)
+    if(x >= A && !announced_reassembly){
+        announced_reassembly = 1;
+        send_status("IN_REASSEMBLY");
+        set_state(ST_CRUISE, "x >= A");
+    }
+}
 
-        // Anunciar re-ensamblaje si pasamos de A (solo una vez)
-        static int announced_reassembly = 0;
-        if(locx >= A && !announced_reassembly){
-            announced_reassembly = 1;
-            send_status("IN_REASSEMBLY");
-        }
+// Un intento de recuperar el enlace (50% por segundo, hasta Z intentos)
+static void step_link_lost(){
+    if(rand_r(&rng)%100 < 50){
+        send_status("LINK_RESTORED");
+        set_state(ST_DEFENSE, "enlace recuperado");
+    } else if(++link_attempts >= Z){
+        die("LINK_PERMANENT_LOSS", "enlace perdido");
+    }
+}
+
+// Ejecuta el paso periódico del estado actual
+static void on_step(){
+    switch(state){
+    case ST_ORBIT:     step_orbit(); break;
+    case ST_CRUISE:
+    case ST_DEFENSE:   step_cruise(); break;
+    case ST_LINK_LOST: step_link_lost(); break;
+    case ST_CAMERA:
+        send_status("CAMERA_REPORTED");
+        die("CAMERA_AUTODESTRUCT", "filmación terminada");
+        break;
+    default: break;
     }
-    return NULL;
 }
 
-void handle_command(msg_t *m){
+// Con TAKEOFF y blanco conocidos se sale hacia el blanco
+static void maybe_depart(){
+    if(state == ST_WAIT_TARGET && target_received) set_state(ST_CRUISE, "blanco recibido");
+}
+
+static void set_target(double tx, double ty, int tid){
+    target_x = tx;
+    target_y = ty;
+    target_id = tid;
+    target_received = 1;
+    maybe_depart();
+}
+
+void handle_command(const msg_view_t *m){
     if(strcmp(m->text,"TAKEOFF")==0){
-        sem_post(&sem_takeoff);
+        if(state == ST_ORBIT){
+            send_status("TAKEOFF_RECEIVED");
+            set_state(ST_WAIT_TARGET, "TAKEOFF");
+            maybe_depart();
+        }
     }
     else if(strncmp(m->text,"TARGET",6)==0){
         double tx, ty;
         int tid;
         if(sscanf(m->text,"TARGET %lf %lf %d", &tx, &ty, &tid) == 3){
-            state_lock();
-            target_x = tx;
-            target_y = ty;
-            target_id = tid;
-            target_received = 1;
-            state_unlock();
-            printf("[DRONE %d] Blanco asignado: ID=%d, Pos=(%.1f, %.1f)\n", 
+            printf("[DRONE %d] Blanco asignado: ID=%d, Pos=(%.1f, %.1f)\n",
                    global_id, tid, tx, ty);
+            set_target(tx, ty, tid);
         }
     }
     else if(strncmp(m->text,"RETARGET",8)==0){
         double tx, ty;
         int tid;
         if(sscanf(m->text,"RETARGET %lf %lf %d", &tx, &ty, &tid) == 3){
-            state_lock();
-            target_x = tx;
-            target_y = ty;
-            target_id = tid;
-            target_received = 1;
-            state_unlock();
-            printf("[DRONE %d] Blanco reasignado: ID=%d, Pos=(%.1f, %.1f)\n", 
+            printf("[DRONE %d] Blanco reasignado: ID=%d, Pos=(%.1f, %.1f)\n",
                    global_id, tid, tx, ty);
             send_status("RETARGET_RECEIVED");
+            set_target(tx, ty, tid);
         }
     }
-    else if(strncmp(m->text,"GO_TO_SWARM",11)==0){
-        int target = -1;
-        if(sscanf(m->text+11,"%d",&target)==1){
-            state_lock();
+    else if(strncmp(m->text,"REASSIGN ",9)==0){
+        // Reasignación completa en un solo mensaje: "REASSIGN swarm x y id"
+        int target;
+        double tx, ty;
+        int tid;
+        if(sscanf(m->text,"REASSIGN %d %lf %lf %d", &target, &tx, &ty, &tid) == 4){
+            group_move(gsock, swarm_id, target);
             swarm_id = target;
-            reassigned = 1;
-            state_unlock();
+            // con el centro particionado el swarm nuevo puede ser de otro shard
+            center_port = port_for_center_shard(BASE_PORT, center_shard_of_swarm(swarm_id));
+            printf("[DRONE %d] Reasignado a swarm %d, blanco ID=%d, Pos=(%.1f, %.1f)\n",
+                   global_id, target, tid, tx, ty);
             send_status("REASSIGNED");
+            set_target(tx, ty, tid);
         }
     }
+    else if(strncmp(m->text,"RATE ",5)==0){
+        int ms = atoi(m->text + 5);
+        if(ms >= 10 && ms <= 10000 && ms != (int)(telemetry_period * 1000 + 0.5)){
+            telemetry_period = ms / 1000.0;
+            printf("[DRONE %d] Período de telemetría: %d ms\n", global_id, ms);
+        }
+    }
+    // parámetros cambiados en caliente en el centro: "CONFIG Q=7 VX=6 ..."
+    else if(strncmp(m->text,"CONFIG ",7)==0){
+        char key[16]; double v; int n;
+        for(const char *p = m->text + 7; sscanf(p, " %15[^= ]=%lf%n", key, &v, &n) == 2; p += n){
+            if(strcmp(key,"Q")==0) Q = (int)v;
+            else if(strcmp(key,"Z")==0) Z = (int)v;
+            else if(strcmp(key,"VX")==0 && v > 0){ vx = v; if(vy_from_vx) vy = v; }
+            else if(strcmp(key,"VY")==0){ vy_from_vx = v <= 0; vy = vy_from_vx ? vx : v; }
+        }
+        if(state == ST_CRUISE || state == ST_DEFENSE) fuel_set_mode(FUEL_CRUISE, hypot(vx, vy));
+        printf("[DRONE %d] Parámetros: Q=%d%% Z=%d VX=%.1f VY=%.1f\n", global_id, Q, Z, vx, vy);
+    }
     else if(strcmp(m->text,"AUTODESTRUCT_ALL")==0){
-        printf("[DRONE %d] Recibido comando AUTODESTRUCT_ALL del centro de control\n", global_id);
-        set_autodestruct_received();
-        // La autodestrucción se ejecutará en el próximo ciclo de cualquier thread
+        printf("[DRONE %d] Ejecutando autodestrucción por orden del centro de control\n", global_id);
+        die("AUTODESTRUCT_CONFIRMED", "AUTODESTRUCT_ALL");
+    }
+}
+
+static void handle_message(const msg_view_t *m){
+    if(m->type==MSG_COMMAND){
+        handle_command(m);
+    } else if(m->type==MSG_ARTILLERY){
+        if(strstr(m->text,"HIT")){
+            printf("[DRONE %d] ¡Impactado por artillería! Destruyendo...\n", global_id);
+            die("SHOT_DOWN_BY_ARTILLERY", "derribado");
+        }
     }
 }
 
 int main(int argc, char **argv){
-    if(argc<4){ fprintf(stderr,"Usage: drone params.txt <global_id> <truck_id>\n"); exit(1); }
+    if(argc<4){ fprintf(stderr,"Usage: drone params.txt <global_id> <truck_id> [--restore]\n"); exit(1); }
     char *params = argv[1];
     global_id = atoi(argv[2]);
     int truck_id = atoi(argv[3]);
+    int restore = argc > 4 && strcmp(argv[4], "--restore") == 0;
     swarm_id = truck_id;
 
     // Cargar parámetros
@@ -369,7 +499,8 @@ int main(int argc, char **argv){
         char line[200];
         while(fgets(line,sizeof(line),f)){
             if(line[0]=='#') continue;
-            char key[80]; double dval; int val;
+            char key[80]; double dval;
+            // %lf también lee los enteros: se convierten según la clave
             if(sscanf(line,"%[^=]=%lf",key,&dval)==2){
                 if(strcmp(key,"VX")==0) vx = dval;
                 if(strcmp(key,"VY")==0) vy = dval; // Nueva velocidad Y
@@ -378,37 +509,54 @@ int main(int argc, char **argv){
                 if(strcmp(key,"B")==0) B = dval;
                 if(strcmp(key,"A")==0) A = dval;
                 if(strcmp(key,"C")==0) C = dval;
-            } else if(sscanf(line,"%[^=]=%d",key,&val)==2){
-                if(strcmp(key,"BASE_PORT")==0) BASE_PORT=val;
-                if(strcmp(key,"Q")==0) Q=val;
-                if(strcmp(key,"Z")==0) Z=val;
-                if(strcmp(key,"W")==0) W=val;
-                if(strcmp(key,"ASSEMBLY_SIZE")==0) ASSEMBLY_SIZE=val;
+                if(strcmp(key,"FUEL_ORBIT_RATE")==0) FUEL_ORBIT_RATE = dval;
+                if(strcmp(key,"FUEL_CRUISE_RATE")==0) FUEL_CRUISE_RATE = dval;
+                if(strcmp(key,"FUEL_LOITER_RATE")==0) FUEL_LOITER_RATE = dval;
+                if(strcmp(key,"FUEL_PER_UNIT")==0) FUEL_PER_UNIT = dval;
+                if(strcmp(key,"BASE_PORT")==0) BASE_PORT=(int)dval;
+                if(strcmp(key,"Q")==0) Q=(int)dval;
+                if(strcmp(key,"Z")==0) Z=(int)dval;
+                if(strcmp(key,"W")==0) W=(int)dval;
+                if(strcmp(key,"ASSEMBLY_SIZE")==0) ASSEMBLY_SIZE=(int)dval;
+                if(strcmp(key,"TELEMETRY_MS")==0 && dval >= 10) telemetry_period = dval / 1000.0;
             }
         }
         fclose(f);
     }
 
     // Si no se especificó VY, usar el mismo valor que VX
-    if(vy == 10.0 && vx != 10.0) vy = vx;
+    if(vy == 10.0) { vy = vx; vy_from_vx = 1; }
 
-    // Inicializar semáforos
-    sem_init(&sem_state, 0, 1);
-    sem_init(&sem_takeoff, 0, 0);
+    // marca de cámara (ejemplo: id 5 de cada bloque de 100)
+    is_camera = (global_id % 100 == 5);
 
-    center_port = port_for_center(BASE_PORT);
     sock = make_udp_socket();
+    budget_load(params);
+    // el nodo (y la dirección) del drone sale de su swarm original, no del actual
+    int worker = net_load(params) > 0 ? net_worker_of_swarm((global_id - 1) / 100) : -1;
+    center_port = port_for_center_shard(BASE_PORT, center_shard_of_swarm(swarm_id));
+    pos_port = worker >= 0 ? port_for_agent(BASE_PORT, worker) : port_for_artillery(BASE_PORT);
+    budget_rcvbuf(sock, 3);   // truck, centro y artillería
 
     // bind a puerto del dron
     int dport = port_for_drone(BASE_PORT, global_id);
     struct sockaddr_in addr; memset(&addr,0,sizeof(addr));
     addr.sin_family = AF_INET;
-    addr.sin_addr.s_addr = inet_addr(HOST);
+    addr.sin_addr.s_addr = net_addr_for_port(dport);
     addr.sin_port = htons(dport);
     if(bind(sock,(struct sockaddr*)&addr,sizeof(addr))<0){
         perror("bind drone");
         exit(1);
     }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+
+    rng = time(NULL) ^ global_id;
+    fuel_t = now_mono();
+    ckpt_config(params, ckpt_dir, sizeof(ckpt_dir), &ckpt_secs);
+    int restored = restore && ckpt_dir[0] && drone_restore();
+    gsock = group_open(BASE_PORT, swarm_id, sock);
+    if(gsock >= 0) fcntl(gsock, F_SETFL, fcntl(gsock, F_GETFL) | O_NONBLOCK);
+    else printf("[DRONE %d] Sin grupo multicast: comandos de swarm por unicast\n", global_id);
 
     // HELLO inicial con PID para que el centro pueda hacer seguimiento
     msg_t hello; memset(&hello,0,sizeof(hello));
@@ -416,36 +564,42 @@ int main(int argc, char **argv){
     hello.swarm_id = swarm_id;
     hello.drone_id = global_id;
     snprintf(hello.text,sizeof(hello.text),"DRONE_HELLO %d PID %d", global_id, getpid());
-    send_msg(sock, center_port, &hello);
+    send_msg_reliable(sock, center_port, &hello);
 
-    srand(time(NULL) ^ global_id);
+    // 1) Vuelo hasta zona de ensamble (orbitar) hasta que el centro ordene despegar
+    if(!restored) fuel_set_mode(FUEL_ORBIT, r * theta_step / 0.1);
+    next_step = now_mono();
+    double next_ckpt = 0;
 
-    pthread_create(&fuel_thread,NULL,fuel_control,NULL);
-    pthread_create(&weapon_thread,NULL,weapon_or_camera,NULL);
-    pthread_create(&nav_thread,NULL,simulate_flight,NULL);
-
-    // Bucle de recepción
-    msg_t rcv; struct sockaddr_in from;
+    // Bucle de eventos: socket, paso del estado y agotamiento de combustible
+    msg_view_t rcv; struct sockaddr_in from;
     while(1){
-        // Verificar autodestrucción en el bucle principal también
-        if(is_autodestruct_received()){
-            perform_autodestruct();
+        double now = now_mono();
+        double left = fuel_time_left();
+        double deadline = next_step < now + left ? next_step : now + left;
+        int retry_ms = reliable_tick();
+        if(retry_ms >= 0 && now + retry_ms / 1000.0 < deadline) deadline = now + retry_ms / 1000.0;
+        int timeout_ms = deadline > now ? (int)ceil((deadline - now) * 1000) : 0;
+
+        struct pollfd pfd[2] = { { sock, POLLIN, 0 }, { gsock, POLLIN, 0 } };
+        if(poll(pfd, gsock >= 0 ? 2 : 1, timeout_ms) > 0){
+            while(recv_view(sock,&rcv,&from) > 0) handle_message(&rcv);
+            if(gsock >= 0) while(recv_view(gsock,&rcv,&from) > 0) handle_message(&rcv);
+        }
+
+        if(fuel_time_left() < 1e-3){
+            printf("[DRONE %d] Combustible agotado\n", global_id);
+            die("FUEL_ZERO_AUTODESTRUCT", "sin combustible");
         }
-        
-        if(recv_msg(sock,&rcv,&from)<=0){ 
-            usleep(100000); 
-            continue; 
+        now = now_mono();
+        if(ckpt_dir[0] && now >= next_ckpt){
+            drone_checkpoint();
+            next_ckpt = now + ckpt_secs;
         }
-        
-        if(rcv.type==MSG_COMMAND){
-            handle_command(&rcv);
-        } else if(rcv.type==MSG_ARTILLERY){
-            if(strstr(rcv.text,"HIT")){
-                printf("[DRONE %d] ¡Impactado por artillería! Destruyendo...\n", global_id);
-                send_status("SHOT_DOWN_BY_ARTILLERY");
-                set_detonated();
-                exit(0);
-            }
+        if(now >= next_step){
+            next_step += state_period(state);
+            if(next_step < now) next_step = now + state_period(state);
+            on_step();
         }
     }
     return 0;
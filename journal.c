@@ -0,0 +1,121 @@
+// journal.c
+#define _GNU_SOURCE   // mremap
+#include "common.h"
+#include "journal.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <semaphore.h>
+
+#define JOURNAL_GROW_RECS 65536   // 2MB por extensión
+
+static int jfd = -1;
+static char *jmap = NULL;
+static size_t jmap_len = 0;
+static uint64_t jcapacity = 0;
+static journal_source_t jsrc = JSRC_CENTER;
+static sem_t sem_journal;
+
+static const char *event_names[JEV_COUNT] = {
+    "NONE", "SWARM_TARGET", "HELLO", "TERMINATED", "REASSIGN",
+    "REASSEMBLY_START", "REASSEMBLY_COMPLETE", "REASSEMBLY_TIMEOUT",
+    "TAKEOFF", "CAMERA_REPORT", "TARGET_DESTROYED",
+    "HIT", "ZONE_ENTER", "ZONE_EXIT",
+    "RETARGET",
+};
+
+static const char *cause_names[TERM_COUNT] = {
+    "DETONATED", "FUEL", "LINK_LOSS", "SHOT_DOWN", "CAMERA", "ARTILLERY",
+};
+
+const char *journal_event_name(int type){
+    return (type >= 0 && type < JEV_COUNT) ? event_names[type] : "?";
+}
+
+const char *term_cause_name(int cause){
+    return (cause >= 0 && cause < TERM_COUNT) ? cause_names[cause] : "?";
+}
+
+term_cause_t term_cause_from_text(const char *text){
+    if(strstr(text, "FUEL_ZERO"))          return TERM_FUEL;
+    if(strstr(text, "LINK_PERMANENT_LOSS")) return TERM_LINK_LOSS;
+    if(strstr(text, "SHOT_DOWN"))          return TERM_SHOT_DOWN;
+    if(strstr(text, "CAMERA_AUTODESTRUCT")) return TERM_CAMERA;
+    return TERM_DETONATED;
+}
+
+static uint64_t now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Extiende el archivo y re-mapea (se asume sem_journal tomado)
+static int journal_grow(void){
+    uint64_t new_cap = jcapacity + JOURNAL_GROW_RECS;
+    size_t new_len = sizeof(journal_hdr_t) + new_cap * sizeof(journal_rec_t);
+    if(ftruncate(jfd, new_len) < 0){ perror("ftruncate journal"); return -1; }
+    void *p = jmap ? mremap(jmap, jmap_len, new_len, MREMAP_MAYMOVE)
+                   : mmap(NULL, new_len, PROT_READ|PROT_WRITE, MAP_SHARED, jfd, 0);
+    if(p == MAP_FAILED){ perror("mmap journal"); return -1; }
+    jmap = p;
+    jmap_len = new_len;
+    jcapacity = new_cap;
+    return 0;
+}
+
+int journal_open(const char *path, journal_source_t src){
+    if(!path || !path[0]) return 0;
+    jfd = open(path, O_RDWR|O_CREAT|O_TRUNC, 0644);
+    if(jfd < 0){ perror("open journal"); return -1; }
+    sem_init(&sem_journal, 0, 1);
+    jsrc = src;
+    if(journal_grow() < 0){ close(jfd); jfd = -1; return -1; }
+
+    journal_hdr_t *h = (journal_hdr_t*)jmap;
+    memcpy(h->magic, JOURNAL_MAGIC, sizeof(h->magic));
+    h->version = JOURNAL_VERSION;
+    h->rec_size = sizeof(journal_rec_t);
+    h->count = 0;
+    h->start_ns = now_ns();
+    atexit(journal_close);
+    return 0;
+}
+
+void journal_close(void){
+    if(jfd < 0) return;
+    sem_wait(&sem_journal);
+    journal_hdr_t *h = (journal_hdr_t*)jmap;
+    size_t used = sizeof(journal_hdr_t) + h->count * sizeof(journal_rec_t);
+    msync(jmap, jmap_len, MS_SYNC);
+    munmap(jmap, jmap_len);
+    if(ftruncate(jfd, used) < 0) perror("ftruncate journal");
+    close(jfd);
+    jfd = -1;
+    jmap = NULL;
+    sem_post(&sem_journal);
+}
+
+// Al ser MAP_SHARED, lo escrito sobrevive a un crash del proceso
+void journal_append(journal_event_t type, int swarm_id, int drone_id, int arg, double x, double y){
+    if(jfd < 0) return;
+    sem_wait(&sem_journal);
+    if(jfd < 0){ sem_post(&sem_journal); return; }
+    journal_hdr_t *h = (journal_hdr_t*)jmap;
+    if(h->count >= jcapacity && journal_grow() < 0){
+        sem_post(&sem_journal);
+        return;
+    }
+    h = (journal_hdr_t*)jmap;
+    journal_rec_t *r = (journal_rec_t*)(jmap + sizeof(journal_hdr_t)) + h->count;
+    r->ts_ns = now_ns();
+    r->type = (uint16_t)type;
+    r->source = (uint16_t)jsrc;
+    r->swarm_id = swarm_id;
+    r->drone_id = drone_id;
+    r->arg = arg;
+    r->x = (float)x;
+    r->y = (float)y;
+    __atomic_store_n(&h->count, h->count + 1, __ATOMIC_RELEASE);
+    sem_post(&sem_journal);
+}
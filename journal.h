@@ -0,0 +1,73 @@
+// journal.h - diario binario de eventos de misión (append-only, mmap)
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+
+#define JOURNAL_MAGIC   "DJRNL01"
+#define JOURNAL_VERSION 1
+
+typedef enum {
+    JEV_NONE = 0,
+    // control_center
+    JEV_SWARM_TARGET,       // swarm asignado a blanco: arg=target_id, x/y=coords
+    JEV_HELLO,              // drone se registra en swarm
+    JEV_TERMINATED,         // drone terminado: arg=causa (term_cause_t)
+    JEV_REASSIGN,           // drone movido: swarm_id=origen, arg=destino
+    JEV_REASSEMBLY_START,
+    JEV_REASSEMBLY_COMPLETE,
+    JEV_REASSEMBLY_TIMEOUT, // swarm autodestruido por timeout
+    JEV_TAKEOFF,
+    JEV_CAMERA_REPORT,      // arg=drones que atacaron
+    JEV_TARGET_DESTROYED,   // arg=target_id
+    // artillery
+    JEV_HIT,                // x/y=posición del impacto
+    JEV_ZONE_ENTER,
+    JEV_ZONE_EXIT,
+    // control_center (agregados al final para no renumerar diarios existentes)
+    JEV_RETARGET,           // swarm en vuelo redirigido: arg=nuevo target_id, x/y=coords
+    JEV_COUNT
+} journal_event_t;
+
+typedef enum {
+    TERM_DETONATED,
+    TERM_FUEL,
+    TERM_LINK_LOSS,
+    TERM_SHOT_DOWN,
+    TERM_CAMERA,
+    TERM_ARTILLERY,
+    TERM_COUNT
+} term_cause_t;
+
+typedef enum { JSRC_CENTER = 0, JSRC_ARTILLERY = 1 } journal_source_t;
+
+// 32 bytes por registro, sin padding
+typedef struct {
+    uint64_t ts_ns;     // CLOCK_REALTIME
+    uint16_t type;
+    uint16_t source;
+    int32_t  swarm_id;
+    int32_t  drone_id;
+    int32_t  arg;
+    float    x, y;
+} journal_rec_t;
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t rec_size;
+    uint64_t count;     // registros válidos (se actualiza tras escribir cada uno)
+    uint64_t start_ns;
+    char     reserved[32];
+} journal_hdr_t;        // 64 bytes
+
+// Abre (trunca) el diario del proceso. path NULL o vacío = deshabilitado.
+int  journal_open(const char *path, journal_source_t src);
+void journal_close(void);
+void journal_append(journal_event_t type, int swarm_id, int drone_id, int arg, double x, double y);
+
+const char *journal_event_name(int type);
+const char *term_cause_name(int cause);
+term_cause_t term_cause_from_text(const char *text);
+
+#endif
@@ -0,0 +1,283 @@
+// journal_replay.c - reconstruye el estado de la misión desde los diarios
+// journal_replay [-t segundos] [-e] center.journal [artillery.journal]
+#include "common.h"
+#include "journal.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MAX_JOURNALS 8
+
+typedef struct {
+    const char *path;
+    const journal_hdr_t *hdr;
+    const journal_rec_t *recs;
+    uint64_t count;
+    uint64_t pos;       // siguiente registro a procesar
+    uint64_t end;       // primer registro posterior al instante pedido
+    size_t len;
+} journal_file_t;
+
+typedef struct {
+    int seen;
+    int target_id;
+    double tx, ty;
+    int *members;       // ids de drones vivos
+    int n_members, cap_members;
+    int took_off;
+    int in_reassembly;
+    int destroyed;      // autodestruido por timeout
+    int target_destroyed;
+    int camera_attackers;
+} swarm_state_t;
+
+typedef struct {
+    int seen;
+    int swarm_id;
+    int alive;
+    int cause;
+    int in_zone;
+} drone_state_t;
+
+static swarm_state_t *swarms = NULL;
+static int n_swarms = 0;
+static drone_state_t *drones = NULL;
+static int n_drones = 0;
+static int hits = 0, reassigns = 0;
+static int term_by_cause[TERM_COUNT];
+
+static void *grow_array(void *arr, int *n, int need, size_t elem){
+    if(need < *n) return arr;
+    int new_n = *n ? *n : 64;
+    while(new_n <= need) new_n *= 2;
+    arr = realloc(arr, new_n * elem);
+    if(!arr){ perror("realloc"); exit(1); }
+    memset((char*)arr + (size_t)(*n) * elem, 0, (size_t)(new_n - *n) * elem);
+    *n = new_n;
+    return arr;
+}
+
+static swarm_state_t *swarm_at(int id){
+    if(id < 0) return NULL;
+    swarms = grow_array(swarms, &n_swarms, id, sizeof(swarm_state_t));
+    swarms[id].seen = 1;
+    return &swarms[id];
+}
+
+static drone_state_t *drone_at(int id){
+    if(id <= 0) return NULL;
+    drones = grow_array(drones, &n_drones, id, sizeof(drone_state_t));
+    return &drones[id];
+}
+
+static void swarm_add_member(swarm_state_t *s, int did){
+    for(int i = 0; i < s->n_members; i++) if(s->members[i] == did) return;
+    if(s->n_members == s->cap_members){
+        s->cap_members = s->cap_members ? s->cap_members * 2 : 8;
+        s->members = realloc(s->members, s->cap_members * sizeof(int));
+        if(!s->members){ perror("realloc"); exit(1); }
+    }
+    s->members[s->n_members++] = did;
+}
+
+static void swarm_remove_member(swarm_state_t *s, int did){
+    for(int i = 0; i < s->n_members; i++){
+        if(s->members[i] == did){
+            s->members[i] = s->members[--s->n_members];
+            return;
+        }
+    }
+}
+
+static void apply(const journal_rec_t *r){
+    swarm_state_t *s = swarm_at(r->swarm_id);
+    drone_state_t *d = drone_at(r->drone_id);
+
+    switch(r->type){
+    case JEV_SWARM_TARGET:
+        if(s){ s->target_id = r->arg; s->tx = r->x; s->ty = r->y; }
+        break;
+    case JEV_RETARGET:
+        if(s){ s->target_id = r->arg; s->tx = r->x; s->ty = r->y; s->target_destroyed = 0; }
+        break;
+    case JEV_HELLO:
+        if(s && d){
+            d->seen = 1; d->alive = 1; d->swarm_id = r->swarm_id;
+            swarm_add_member(s, r->drone_id);
+        }
+        break;
+    case JEV_TERMINATED:
+        if(d && d->alive){
+            d->alive = 0;
+            d->cause = r->arg;
+            if(r->arg >= 0 && r->arg < TERM_COUNT) term_by_cause[r->arg]++;
+        }
+        if(s) swarm_remove_member(s, r->drone_id);
+        break;
+    case JEV_REASSIGN: {
+        swarm_state_t *to = swarm_at(r->arg);
+        if(s) swarm_remove_member(s, r->drone_id);
+        if(to) swarm_add_member(to, r->drone_id);
+        if(d) d->swarm_id = r->arg;
+        reassigns++;
+        break;
+    }
+    case JEV_REASSEMBLY_START:    if(s) s->in_reassembly = 1; break;
+    case JEV_REASSEMBLY_COMPLETE: if(s) s->in_reassembly = 0; break;
+    case JEV_REASSEMBLY_TIMEOUT:
+        if(s){
+            for(int i = 0; i < s->n_members; i++){
+                drone_state_t *m = drone_at(s->members[i]);
+                if(m) m->alive = 0;
+            }
+            s->n_members = 0;
+            s->in_reassembly = 0;
+            s->destroyed = 1;
+        }
+        break;
+    case JEV_TAKEOFF:          if(s) s->took_off = 1; break;
+    case JEV_CAMERA_REPORT:    if(s) s->camera_attackers = r->arg; break;
+    case JEV_TARGET_DESTROYED: if(s) s->target_destroyed = 1; break;
+    case JEV_HIT:
+        hits++;
+        if(d) d->in_zone = 0;
+        break;
+    case JEV_ZONE_ENTER: if(d) d->in_zone = 1; break;
+    case JEV_ZONE_EXIT:  if(d) d->in_zone = 0; break;
+    }
+}
+
+static int open_journal(journal_file_t *j, const char *path){
+    int fd = open(path, O_RDONLY);
+    if(fd < 0){ perror(path); return -1; }
+    struct stat st;
+    if(fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(journal_hdr_t)){
+        fprintf(stderr, "%s: archivo demasiado corto\n", path);
+        close(fd);
+        return -1;
+    }
+    void *p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED){ perror("mmap"); return -1; }
+
+    j->path = path;
+    j->len = st.st_size;
+    j->hdr = p;
+    if(memcmp(j->hdr->magic, JOURNAL_MAGIC, sizeof(j->hdr->magic)) != 0 ||
+       j->hdr->rec_size != sizeof(journal_rec_t)){
+        fprintf(stderr, "%s: no es un diario válido\n", path);
+        munmap(p, st.st_size);
+        return -1;
+    }
+    j->recs = (const journal_rec_t*)((const char*)p + sizeof(journal_hdr_t));
+    uint64_t max_recs = (st.st_size - sizeof(journal_hdr_t)) / sizeof(journal_rec_t);
+    j->count = j->hdr->count < max_recs ? j->hdr->count : max_recs;
+    j->pos = 0;
+    return 0;
+}
+
+// Los registros de un diario están ordenados por ts: búsqueda binaria del corte
+static uint64_t upper_bound_ts(const journal_file_t *j, uint64_t ts){
+    uint64_t lo = 0, hi = j->count;
+    while(lo < hi){
+        uint64_t mid = lo + (hi - lo) / 2;
+        if(j->recs[mid].ts_ns <= ts) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+static void print_event(const journal_rec_t *r, uint64_t t0){
+    double t = (double)(r->ts_ns - t0) / 1e9;
+    printf("%9.3f %-10s %-20s swarm=%d drone=%d", t,
+           r->source == JSRC_ARTILLERY ? "ARTILLERY" : "CENTER",
+           journal_event_name(r->type), r->swarm_id, r->drone_id);
+    if(r->type == JEV_TERMINATED) printf(" causa=%s", term_cause_name(r->arg));
+    else if(r->type == JEV_REASSIGN) printf(" destino=%d", r->arg);
+    else if(r->arg) printf(" arg=%d", r->arg);
+    if(r->x != 0 || r->y != 0) printf(" (%.1f,%.1f)", r->x, r->y);
+    printf("\n");
+}
+
+static void print_state(double at){
+    printf("=== ESTADO EN t=%.3fs ===\n", at);
+    int alive = 0, in_zone = 0;
+    for(int i = 0; i < n_drones; i++){
+        if(drones[i].alive) alive++;
+        if(drones[i].alive && drones[i].in_zone) in_zone++;
+    }
+    for(int i = 0; i < n_swarms; i++){
+        swarm_state_t *s = &swarms[i];
+        if(!s->seen) continue;
+        printf("Swarm %d: active=%d target=%d(%.1f,%.1f)%s%s drones:",
+               i, s->n_members, s->target_id, s->tx, s->ty,
+               s->target_destroyed ? "[DESTRUIDO]" : "[ENTERO]",
+               s->took_off ? " [DESPEGADO]" : "");
+        for(int k = 0; k < s->n_members; k++) printf(" %d", s->members[k]);
+        if(s->in_reassembly) printf(" [RECONFORMANDO]");
+        if(s->destroyed) printf(" [AUTODESTRUIDO]");
+        if(s->camera_attackers) printf(" [CAMARA: %d atacaron]", s->camera_attackers);
+        printf("\n");
+    }
+    printf("Drones vivos: %d (en zona defensa: %d), reasignaciones: %d, impactos: %d\n",
+           alive, in_zone, reassigns, hits);
+    printf("Terminados por causa:");
+    for(int c = 0; c < TERM_COUNT; c++) printf(" %s=%d", term_cause_name(c), term_by_cause[c]);
+    printf("\n");
+}
+
+int main(int argc, char **argv){
+    double at = -1;
+    int show_events = 0;
+    journal_file_t files[MAX_JOURNALS];
+    int nfiles = 0;
+
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "-t") == 0 && i + 1 < argc) at = atof(argv[++i]);
+        else if(strcmp(argv[i], "-e") == 0) show_events = 1;
+        else if(nfiles < MAX_JOURNALS){
+            if(open_journal(&files[nfiles], argv[i]) == 0) nfiles++;
+        }
+    }
+    if(nfiles == 0){
+        fprintf(stderr, "Uso: journal_replay [-t segundos] [-e] center.journal [artillery.journal]\n");
+        return 1;
+    }
+
+    // t=0 es el inicio del diario más antiguo
+    uint64_t t0 = files[0].hdr->start_ns;
+    for(int i = 1; i < nfiles; i++)
+        if(files[i].hdr->start_ns < t0) t0 = files[i].hdr->start_ns;
+    uint64_t cut = (at < 0) ? UINT64_MAX : t0 + (uint64_t)(at * 1e9);
+
+    uint64_t total = 0;
+    for(int i = 0; i < nfiles; i++){
+        files[i].end = upper_bound_ts(&files[i], cut);
+        total += files[i].end;
+    }
+
+    // Mezcla k-way por timestamp
+    for(uint64_t n = 0; n < total; n++){
+        journal_file_t *best = NULL;
+        for(int i = 0; i < nfiles; i++){
+            journal_file_t *j = &files[i];
+            if(j->pos >= j->end) continue;
+            if(!best || j->recs[j->pos].ts_ns < best->recs[best->pos].ts_ns) best = j;
+        }
+        const journal_rec_t *r = &best->recs[best->pos++];
+        if(show_events) print_event(r, t0);
+        apply(r);
+    }
+
+    if(at < 0){
+        uint64_t last = t0;
+        for(int i = 0; i < nfiles; i++)
+            if(files[i].end && files[i].recs[files[i].end-1].ts_ns > last)
+                last = files[i].recs[files[i].end-1].ts_ns;
+        at = (double)(last - t0) / 1e9;
+    }
+    print_state(at);
+    printf("(%llu eventos aplicados)\n", (unsigned long long)total);
+
+    for(int i = 0; i < nfiles; i++) munmap((void*)files[i].hdr, files[i].len);
+    return 0;
+}
@@ -0,0 +1,402 @@
+// loadgen.c - generador de carga sintético contra control_center y artillery reales
+// Suplanta NUM_SWARMS trucks y NUM_SWARMS*ASSEMBLY_SIZE drones (puertos reales) y mide:
+//   - latencia IN_ASSEMBLY -> llegada de TAKEOFF al dron (vía truck simulado)
+//   - latencia SHOT_DOWN -> remoción en el centro (confirmada con PING/PONG)
+//   - techo de throughput antes de perder datagramas y CPU por mensaje
+// loadgen [-s swarms] [-a assembly] [-r max_rate] [-d step_ms] [-p base_port]
+//         [-o report] [-b baseline] [-T tolerancia%]
+#include "common.h"
+#include <fcntl.h>
+#include <sys/resource.h>
+
+#define LG_PARAMS "loadgen_params.txt"
+
+static int base_port = 47000;
+static int num_swarms = 20;
+static int assembly = 5;
+static int max_rate = 256000;   // datagramas/s
+static int step_ms = 1000;
+static const char *report_path = "bench_report.txt";
+static const char *baseline_path = NULL;
+static double tolerance = 20.0;
+
+static int *truck_socks;
+static int *drone_socks;
+static int ctl_sock;
+static pid_t center_pid, artillery_pid;
+
+// ---------- util ----------
+static double now_us(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int drone_gid(int swarm, int i){ return swarm * 100 + i + 1; }
+
+static int bind_udp(int port){
+    int s = make_udp_socket();
+    struct sockaddr_in addr; memset(&addr,0,sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr(HOST);
+    addr.sin_port = htons(port);
+    if(bind(s,(struct sockaddr*)&addr,sizeof(addr))<0){
+        fprintf(stderr, "[LOADGEN] bind %d: %s\n", port, strerror(errno));
+        exit(1);
+    }
+    fcntl(s, F_SETFL, O_NONBLOCK);
+    return s;
+}
+
+static int cmp_double(const void *a, const void *b){
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(double *v, int n, double p){
+    if(n == 0) return 0;
+    qsort(v, n, sizeof(double), cmp_double);
+    int idx = (int)(p / 100.0 * (n - 1) + 0.5);
+    return v[idx];
+}
+
+// utime+stime del proceso en ns
+static double proc_cpu_ns(pid_t pid){
+    char path[64], buf[1024];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    FILE *f = fopen(path, "r");
+    if(!f) return 0;
+    size_t n = fread(buf, 1, sizeof(buf)-1, f);
+    fclose(f);
+    buf[n] = 0;
+    char *p = strrchr(buf, ')');
+    if(!p) return 0;
+    unsigned long ut = 0, st = 0;
+    // tras el comm: estado(3) ... utime(14) stime(15)
+    sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &ut, &st);
+    return (double)(ut + st) * 1e9 / sysconf(_SC_CLK_TCK);
+}
+
+static pid_t spawn(const char *bin){
+    pid_t pid = fork();
+    if(pid == 0){
+        int dn = open("/dev/null", O_WRONLY);
+        if(dn >= 0){ dup2(dn, 1); dup2(dn, 2); }
+        execl(bin, bin, LG_PARAMS, (char*)NULL);
+        perror("execl");
+        exit(1);
+    }
+    return pid;
+}
+
+static void write_params(void){
+    FILE *f = fopen(LG_PARAMS, "w");
+    if(!f){ perror(LG_PARAMS); exit(1); }
+    fprintf(f, "# generado por loadgen\n");
+    fprintf(f, "BASE_PORT=%d\nNUM_SWARMS=%d\nNUM_TARGETS=%d\nASSEMBLY_SIZE=%d\n",
+            base_port, num_swarms, num_swarms, assembly);
+    fprintf(f, "SPAWN_TRUCKS=0\nW=0\nARTILLERY_RATE=1\nMAX_WAIT_REASSEMBLY=3600\n");
+    fprintf(f, "LOG_LEVEL=WARN\n");
+    fclose(f);
+}
+
+static void send_ping(int port, int seq){
+    msg_t m; memset(&m,0,sizeof(m));
+    m.type = MSG_PING;
+    snprintf(m.text, sizeof(m.text), "PING %d", seq);
+    send_msg(ctl_sock, port, &m);
+}
+
+// Espera el PONG con número seq en ctl_sock; devuelve el instante de llegada o <0
+static double wait_pong(int seq, double timeout_us){
+    double deadline = now_us() + timeout_us;
+    msg_view_t m; struct sockaddr_in from;
+    while(now_us() < deadline){
+        int r = recv_view(ctl_sock, &m, &from);
+        if(r <= 0){ usleep(20); continue; }
+        int got;
+        if(m.type == MSG_PING && sscanf(m.text, "PING %d", &got) == 1 && got == seq)
+            return now_us();
+    }
+    return -1;
+}
+
+static void drain(int sock){
+    msg_view_t m; struct sockaddr_in from;
+    while(recv_view(sock, &m, &from) > 0) {}
+}
+
+// ---------- fases ----------
+static double *takeoff_lat;
+static int n_takeoff_lat = 0;
+
+static void phase_assembly(void){
+    int center_port = port_for_center(base_port);
+
+    for(int s = 0; s < num_swarms; s++){
+        for(int i = 0; i < assembly; i++){
+            msg_t h; memset(&h,0,sizeof(h));
+            h.type = MSG_HELLO;
+            h.swarm_id = s;
+            h.drone_id = drone_gid(s, i);
+            snprintf(h.text, sizeof(h.text), "DRONE_HELLO %d PID %d", h.drone_id, getpid());
+            send_msg(drone_socks[s*assembly + i], center_port, &h);
+        }
+    }
+    send_ping(center_port, 1);
+    if(wait_pong(1, 2e6) < 0) fprintf(stderr, "[LOADGEN] el centro no confirmó los HELLO\n");
+
+    for(int s = 0; s < num_swarms; s++){
+        msg_t st; memset(&st,0,sizeof(st));
+        st.type = MSG_STATUS;
+        st.swarm_id = s;
+        st.drone_id = drone_gid(s, 0);
+        snprintf(st.text, sizeof(st.text), "IN_ASSEMBLY");
+        double t0 = now_us();
+        send_msg(drone_socks[s*assembly], center_port, &st);
+
+        // el truck simulado reenvía TAKEOFF a sus drones; se mide la llegada a cada uno
+        int relayed = 0, arrived = 0;
+        double deadline = t0 + 1e6;
+        while(arrived < assembly && now_us() < deadline){
+            msg_view_t m; struct sockaddr_in from;
+            if(!relayed && recv_view(truck_socks[s], &m, &from) > 0 && m.type == MSG_COMMAND &&
+               strcmp(m.text, "TAKEOFF") == 0){
+                for(int i = 0; i < assembly; i++){
+                    msg_t cmd; memset(&cmd,0,sizeof(cmd));
+                    cmd.type = MSG_COMMAND;
+                    cmd.swarm_id = s;
+                    cmd.drone_id = drone_gid(s, i);
+                    snprintf(cmd.text, sizeof(cmd.text), "TAKEOFF");
+                    send_msg(truck_socks[s], port_for_drone(base_port, cmd.drone_id), &cmd);
+                }
+                relayed = 1;
+            }
+            for(int i = 0; relayed && i < assembly; i++){
+                if(recv_view(drone_socks[s*assembly + i], &m, &from) > 0 && strcmp(m.text, "TAKEOFF") == 0){
+                    takeoff_lat[n_takeoff_lat++] = now_us() - t0;
+                    arrived++;
+                }
+            }
+        }
+        if(arrived < assembly)
+            fprintf(stderr, "[LOADGEN] swarm %d: TAKEOFF llegó a %d/%d drones\n", s, arrived, assembly);
+        drain(truck_socks[s]);
+    }
+}
+
+typedef struct {
+    int rate;
+    int sent;
+    double loss_pct;
+    double center_cpu_ns_msg;
+    double artillery_cpu_ns_msg;
+} step_result_t;
+
+static step_result_t run_step(int rate, int *ping_seq){
+    step_result_t res; memset(&res,0,sizeof(res));
+    res.rate = rate;
+    int center_port = port_for_center(base_port);
+    int artillery_port = port_for_artillery(base_port);
+    int ndrones = num_swarms * assembly;
+
+    double c0 = proc_cpu_ns(center_pid), a0 = proc_cpu_ns(artillery_pid);
+    double start = now_us();
+    double dur = step_ms * 1000.0;
+    int pings = 0, pongs = 0;
+
+    msg_t m; memset(&m,0,sizeof(m));
+    m.type = MSG_STATUS;
+    while(1){
+        double el = now_us() - start;
+        if(el >= dur) break;
+        int due = (int)(el / 1e6 * rate);
+        while(res.sent < due){
+            int d = res.sent / 2 % ndrones;
+            m.swarm_id = d / assembly;
+            m.drone_id = drone_gid(m.swarm_id, d % assembly);
+            snprintf(m.text, sizeof(m.text), "POS %.1f %.1f", 10.0 + (res.sent % 400) * 0.1, 1.0);
+            send_msg(ctl_sock, (res.sent & 1) ? artillery_port : center_port, &m);
+            res.sent++;
+            if(res.sent % 200 == 0){
+                send_ping(center_port, (*ping_seq)++);
+                send_ping(artillery_port, (*ping_seq)++);
+                pings += 2;
+            }
+        }
+        msg_view_t r; struct sockaddr_in from;
+        while(recv_view(ctl_sock, &r, &from) > 0) if(r.type == MSG_PING) pongs++;
+    }
+    // margen para que se vacíen las colas
+    double tail = now_us() + 300000;
+    while(now_us() < tail){
+        msg_view_t r; struct sockaddr_in from;
+        if(recv_view(ctl_sock, &r, &from) > 0){ if(r.type == MSG_PING) pongs++; }
+        else usleep(100);
+    }
+    double c1 = proc_cpu_ns(center_pid), a1 = proc_cpu_ns(artillery_pid);
+    res.loss_pct = pings ? 100.0 * (pings - pongs) / pings : 0;
+    int per_proc = res.sent / 2 + pings / 2;
+    if(per_proc > 0){
+        res.center_cpu_ns_msg = (c1 - c0) / per_proc;
+        res.artillery_cpu_ns_msg = (a1 - a0) / per_proc;
+    }
+    for(int i = 0; i < num_swarms; i++) drain(truck_socks[i]);
+    return res;
+}
+
+static double *removal_lat;
+static int n_removal_lat = 0;
+
+static void phase_removal(int *ping_seq){
+    int center_port = port_for_center(base_port);
+    for(int s = 0; s < num_swarms; s++){
+        for(int i = 0; i < assembly; i++){
+            msg_t st; memset(&st,0,sizeof(st));
+            st.type = MSG_STATUS;
+            st.swarm_id = s;
+            st.drone_id = drone_gid(s, i);
+            snprintf(st.text, sizeof(st.text), "SHOT_DOWN_BY_ARTILLERY");
+            double t0 = now_us();
+            send_msg(ctl_sock, center_port, &st);
+            int seq = (*ping_seq)++;
+            send_ping(center_port, seq);
+            double t1 = wait_pong(seq, 5e5);
+            if(t1 > 0) removal_lat[n_removal_lat++] = t1 - t0;
+        }
+        drain(truck_socks[s]);
+    }
+}
+
+// ---------- reporte ----------
+typedef struct { const char *key; double val; int higher_is_better; } metric_t;
+
+static int compare_baseline(metric_t *ms, int n){
+    FILE *f = fopen(baseline_path, "r");
+    if(!f){ perror(baseline_path); return 0; }
+    int regressions = 0;
+    char line[200];
+    printf("\n=== COMPARACIÓN CON %s (tolerancia %.0f%%) ===\n", baseline_path, tolerance);
+    while(fgets(line, sizeof(line), f)){
+        if(line[0] == '#') continue;
+        char key[80]; double base;
+        if(sscanf(line, "%79[^=]=%lf", key, &base) != 2) continue;
+        for(int i = 0; i < n; i++){
+            if(strcmp(ms[i].key, key) != 0 || base == 0) continue;
+            double delta = 100.0 * (ms[i].val - base) / base;
+            int worse = ms[i].higher_is_better ? (delta < -tolerance) : (delta > tolerance);
+            printf("%-34s %12.1f -> %12.1f (%+6.1f%%)%s\n", key, base, ms[i].val, delta,
+                   worse ? "  << REGRESIÓN" : "");
+            regressions += worse;
+        }
+    }
+    fclose(f);
+    return regressions;
+}
+
+int main(int argc, char **argv){
+    int opt;
+    while((opt = getopt(argc, argv, "s:a:r:d:p:o:b:T:")) != -1){
+        switch(opt){
+        case 's': num_swarms = atoi(optarg); break;
+        case 'a': assembly = atoi(optarg); break;
+        case 'r': max_rate = atoi(optarg); break;
+        case 'd': step_ms = atoi(optarg); break;
+        case 'p': base_port = atoi(optarg); break;
+        case 'o': report_path = optarg; break;
+        case 'b': baseline_path = optarg; break;
+        case 'T': tolerance = atof(optarg); break;
+        default:
+            fprintf(stderr, "Uso: loadgen [-s swarms] [-a assembly] [-r max_rate] [-d step_ms] "
+                            "[-p base_port] [-o report] [-b baseline] [-T tolerancia%%]\n");
+            return 1;
+        }
+    }
+    int ndrones = num_swarms * assembly;
+
+    struct rlimit rl;
+    if(getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < (rlim_t)ndrones + num_swarms + 64){
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    truck_socks = calloc(num_swarms, sizeof(int));
+    drone_socks = calloc(ndrones, sizeof(int));
+    takeoff_lat = calloc(ndrones, sizeof(double));
+    removal_lat = calloc(ndrones, sizeof(double));
+    for(int s = 0; s < num_swarms; s++){
+        truck_socks[s] = bind_udp(port_for_truck(base_port, s));
+        for(int i = 0; i < assembly; i++)
+            drone_socks[s*assembly + i] = bind_udp(port_for_drone(base_port, drone_gid(s, i)));
+    }
+    ctl_sock = make_udp_socket();
+    fcntl(ctl_sock, F_SETFL, O_NONBLOCK);
+
+    write_params();
+    printf("[LOADGEN] %d swarms x %d drones (%d drones), base_port=%d\n",
+           num_swarms, assembly, ndrones, base_port);
+    artillery_pid = spawn("./artillery");
+    usleep(300000);
+    center_pid = spawn("./control_center");
+
+    int seq = 100;
+    double up = -1;
+    for(int tries = 0; tries < 50 && up < 0; tries++){
+        send_ping(port_for_center(base_port), seq);
+        up = wait_pong(seq++, 100000);
+    }
+    if(up < 0){ fprintf(stderr, "[LOADGEN] control_center no responde\n"); kill(center_pid, SIGKILL); kill(artillery_pid, SIGKILL); return 1; }
+
+    printf("[LOADGEN] fase 1: ensamblaje -> TAKEOFF\n");
+    phase_assembly();
+
+    printf("[LOADGEN] fase 2: rampa de throughput\n");
+    step_result_t best; memset(&best,0,sizeof(best));
+    for(int rate = 2000; rate <= max_rate; rate *= 2){
+        step_result_t r = run_step(rate, &seq);
+        printf("[LOADGEN]   %7d dgram/s: pérdida %.2f%%, CPU center %.0f ns/msg, artillery %.0f ns/msg\n",
+               rate, r.loss_pct, r.center_cpu_ns_msg, r.artillery_cpu_ns_msg);
+        if(r.loss_pct > 1.0) break;
+        best = r;
+    }
+
+    printf("[LOADGEN] fase 3: SHOT_DOWN -> remoción\n");
+    phase_removal(&seq);
+
+    double to50 = percentile(takeoff_lat, n_takeoff_lat, 50), to99 = percentile(takeoff_lat, n_takeoff_lat, 99);
+    double rm50 = percentile(removal_lat, n_removal_lat, 50), rm99 = percentile(removal_lat, n_removal_lat, 99);
+    metric_t ms[] = {
+        { "takeoff_latency_us_p50",      to50, 0 },
+        { "takeoff_latency_us_p99",      to99, 0 },
+        { "removal_latency_us_p50",      rm50, 0 },
+        { "removal_latency_us_p99",      rm99, 0 },
+        { "throughput_ceiling_dgram_s",  best.rate, 1 },
+        { "center_cpu_ns_per_msg",       best.center_cpu_ns_msg, 0 },
+        { "artillery_cpu_ns_per_msg",    best.artillery_cpu_ns_msg, 0 },
+    };
+    int nm = sizeof(ms)/sizeof(ms[0]);
+
+    FILE *f = fopen(report_path, "w");
+    if(f){
+        fprintf(f, "# loadgen report: swarms=%d assembly=%d drones=%d\n", num_swarms, assembly, ndrones);
+        fprintf(f, "# muestras: takeoff=%d removal=%d\n", n_takeoff_lat, n_removal_lat);
+        for(int i = 0; i < nm; i++) fprintf(f, "%s=%.1f\n", ms[i].key, ms[i].val);
+        fclose(f);
+    }
+    printf("\n=== REPORTE (%s) ===\n", report_path);
+    for(int i = 0; i < nm; i++) printf("%-34s %12.1f\n", ms[i].key, ms[i].val);
+
+    int regressions = baseline_path ? compare_baseline(ms, nm) : 0;
+
+    // al quedar sin drones el centro termina solo y manda TERMINATE a artillería
+    for(int i = 0; i < 30; i++){
+        if(waitpid(center_pid, NULL, WNOHANG) == center_pid) { center_pid = 0; break; }
+        usleep(100000);
+    }
+    if(center_pid) kill(center_pid, SIGKILL);
+    kill(artillery_pid, SIGTERM);
+    waitpid(artillery_pid, NULL, 0);
+    unlink(LG_PARAMS);
+
+    return regressions ? 2 : 0;
+}
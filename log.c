@@ -0,0 +1,201 @@
+// log.c
+#include "common.h"
+#include "log.h"
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <strings.h>
+
+#define LOG_MAX_THREADS 64
+#define LOG_RING_SLOTS  256     // potencia de 2
+#define LOG_LINE_MAX    232
+#define LOG_FLUSH_US    20000   // 20ms entre vaciados si no hay actividad
+
+typedef struct {
+    struct timespec ts;
+    unsigned char lvl;
+    unsigned short len;
+    char text[LOG_LINE_MAX];
+} log_entry_t;
+
+// Buffer SPSC: el hilo dueño avanza head, el flusher avanza tail
+typedef struct {
+    _Atomic unsigned int head;
+    _Atomic unsigned int tail;
+    log_entry_t slots[LOG_RING_SLOTS];
+} log_ring_t;
+
+volatile int log_min_level = LOG_LVL_INFO;
+
+static log_ring_t *rings[LOG_MAX_THREADS];
+static _Atomic int num_rings = 0;
+static __thread log_ring_t *my_ring = NULL;
+static __thread int my_ring_failed = 0;
+
+static _Atomic unsigned long dropped = 0;
+static _Atomic int running = 0;
+static pthread_t flusher;
+static char component[16] = "LOG";
+static log_format_t format = LOG_FMT_TEXT;
+static FILE *out = NULL;
+
+static const char *level_names[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+static log_ring_t *ring_for_thread(void){
+    if(my_ring || my_ring_failed) return my_ring;
+    int idx = atomic_fetch_add(&num_rings, 1);
+    if(idx >= LOG_MAX_THREADS){
+        atomic_fetch_sub(&num_rings, 1);
+        my_ring_failed = 1;
+        return NULL;
+    }
+    log_ring_t *r = calloc(1, sizeof(*r));
+    if(!r){ my_ring_failed = 1; return NULL; }
+    // publicar el puntero antes de que el flusher lo pueda ver
+    __atomic_store_n(&rings[idx], r, __ATOMIC_RELEASE);
+    my_ring = r;
+    return r;
+}
+
+void log_write(log_level_t lvl, const char *fmt, ...){
+    if(lvl < LOG_LVL_DEBUG || lvl >= LOG_LVL_OFF) return;
+    log_ring_t *r = ring_for_thread();
+    if(!r){ atomic_fetch_add(&dropped, 1); return; }
+
+    unsigned int head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if(head - tail >= LOG_RING_SLOTS){
+        atomic_fetch_add(&dropped, 1);
+        return;
+    }
+
+    log_entry_t *e = &r->slots[head & (LOG_RING_SLOTS-1)];
+    clock_gettime(CLOCK_REALTIME, &e->ts);
+    e->lvl = (unsigned char)lvl;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(e->text, sizeof(e->text), fmt, ap);
+    va_end(ap);
+    if(n < 0) n = 0;
+    if(n >= (int)sizeof(e->text)) n = sizeof(e->text) - 1;
+    e->len = (unsigned short)n;
+
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+}
+
+unsigned long log_dropped(void){
+    return atomic_load(&dropped);
+}
+
+static void write_json_string(FILE *f, const char *s, int len){
+    fputc('"', f);
+    for(int i = 0; i < len; i++){
+        unsigned char c = (unsigned char)s[i];
+        if(c == '"' || c == '\\') { fputc('\\', f); fputc(c, f); }
+        else if(c == '\n') fputs("\\n", f);
+        else if(c < 0x20) fprintf(f, "\\u%04x", c);
+        else fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+static void emit(const log_entry_t *e){
+    if(format == LOG_FMT_JSON){
+        fprintf(out, "{\"ts\":%ld.%06ld,\"lvl\":\"%s\",\"src\":\"%s\",\"msg\":",
+                (long)e->ts.tv_sec, e->ts.tv_nsec / 1000, level_names[e->lvl], component);
+        write_json_string(out, e->text, e->len);
+        fputs("}\n", out);
+    } else {
+        fprintf(out, "[%s] ", component);
+        fwrite(e->text, 1, e->len, out);
+        fputc('\n', out);
+    }
+}
+
+static int ts_before(const struct timespec *a, const struct timespec *b){
+    if(a->tv_sec != b->tv_sec) return a->tv_sec < b->tv_sec;
+    return a->tv_nsec < b->tv_nsec;
+}
+
+// Mezcla los buffers por timestamp para que la salida conserve el orden global
+static int drain_all(void){
+    int total = 0;
+    int n = atomic_load(&num_rings);
+    if(n > LOG_MAX_THREADS) n = LOG_MAX_THREADS;
+    while(1){
+        log_ring_t *best = NULL;
+        log_entry_t *best_e = NULL;
+        for(int i = 0; i < n; i++){
+            log_ring_t *r = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+            if(!r) continue;
+            unsigned int tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+            unsigned int head = atomic_load_explicit(&r->head, memory_order_acquire);
+            if(tail == head) continue;
+            log_entry_t *e = &r->slots[tail & (LOG_RING_SLOTS-1)];
+            if(!best_e || ts_before(&e->ts, &best_e->ts)){ best = r; best_e = e; }
+        }
+        if(!best) break;
+        emit(best_e);
+        atomic_store_explicit(&best->tail,
+                              atomic_load_explicit(&best->tail, memory_order_relaxed) + 1,
+                              memory_order_release);
+        total++;
+    }
+    if(total) fflush(out);
+    return total;
+}
+
+static void *flusher_thread(void *arg){
+    (void)arg;
+    while(atomic_load(&running)){
+        if(drain_all() == 0) usleep(LOG_FLUSH_US);
+    }
+    drain_all();
+    return NULL;
+}
+
+static log_level_t parse_level(const char *s){
+    if(strcasecmp(s, "DEBUG") == 0) return LOG_LVL_DEBUG;
+    if(strcasecmp(s, "INFO") == 0)  return LOG_LVL_INFO;
+    if(strcasecmp(s, "WARN") == 0)  return LOG_LVL_WARN;
+    if(strcasecmp(s, "ERROR") == 0) return LOG_LVL_ERROR;
+    if(strcasecmp(s, "OFF") == 0)   return LOG_LVL_OFF;
+    return LOG_LVL_INFO;
+}
+
+void log_init(const char *comp, const char *params_path){
+    snprintf(component, sizeof(component), "%s", comp);
+    out = stdout;
+
+    char log_file[200] = "";
+    FILE *f = params_path ? fopen(params_path, "r") : NULL;
+    if(f){
+        char line[200];
+        while(fgets(line, sizeof(line), f)){
+            if(line[0] == '#') continue;
+            char key[80], val[160];
+            if(sscanf(line, "%79[^=]=%159s", key, val) != 2) continue;
+            if(strcmp(key, "LOG_LEVEL") == 0) log_min_level = parse_level(val);
+            else if(strcmp(key, "LOG_FORMAT") == 0)
+                format = (strcasecmp(val, "JSON") == 0) ? LOG_FMT_JSON : LOG_FMT_TEXT;
+            else if(strcmp(key, "LOG_FILE") == 0) snprintf(log_file, sizeof(log_file), "%s", val);
+        }
+        fclose(f);
+    }
+    if(log_file[0]){
+        FILE *lf = fopen(log_file, "a");
+        if(lf) out = lf;
+        else perror("open LOG_FILE");
+    }
+
+    atomic_store(&running, 1);
+    sim_thread_create(&flusher, flusher_thread, NULL);
+    atexit(log_shutdown);
+}
+
+void log_shutdown(void){
+    if(!atomic_exchange(&running, 0)) return;
+    pthread_join(flusher, NULL);
+    unsigned long d = log_dropped();
+    if(d) fprintf(out, "[%s] log: %lu líneas descartadas por buffer lleno\n", component, d);
+    fflush(out);
+}
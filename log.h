@@ -0,0 +1,37 @@
+// log.h - logging asíncrono para center y artillería
+#ifndef LOG_H
+#define LOG_H
+
+// Cada hilo escribe en su propio buffer circular (sin locks); un hilo de
+// fondo los vacía a stdout/archivo. Si un buffer se llena la línea se
+// descarta y se cuenta, nunca se bloquea al productor.
+
+typedef enum {
+    LOG_LVL_DEBUG,
+    LOG_LVL_INFO,
+    LOG_LVL_WARN,
+    LOG_LVL_ERROR,
+    LOG_LVL_OFF,
+} log_level_t;
+
+typedef enum {
+    LOG_FMT_TEXT,   // "[COMP] mensaje" (igual que los printf anteriores)
+    LOG_FMT_JSON,   // una línea JSON por evento
+} log_format_t;
+
+// Lee LOG_LEVEL, LOG_FORMAT y LOG_FILE de params.txt y arranca el flusher
+void log_init(const char *component, const char *params_path);
+void log_shutdown(void);
+
+extern volatile int log_min_level;
+
+void log_write(log_level_t lvl, const char *fmt, ...) __attribute__((format(printf,2,3)));
+unsigned long log_dropped(void);
+
+#define LOG_AT(lvl, ...) do { if((lvl) >= log_min_level) log_write((lvl), __VA_ARGS__); } while(0)
+#define LOGD(...) LOG_AT(LOG_LVL_DEBUG, __VA_ARGS__)
+#define LOGI(...) LOG_AT(LOG_LVL_INFO,  __VA_ARGS__)
+#define LOGW(...) LOG_AT(LOG_LVL_WARN,  __VA_ARGS__)
+#define LOGE(...) LOG_AT(LOG_LVL_ERROR, __VA_ARGS__)
+
+#endif
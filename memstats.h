@@ -0,0 +1,26 @@
+// memstats.h - memoria residente por rol de proceso de la simulación
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+#include <stdio.h>
+
+enum { MEM_CENTER, MEM_TRUCK, MEM_DRONE, MEM_ARTILLERY, MEM_NROLES };
+
+typedef struct {
+    int procs;
+    int threads;
+    long rss_kb, anon_kb, file_kb, shmem_kb;
+} memstats_role_t;
+
+typedef struct {
+    memstats_role_t role[MEM_NROLES];
+} memstats_t;
+
+// Recorre /proc y suma los procesos de la sesión actual cuyo nombre es
+// control_center, truck, drone o artillery. Devuelve 0 o -1 si /proc no está.
+int  memstats_collect(memstats_t *ms);
+
+// Tabla por rol y costo por drone simulado (drones vivos)
+void memstats_print(FILE *out, const memstats_t *ms);
+
+#endif
@@ -0,0 +1,195 @@
+// reload.c - instantáneas de parámetros recargables y vigilancia de params.txt con inotify
+#include "reload.h"
+#include "common.h"
+#include "log.h"
+#include <stddef.h>
+#include <poll.h>
+#include <libgen.h>
+#include <sys/inotify.h>
+
+// Mismos valores por defecto que los binarios (los bench, sin params.txt, leen estos)
+static live_params_t live_defaults = { 30, 5, 5, 2, 5, 5.0, 0.0, 0 };
+static const live_params_t *live_cur = &live_defaults;
+static pthread_mutex_t live_writer = PTHREAD_MUTEX_INITIALIZER;
+
+const live_params_t *live_params(void){
+    return __atomic_load_n(&live_cur, __ATOMIC_ACQUIRE);
+}
+
+live_params_t *live_params_begin(void){
+    pthread_mutex_lock(&live_writer);
+    live_params_t *p = malloc(sizeof(*p));
+    if(!p){ perror("malloc live_params"); exit(1); }
+    *p = *live_cur;
+    return p;
+}
+
+const live_params_t *live_params_commit(live_params_t *next){
+    const live_params_t *old = live_cur;
+    next->generation = old->generation + 1;
+    __atomic_store_n(&live_cur, next, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&live_writer);
+    return old;
+}
+
+// Claves recargables: el orden define los bits de LIVE_DRONE_KEYS/LIVE_ALL_KEYS
+typedef struct {
+    const char *key;
+    size_t off;
+    int is_int;
+    double lo, hi;      // rango aceptado
+} live_field_t;
+
+static const live_field_t live_fields[] = {
+    { "Q",                   offsetof(live_params_t, Q),                   1, 0,    100 },
+    { "Z",                   offsetof(live_params_t, Z),                   1, 1,    1e6 },
+    { "VX",                  offsetof(live_params_t, VX),                  0, 0.01, 1e6 },
+    { "VY",                  offsetof(live_params_t, VY),                  0, 0,    1e6 },
+    { "W",                   offsetof(live_params_t, W),                   1, 0,    100 },
+    { "ARTILLERY_RATE",      offsetof(live_params_t, ARTILLERY_RATE),      1, 1,    3600 },
+    { "MAX_WAIT_REASSEMBLY", offsetof(live_params_t, MAX_WAIT_REASSEMBLY), 1, 0,    1e6 },
+};
+#define LIVE_NFIELDS ((int)(sizeof(live_fields) / sizeof(live_fields[0])))
+
+static double field_get(const live_params_t *p, const live_field_t *f){
+    const char *base = (const char *)p + f->off;
+    return f->is_int ? *(const int *)base : *(const double *)base;
+}
+
+static void field_set(live_params_t *p, const live_field_t *f, double v){
+    char *base = (char *)p + f->off;
+    if(f->is_int) *(int *)base = (int)v;
+    else *(double *)base = v;
+}
+
+int live_params_diff(const live_params_t *a, const live_params_t *b, int mask, char *buf, size_t len){
+    int n = 0;
+    size_t used = 0;
+    if(len) buf[0] = 0;
+    for(int i = 0; i < LIVE_NFIELDS; i++){
+        const live_field_t *f = &live_fields[i];
+        double vb = field_get(b, f);
+        if(!(mask & (1 << i)) || field_get(a, f) == vb) continue;
+        if(used < len)
+            used += snprintf(buf + used, len - used, f->is_int ? "%s%s=%.0f" : "%s%s=%g",
+                             n ? " " : "", f->key, vb);
+        n++;
+    }
+    return n;
+}
+
+// Claves recargables presentes en path, sobre *out; las fuera de rango se ignoran
+static int live_params_read(const char *path, live_params_t *out){
+    FILE *f = fopen(path, "r");
+    if(!f) return -1;
+    char line[200];
+    while(fgets(line, sizeof(line), f)){
+        if(line[0] == '#') continue;
+        char key[80]; double v;
+        if(sscanf(line, "%79[^=]=%lf", key, &v) != 2) continue;
+        for(int i = 0; i < LIVE_NFIELDS; i++){
+            const live_field_t *fl = &live_fields[i];
+            if(strcmp(key, fl->key) != 0) continue;
+            if(v < fl->lo || v > fl->hi)
+                LOGW("%s: %s=%g fuera de rango [%g, %g], se ignora", path, key, v, fl->lo, fl->hi);
+            else field_set(out, fl, v);
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+// ---------- vigilancia ----------
+static char watch_path[256], watch_base[128];
+static live_params_t watch_file;   // valores del archivo en la última lectura (solo el hilo vigilante)
+static void (*watch_cb)(const live_params_t *, const live_params_t *);
+static int watch_fd = -1;
+
+static void reload_file(void){
+    live_params_t file = live_defaults;
+    if(live_params_read(watch_path, &file) < 0){
+        LOGW("No se pudo releer %s: %s", watch_path, strerror(errno));
+        return;
+    }
+    char changed[256];
+    if(live_params_diff(&watch_file, &file, LIVE_ALL_KEYS, changed, sizeof(changed)) == 0) return;
+
+    live_params_t *next = live_params_begin();
+    for(int i = 0; i < LIVE_NFIELDS; i++){
+        const live_field_t *f = &live_fields[i];
+        if(field_get(&watch_file, f) != field_get(&file, f)) field_set(next, f, field_get(&file, f));
+    }
+    const live_params_t *old = live_params_commit(next);
+    watch_file = file;
+    LOGI("%s recargado: %s", watch_path, changed);
+    if(watch_cb) watch_cb(old, next);
+}
+
+static int event_matches(const char *buf, ssize_t n){
+    int hit = 0;
+    for(const char *p = buf; p < buf + n; ){
+        const struct inotify_event *ev = (const struct inotify_event *)p;
+        if(ev->len && strcmp(ev->name, watch_base) == 0) hit = 1;
+        p += sizeof(*ev) + ev->len;
+    }
+    return hit;
+}
+
+static void *watch_thread(void *arg){
+    (void)arg;
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for(;;){
+        ssize_t n = read(watch_fd, buf, sizeof(buf));
+        if(n <= 0){
+            if(n < 0 && errno == EINTR) continue;
+            LOGW("Vigilancia de %s terminada: %s", watch_path, strerror(errno));
+            return NULL;
+        }
+        if(!event_matches(buf, n)) continue;
+        // asentamiento: agrupa los eventos de una misma escritura (o de un editor que
+        // escribe un temporal y lo renombra) en una sola recarga
+        struct pollfd p = { watch_fd, POLLIN, 0 };
+        while(poll(&p, 1, 100) > 0 && read(watch_fd, buf, sizeof(buf)) > 0)
+            ;
+        reload_file();
+    }
+    return NULL;
+}
+
+void live_params_load(const char *path){
+    snprintf(watch_path, sizeof(watch_path), "%s", path);
+    watch_file = live_defaults;
+    live_params_read(path, &watch_file);
+    live_params_t *p = live_params_begin();
+    *p = watch_file;
+    live_params_commit(p);
+}
+
+int params_watch(const char *path,
+                 void (*on_reload)(const live_params_t *old, const live_params_t *now)){
+    watch_cb = on_reload;
+
+    char v[16];
+    if(params_get_string(path, "PARAMS_RELOAD", v, sizeof(v)) && atoi(v) == 0) return 0;
+
+    // se vigila el directorio: los editores suelen reemplazar el archivo con rename
+    char dir[256], base[256];
+    snprintf(dir, sizeof(dir), "%s", path);
+    snprintf(base, sizeof(base), "%s", path);
+    snprintf(watch_base, sizeof(watch_base), "%s", basename(base));
+    watch_fd = inotify_init1(IN_CLOEXEC);
+    if(watch_fd < 0 || inotify_add_watch(watch_fd, dirname(dir), IN_CLOSE_WRITE | IN_MOVED_TO) < 0){
+        LOGW("No se puede vigilar %s (sin recarga en caliente): %s", path, strerror(errno));
+        if(watch_fd >= 0) close(watch_fd);
+        watch_fd = -1;
+        return 0;
+    }
+    pthread_t t;
+    if(sim_thread_create(&t, watch_thread, NULL) != 0){
+        close(watch_fd);
+        watch_fd = -1;
+        return 0;
+    }
+    pthread_detach(t);
+    return 1;
+}
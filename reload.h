@@ -0,0 +1,41 @@
+// reload.h - parámetros recargables en caliente (center y artillería)
+#ifndef RELOAD_H
+#define RELOAD_H
+
+#include <stddef.h>
+
+// Los parámetros que se pueden cambiar con la misión en curso viven en una instantánea
+// inmutable. Los lectores la obtienen con live_params() (una carga atómica, sin locks) y
+// los escritores copian, modifican y publican la copia con un intercambio de puntero:
+//     live_params_t *p = live_params_begin();
+//     p->W = 40;
+//     const live_params_t *old = live_params_commit(p);
+// Las instantáneas viejas no se liberan: un lector pudo quedarse con el puntero y las
+// recargas son pocas (unas decenas de bytes cada una).
+
+typedef struct {
+    int W, Q, Z, ARTILLERY_RATE, MAX_WAIT_REASSEMBLY;
+    double VX, VY;          // VY <= 0: igual a VX
+    unsigned generation;    // se incrementa en cada publicación
+} live_params_t;
+
+const live_params_t *live_params(void);
+live_params_t *live_params_begin(void);                         // toma el lock de escritores
+const live_params_t *live_params_commit(live_params_t *next);   // publica, suelta el lock; devuelve la anterior
+
+// "Q=7 VX=6.0" con los campos de mask que difieren entre a y b; devuelve cuántos
+#define LIVE_DRONE_KEYS 0x0f   // Q, Z, VX, VY: los que usan los drones
+#define LIVE_ALL_KEYS   0x7f
+int live_params_diff(const live_params_t *a, const live_params_t *b, int mask, char *buf, size_t len);
+
+// Publica la instantánea inicial con las claves de path (sobre los valores por defecto)
+void live_params_load(const char *path);
+
+// Si PARAMS_RELOAD no es 0, vigila path (ya cargado con live_params_load) con inotify.
+// Ante cada cambio republica solo las claves cuyo valor cambió en el archivo (un ajuste
+// del operador sobre otra clave se conserva) y llama on_reload desde el hilo vigilante.
+// Devuelve 1 si quedó vigilando.
+int params_watch(const char *path,
+                 void (*on_reload)(const live_params_t *old, const live_params_t *now));
+
+#endif
@@ -0,0 +1,341 @@
+// targets.c - catálogo de blancos con índice de grilla
+#include "targets.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define TARGETS_GRID_MAX 2048   // celdas por lado
+
+void targets_init(target_set_t *ts){
+    memset(ts, 0, sizeof(*ts));
+}
+
+void targets_free(target_set_t *ts){
+    free(ts->items);
+    free(ts->cell_start);
+    free(ts->cell_items);
+    targets_init(ts);
+}
+
+int targets_add(target_set_t *ts, double x, double y, int priority, int required){
+    if(ts->count == ts->cap){
+        int cap = ts->cap ? ts->cap * 2 : 64;
+        target_t *p = realloc(ts->items, cap * sizeof(target_t));
+        if(!p) return -1;
+        ts->items = p;
+        ts->cap = cap;
+    }
+    target_t *t = &ts->items[ts->count];
+    t->x = x;
+    t->y = y;
+    t->priority = priority;
+    t->required = required;
+    t->destroyed = 0;
+    t->first_swarm = -1;
+    t->n_swarms = 0;
+    if(priority > ts->max_priority) ts->max_priority = priority;
+    return ts->count++;
+}
+
+static int load_binary(target_set_t *ts, const char *data, size_t len, int default_required){
+    const targets_file_hdr_t *h = (const targets_file_hdr_t *)data;
+    if(len < sizeof(*h) || len < sizeof(*h) + (size_t)h->count * sizeof(targets_file_rec_t)){
+        fprintf(stderr, "targets: archivo binario truncado\n");
+        return -1;
+    }
+    const targets_file_rec_t *r = (const targets_file_rec_t *)(data + sizeof(*h));
+    for(uint32_t i = 0; i < h->count; i++){
+        if(targets_add(ts, r[i].x, r[i].y, r[i].priority,
+                       r[i].required > 0 ? r[i].required : default_required) < 0) return -1;
+    }
+    return (int)h->count;
+}
+
+static int load_csv(target_set_t *ts, const char *data, size_t len, int default_required){
+    int n = 0, lineno = 0;
+    size_t pos = 0;
+    while(pos < len){
+        size_t end = pos;
+        while(end < len && data[end] != '\n') end++;
+        char line[256];
+        size_t l = end - pos;
+        if(l >= sizeof(line)) l = sizeof(line) - 1;
+        memcpy(line, data + pos, l);
+        line[l] = 0;
+        pos = end + 1;
+        lineno++;
+
+        char *p = line;
+        while(*p == ' ' || *p == '\t') p++;
+        if(*p == '#' || *p == 0 || *p == '\r') continue;
+
+        double x, y;
+        int prio = 1, req = 0;
+        int f = sscanf(p, "%lf , %lf , %d , %d", &x, &y, &prio, &req);
+        if(f < 2){
+            // cabecera "x,y,..." u otra línea no numérica
+            if(n == 0) continue;
+            fprintf(stderr, "targets: línea %d inválida\n", lineno);
+            continue;
+        }
+        if(targets_add(ts, x, y, prio, req > 0 ? req : default_required) < 0) return -1;
+        n++;
+    }
+    return n;
+}
+
+int targets_load(target_set_t *ts, const char *path, int default_required){
+    int fd = open(path, O_RDONLY);
+    if(fd < 0){ perror("open targets"); return -1; }
+    struct stat st;
+    if(fstat(fd, &st) < 0 || st.st_size == 0){ close(fd); return 0; }
+    char *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED){ perror("mmap targets"); return -1; }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    int n;
+    if((size_t)st.st_size >= sizeof(targets_file_hdr_t) &&
+       memcmp(data, TARGETS_MAGIC, sizeof(TARGETS_MAGIC)) == 0)
+        n = load_binary(ts, data, st.st_size, default_required);
+    else
+        n = load_csv(ts, data, st.st_size, default_required);
+    munmap(data, st.st_size);
+    if(n >= 0) targets_build_index(ts);
+    return n;
+}
+
+int targets_save_binary(const target_set_t *ts, const char *path){
+    FILE *f = fopen(path, "wb");
+    if(!f){ perror("fopen targets"); return -1; }
+    targets_file_hdr_t h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, TARGETS_MAGIC, sizeof(TARGETS_MAGIC));
+    h.count = ts->count;
+    fwrite(&h, sizeof(h), 1, f);
+    for(int i = 0; i < ts->count; i++){
+        targets_file_rec_t r = { ts->items[i].x, ts->items[i].y,
+                                 ts->items[i].priority, ts->items[i].required };
+        fwrite(&r, sizeof(r), 1, f);
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static inline int cell_of(const target_set_t *ts, double v, double min, int n){
+    int c = (int)((v - min) / ts->cell);
+    return c < 0 ? 0 : (c >= n ? n - 1 : c);
+}
+
+void targets_build_index(target_set_t *ts){
+    free(ts->cell_start);
+    free(ts->cell_items);
+    ts->cell_start = ts->cell_items = NULL;
+    ts->gw = ts->gh = 0;
+    if(ts->count == 0) return;
+
+    double minx = ts->items[0].x, maxx = minx, miny = ts->items[0].y, maxy = miny;
+    for(int i = 1; i < ts->count; i++){
+        const target_t *t = &ts->items[i];
+        if(t->x < minx) minx = t->x;
+        if(t->x > maxx) maxx = t->x;
+        if(t->y < miny) miny = t->y;
+        if(t->y > maxy) maxy = t->y;
+    }
+    // ~1 blanco por celda en promedio
+    double w = maxx - minx, h = maxy - miny;
+    double side = (w > h ? w : h);
+    double cell = sqrt((w > 0 ? w : 1.0) * (h > 0 ? h : 1.0) / ts->count);
+    if(cell < side / TARGETS_GRID_MAX) cell = side / TARGETS_GRID_MAX;
+    if(cell <= 0) cell = 1.0;
+    ts->minx = minx;
+    ts->miny = miny;
+    ts->cell = cell;
+    ts->gw = (int)(w / cell) + 1;
+    ts->gh = (int)(h / cell) + 1;
+
+    int ncell = ts->gw * ts->gh;
+    ts->cell_start = calloc(ncell + 1, sizeof(int));
+    ts->cell_items = malloc(ts->count * sizeof(int));
+    if(!ts->cell_start || !ts->cell_items){
+        free(ts->cell_start); free(ts->cell_items);
+        ts->cell_start = ts->cell_items = NULL;
+        ts->gw = ts->gh = 0;
+        return;
+    }
+    for(int i = 0; i < ts->count; i++){
+        int c = cell_of(ts, ts->items[i].y, miny, ts->gh) * ts->gw + cell_of(ts, ts->items[i].x, minx, ts->gw);
+        ts->cell_start[c + 1]++;
+    }
+    for(int c = 0; c < ncell; c++) ts->cell_start[c + 1] += ts->cell_start[c];
+    int *fill = malloc(ncell * sizeof(int));
+    memcpy(fill, ts->cell_start, ncell * sizeof(int));
+    for(int i = 0; i < ts->count; i++){
+        int c = cell_of(ts, ts->items[i].y, miny, ts->gh) * ts->gw + cell_of(ts, ts->items[i].x, minx, ts->gw);
+        ts->cell_items[fill[c]++] = i;
+    }
+    free(fill);
+}
+
+static void scan_cell(const target_set_t *ts, int cx, int cy,
+                      double (*cost)(int, void *), void *ctx, int *best, double *best_cost){
+    if(cx < 0 || cy < 0 || cx >= ts->gw || cy >= ts->gh) return;
+    int c = cy * ts->gw + cx;
+    for(int k = ts->cell_start[c]; k < ts->cell_start[c + 1]; k++){
+        int i = ts->cell_items[k];
+        if(ts->items[i].destroyed) continue;
+        double v = cost(i, ctx);
+        if(*best < 0 || v < *best_cost){ *best = i; *best_cost = v; }
+    }
+}
+
+int targets_best(const target_set_t *ts, double x, double y,
+                 double (*cost)(int idx, void *ctx), double dist_scale, double extra_min, void *ctx){
+    int best = -1;
+    double best_cost = 0;
+    if(ts->gw == 0){
+        for(int i = 0; i < ts->count; i++){
+            if(ts->items[i].destroyed) continue;
+            double v = cost(i, ctx);
+            if(best < 0 || v < best_cost){ best = i; best_cost = v; }
+        }
+        return best;
+    }
+
+    // Anillos de celdas alrededor de la celda más cercana al punto: todo blanco del
+    // anillo r está a distancia >= (r-1)*cell de la proyección del punto en la grilla.
+    int cx = cell_of(ts, x, ts->minx, ts->gw), cy = cell_of(ts, y, ts->miny, ts->gh);
+    int rmax = ts->gw > ts->gh ? ts->gw : ts->gh;
+    for(int r = 0; r <= rmax; r++){
+        if(best >= 0 && r > 0 && (r - 1) * ts->cell * dist_scale + extra_min > best_cost) break;
+        if(r == 0){
+            scan_cell(ts, cx, cy, cost, ctx, &best, &best_cost);
+            continue;
+        }
+        for(int d = -r; d <= r; d++){
+            scan_cell(ts, cx + d, cy - r, cost, ctx, &best, &best_cost);
+            scan_cell(ts, cx + d, cy + r, cost, ctx, &best, &best_cost);
+        }
+        for(int d = -r + 1; d <= r - 1; d++){
+            scan_cell(ts, cx - r, cy + d, cost, ctx, &best, &best_cost);
+            scan_cell(ts, cx + r, cy + d, cost, ctx, &best, &best_cost);
+        }
+    }
+    return best;
+}
+
+// Montículo de máximos de los k mejores vistos hasta ahora (la raíz es el peor)
+typedef struct {
+    int *idx;
+    double *cost;
+    int n, k;
+} nearest_heap_t;
+
+static void heap_offer(nearest_heap_t *h, int i, double v){
+    int p;
+    if(h->n < h->k){
+        p = h->n++;
+        while(p > 0 && h->cost[(p - 1) / 2] < v){
+            h->idx[p] = h->idx[(p - 1) / 2];
+            h->cost[p] = h->cost[(p - 1) / 2];
+            p = (p - 1) / 2;
+        }
+    } else {
+        if(v >= h->cost[0]) return;
+        p = 0;
+        for(;;){
+            int c = 2 * p + 1;
+            if(c >= h->n) break;
+            if(c + 1 < h->n && h->cost[c + 1] > h->cost[c]) c++;
+            if(h->cost[c] <= v) break;
+            h->idx[p] = h->idx[c];
+            h->cost[p] = h->cost[c];
+            p = c;
+        }
+    }
+    h->idx[p] = i;
+    h->cost[p] = v;
+}
+
+static void nearest_scan_cell(const target_set_t *ts, int cx, int cy,
+                              double (*cost)(int, void *), void *ctx, nearest_heap_t *h){
+    if(cx < 0 || cy < 0 || cx >= ts->gw || cy >= ts->gh) return;
+    int c = cy * ts->gw + cx;
+    for(int k = ts->cell_start[c]; k < ts->cell_start[c + 1]; k++){
+        int i = ts->cell_items[k];
+        double v = cost(i, ctx);
+        if(!isinf(v)) heap_offer(h, i, v);
+    }
+}
+
+int targets_nearest(const target_set_t *ts, double x, double y,
+                    double (*cost)(int idx, void *ctx), double dist_scale, double extra_min, void *ctx,
+                    int k, int *out, double *out_cost){
+    if(k <= 0) return 0;
+    nearest_heap_t h = { out, out_cost, 0, k };
+    if(ts->gw == 0){
+        for(int i = 0; i < ts->count; i++){
+            double v = cost(i, ctx);
+            if(!isinf(v)) heap_offer(&h, i, v);
+        }
+    } else {
+        // corte por anillos como targets_best, contra el k-ésimo mejor; de cada anillo se
+        // recorre solo la parte dentro de la grilla. Con el punto fuera de la grilla se suma
+        // su distancia d0 a ella: respecto de su proyección, el anillo r está a >= (r-1)*cell
+        // y los dos tramos forman ángulo recto o mayor
+        int cx = cell_of(ts, x, ts->minx, ts->gw), cy = cell_of(ts, y, ts->miny, ts->gh);
+        double maxx = ts->minx + ts->gw * ts->cell, maxy = ts->miny + ts->gh * ts->cell;
+        double dx0 = x < ts->minx ? ts->minx - x : (x > maxx ? x - maxx : 0);
+        double dy0 = y < ts->miny ? ts->miny - y : (y > maxy ? y - maxy : 0);
+        double d0sq = dx0 * dx0 + dy0 * dy0;
+        int rmax = cx;
+        if(ts->gw - 1 - cx > rmax) rmax = ts->gw - 1 - cx;
+        if(cy > rmax) rmax = cy;
+        if(ts->gh - 1 - cy > rmax) rmax = ts->gh - 1 - cy;
+        for(int r = 0; r <= rmax; r++){
+            if(h.n == k && r > 0){
+                double ring = (r - 1) * ts->cell;
+                if(sqrt(d0sq + ring * ring) * dist_scale + extra_min > h.cost[0]) break;
+            }
+            int x0 = cx - r < 0 ? 0 : cx - r, x1 = cx + r >= ts->gw ? ts->gw - 1 : cx + r;
+            int y0 = cy - r + 1 < 0 ? 0 : cy - r + 1, y1 = cy + r - 1 >= ts->gh ? ts->gh - 1 : cy + r - 1;
+            for(int d = x0; d <= x1; d++){
+                if(cy - r >= 0) nearest_scan_cell(ts, d, cy - r, cost, ctx, &h);
+                if(r > 0 && cy + r < ts->gh) nearest_scan_cell(ts, d, cy + r, cost, ctx, &h);
+            }
+            if(r == 0) continue;
+            if(cx - r >= 0)
+                for(int d = y0; d <= y1; d++) nearest_scan_cell(ts, cx - r, d, cost, ctx, &h);
+            if(cx + r < ts->gw)
+                for(int d = y0; d <= y1; d++) nearest_scan_cell(ts, cx + r, d, cost, ctx, &h);
+        }
+    }
+    // heapsort en el lugar: de menor a mayor costo
+    int n = h.n;
+    while(h.n > 1){
+        int i = h.idx[0];
+        double v = h.cost[0];
+        h.n--;
+        int li = h.idx[h.n];
+        double lv = h.cost[h.n];
+        int p = 0;
+        for(;;){
+            int c = 2 * p + 1;
+            if(c >= h.n) break;
+            if(c + 1 < h.n && h.cost[c + 1] > h.cost[c]) c++;
+            if(h.cost[c] <= lv) break;
+            h.idx[p] = h.idx[c];
+            h.cost[p] = h.cost[c];
+            p = c;
+        }
+        h.idx[p] = li;
+        h.cost[p] = lv;
+        h.idx[h.n] = i;
+        h.cost[h.n] = v;
+    }
+    return n;
+}
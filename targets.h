@@ -0,0 +1,68 @@
+// targets.h - catálogo de blancos (archivo CSV/binario) con índice espacial
+#ifndef TARGETS_H
+#define TARGETS_H
+
+#include <stdint.h>
+
+// Formato binario: cabecera de 16 bytes + count registros de 16 bytes
+#define TARGETS_MAGIC "DTGT01"
+
+typedef struct {
+    char magic[8];      // "DTGT01"
+    uint32_t count;
+    uint32_t reserved;
+} targets_file_hdr_t;
+
+typedef struct {
+    float x, y;
+    int32_t priority;
+    int32_t required;   // 0 = usar el valor por defecto
+} targets_file_rec_t;
+
+typedef struct {
+    double x, y;
+    int priority;
+    int required;       // drones necesarios para destruirlo
+    int destroyed;
+    int first_swarm;    // lista de swarms vivos asignados (índices del center, -1 = vacía)
+    int n_swarms;
+} target_t;
+
+typedef struct {
+    target_t *items;
+    int count, cap;
+    int max_priority;
+    // índice de grilla (CSR): cell_start[c]..cell_start[c+1] en cell_items
+    double minx, miny, cell;
+    int gw, gh;
+    int *cell_start;
+    int *cell_items;
+} target_set_t;
+
+void targets_init(target_set_t *ts);
+void targets_free(target_set_t *ts);
+int  targets_add(target_set_t *ts, double x, double y, int priority, int required);
+
+// Carga un archivo (binario si empieza con TARGETS_MAGIC, si no CSV "x,y[,prioridad[,requeridos]]"
+// con '#' como comentario). El archivo se lee mapeado en memoria. Devuelve la cantidad o -1.
+int  targets_load(target_set_t *ts, const char *path, int default_required);
+int  targets_save_binary(const target_set_t *ts, const char *path);
+
+// Reconstruye el índice; llamar tras agregar blancos (las posiciones no cambian después)
+void targets_build_index(target_set_t *ts);
+
+// Blanco no destruido de menor costo. El costo lo da cost(idx, ctx) y debe cumplir
+// cost >= distancia * dist_scale + extra_min, lo que permite cortar la búsqueda por
+// anillos de la grilla. Devuelve -1 si no quedan blancos.
+int  targets_best(const target_set_t *ts, double x, double y,
+                  double (*cost)(int idx, void *ctx), double dist_scale, double extra_min, void *ctx);
+
+// Los k blancos de menor costo en out (de menor a mayor, con su costo en out_cost) con el
+// mismo corte por anillos que targets_best. A diferencia de targets_best no mira destroyed:
+// un costo INFINITY excluye el blanco, así se puede consultar contra una copia del estado.
+// Devuelve cuántos dejó (menos de k solo si no hay más).
+int  targets_nearest(const target_set_t *ts, double x, double y,
+                     double (*cost)(int idx, void *ctx), double dist_scale, double extra_min, void *ctx,
+                     int k, int *out, double *out_cost);
+
+#endif
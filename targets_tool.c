@@ -0,0 +1,65 @@
+// targets_tool.c - genera o convierte catálogos de blancos para TARGETS_FILE
+//   targets_tool -g N [-s seed] [-w ancho] [-h alto] [-x x0] salida   (aleatorio)
+//   targets_tool entrada salida                                         (CSV/binario -> binario o CSV)
+// La salida es binaria salvo que termine en ".csv".
+#include "targets.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int ends_with(const char *s, const char *suf){
+    size_t n = strlen(s), m = strlen(suf);
+    return n >= m && strcmp(s + n - m, suf) == 0;
+}
+
+static int save_csv(const target_set_t *ts, const char *path){
+    FILE *f = fopen(path, "w");
+    if(!f){ perror("fopen"); return -1; }
+    fprintf(f, "# x,y,prioridad,requeridos\n");
+    for(int i = 0; i < ts->count; i++)
+        fprintf(f, "%.2f,%.2f,%d,%d\n", ts->items[i].x, ts->items[i].y,
+                ts->items[i].priority, ts->items[i].required);
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+int main(int argc, char **argv){
+    int gen = 0, seed = 12345, opt;
+    double w = 1000.0, h = 1000.0, x0 = 100.0;
+    while((opt = getopt(argc, argv, "g:s:w:h:x:")) != -1){
+        switch(opt){
+        case 'g': gen = atoi(optarg); break;
+        case 's': seed = atoi(optarg); break;
+        case 'w': w = atof(optarg); break;
+        case 'h': h = atof(optarg); break;
+        case 'x': x0 = atof(optarg); break;
+        default:
+            fprintf(stderr, "Uso: %s -g N [-s seed] [-w ancho] [-h alto] [-x x0] salida\n"
+                            "     %s entrada salida\n", argv[0], argv[0]);
+            return 1;
+        }
+    }
+    int rest = argc - optind;
+    if((gen > 0 && rest != 1) || (gen <= 0 && rest != 2)){
+        fprintf(stderr, "Uso: %s -g N [...] salida | %s entrada salida\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    target_set_t ts;
+    targets_init(&ts);
+    if(gen > 0){
+        // blancos en [x0, x0+w] x [-h/2, h/2], prioridad 1..3
+        srand(seed);
+        for(int i = 0; i < gen; i++)
+            targets_add(&ts, x0 + w * rand() / RAND_MAX, h * rand() / RAND_MAX - h / 2,
+                        1 + rand() % 3, 0);
+    } else if(targets_load(&ts, argv[optind], 0) < 0){
+        return 1;
+    }
+
+    const char *out = argv[argc - 1];
+    int rc = ends_with(out, ".csv") ? save_csv(&ts, out) : targets_save_binary(&ts, out);
+    if(rc == 0) printf("%d blancos escritos en %s\n", ts.count, out);
+    targets_free(&ts);
+    return rc == 0 ? 0 : 1;
+}
@@ -3,7 +3,9 @@
 #include <sys/wait.h>  // ✅ AGREGADO: Para waitpid()
 #include <signal.h>    // ✅ AGREGADO: Para signal handling
 
-// truck <params_path> <truck_id>
+// truck <params_path> <truck_id> [--restore <target_id> <x> <y> <drone_id>...]
+// Con --restore (misión retomada de una instantánea) relanza solo los drones indicados,
+// que retoman su propio estado, con el blanco que el centro tenía para el swarm.
 int BASE_PORT = 40000;
 int ASSEMBLY_SIZE = 5;
 char *params_path;
@@ -12,12 +14,48 @@ char *params_path;
 double target_x = 100.0;
 double target_y = 0.0;
 int target_id = 0;
-int target_sent = 0;      // Flag para evitar enviar múltiples veces
+int target_sent = 0;      // Flag: ya se reenvió un blanco (solo se reenvía si cambia)
 int takeoff_sent = 0;     // Flag para evitar enviar múltiples veces
 
 // ✅ NUEVO: Contador de drones vivos para debugging
 int drones_alive = 0;
 
+// Drones que pertenecen hoy al swarm de este truck (propios + adoptados - cedidos)
+int *roster = NULL;
+int roster_len = 0, roster_cap = 0;
+
+static void roster_add(int gid){
+    for(int i = 0; i < roster_len; i++) if(roster[i] == gid) return;
+    if(roster_len == roster_cap){
+        int cap = roster_cap ? roster_cap * 2 : 8;
+        int *r = realloc(roster, cap * sizeof(int));
+        if(!r) return;
+        roster = r;
+        roster_cap = cap;
+    }
+    roster[roster_len++] = gid;
+}
+
+static void roster_remove(int gid){
+    for(int i = 0; i < roster_len; i++){
+        if(roster[i] == gid){
+            roster[i] = roster[--roster_len];
+            return;
+        }
+    }
+}
+
+// Aplica f a cada id de una lista "id id id ..."
+static void for_each_id(const char *list, void (*f)(int)){
+    char *end;
+    for(;;){
+        long v = strtol(list, &end, 10);
+        if(end == list) break;
+        f((int)v);
+        list = end;
+    }
+}
+
 // ✅ NUEVO: Handler para recoger procesos zombie
 void sigchld_handler(int sig) {
     (void)sig;
@@ -31,9 +69,10 @@ void sigchld_handler(int sig) {
 }
 
 int main(int argc, char **argv){
-    if(argc<3){ fprintf(stderr,"Usage: truck params.txt <truck_id>\n"); exit(1); }
+    if(argc<3){ fprintf(stderr,"Usage: truck params.txt <truck_id> [--restore <target_id> <x> <y> <drone_id>...]\n"); exit(1); }
     params_path = argv[1];
     int truck_id = atoi(argv[2]);
+    int restore = argc > 6 && strcmp(argv[3], "--restore") == 0;
 
     // ✅ NUEVO: Configurar handler para SIGCHLD ANTES de hacer fork()
     signal(SIGCHLD, sigchld_handler);
@@ -58,13 +97,16 @@ int main(int argc, char **argv){
     }
 
     int truck_port = port_for_truck(BASE_PORT, truck_id);
-    int center_port = port_for_center(BASE_PORT);
     int sock = make_udp_socket();
+    budget_load(params_path);
+    net_load(params_path);
+    int center_port = port_for_center_shard(BASE_PORT, center_shard_of_swarm(truck_id));
+    budget_rcvbuf(sock, ASSEMBLY_SIZE + 2);   // sus drones, el centro y la artillería
 
     // bind antes de lanzar drones
     struct sockaddr_in addr; memset(&addr,0,sizeof(addr));
     addr.sin_family = AF_INET;
-    addr.sin_addr.s_addr = inet_addr(HOST);
+    addr.sin_addr.s_addr = net_addr_for_port(truck_port);
     addr.sin_port = htons(truck_port);
     printf("[TRUCK %d] intentando bind en puerto %d\n", truck_id, truck_port);
     if(bind(sock,(struct sockaddr*)&addr,sizeof(addr))<0){
@@ -72,33 +114,58 @@ int main(int argc, char **argv){
         exit(1);
     }
     printf("[TRUCK %d] iniciado puerto %d\n", truck_id, truck_port);
+    reliable_start();   // reintentos de TARGET/TAKEOFF hacia los drones
+    printf("[TRUCK %d] comandos de swarm por %s\n", truck_id,
+           group_available(params_path) ? "multicast" : "unicast");
 
     // announce truck ready
     msg_t m; memset(&m,0,sizeof(m));
     m.type = MSG_ARTILLERY;
     m.truck_id = truck_id;
     snprintf(m.text,sizeof(m.text),"TRUCK_READY %d", truck_id);
-    send_msg(sock, center_port, &m);
+    send_msg_reliable(sock, center_port, &m);
 
-    // spawn ASSEMBLY_SIZE drones
-    printf("[TRUCK %d] Spawning %d drones...\n", truck_id, ASSEMBLY_SIZE);
-    for(int i=0;i<ASSEMBLY_SIZE;i++){
+    // spawn ASSEMBLY_SIZE drones (o, al retomar, los que el centro tenía en el swarm)
+    int n_spawn = ASSEMBLY_SIZE;
+    if(restore){
+        target_id = atoi(argv[4]);
+        target_x = atof(argv[5]);
+        target_y = atof(argv[6]);
+        target_sent = target_id >= 0;
+        n_spawn = argc - 7;
+    }
+    printf("[TRUCK %d] Spawning %d drones...\n", truck_id, n_spawn);
+    for(int i=0;i<n_spawn;i++){
+        int global_id = restore ? atoi(argv[7 + i]) : truck_id * 100 + i + 1; // global unique (simple)
+        // modo distribuido: cada drone corre en el nodo de su swarm original (ahí están su
+        // dirección y su instantánea); uno adoptado de otro nodo lo relanza el agente de ese nodo
+        int home = net_worker_of_swarm((global_id - 1) / 100);
+        if(home >= 0 && home != net_worker_of_swarm(truck_id)){
+            msg_t sp; memset(&sp,0,sizeof(sp));
+            sp.type = MSG_COMMAND;
+            sp.truck_id = truck_id;
+            snprintf(sp.text,sizeof(sp.text),"SPAWN_DRONE %d %d", global_id, truck_id);
+            send_msg_reliable(sock, port_for_agent(BASE_PORT, home), &sp);
+            roster_add(global_id);
+            printf("[TRUCK %d] Drone %d relanzado por el agente del worker %d\n", truck_id, global_id, home);
+            continue;
+        }
         pid_t pid = fork();
         if(pid==0){
             // PROCESO HIJO (DRONE)
             char gid_s[16], ppath[256], tid[16];
-            int global_id = truck_id * 100 + i + 1; // global unique (simple)
             snprintf(gid_s,sizeof(gid_s),"%d", global_id);
             snprintf(ppath,sizeof(ppath),"%s",params_path);
             snprintf(tid,sizeof(tid),"%d",truck_id);
-            execl("./drone","drone", ppath, gid_s, tid, (char*)NULL);
+            execl("./drone","drone", ppath, gid_s, tid, restore ? "--restore" : (char*)NULL, (char*)NULL);
             perror("execl drone");
             exit(1);
         } else if(pid > 0) {
             // PROCESO PADRE (TRUCK)
             drones_alive++;
+            roster_add(global_id);
             printf("[TRUCK %d] ✅ Drone %d spawned con PID %d (total vivos: %d)\n", 
-                   truck_id, truck_id*100 + i + 1, pid, drones_alive);
+                   truck_id, global_id, pid, drones_alive);
         } else {
             perror("fork drone");
         }
@@ -112,12 +179,12 @@ int main(int argc, char **argv){
     timeout.tv_usec = 0;
     setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
 
-    // truck listens for commands from center (e.g., REASSIGN_ONE_TO, TARGET)
-    msg_t rcv; struct sockaddr_in from;
+    // truck listens for commands from center (e.g., RELEASE/ADOPT, TARGET)
+    msg_view_t rcv; struct sockaddr_in from;
     int loop_count = 0;
     
     while(1){
-        int recv_result = recv_msg(sock, &rcv, &from);
+        int recv_result = recv_view(sock, &rcv, &from);
         
         // ✅ NUEVO: Mostrar estado cada cierto tiempo
         if(++loop_count % 1000 == 0) {
@@ -141,55 +208,47 @@ int main(int argc, char **argv){
             
             if(strncmp(rcv.text,"TARGET",6)==0){
                 // Recibir coordenadas del blanco: "TARGET x y id"
-                if(sscanf(rcv.text,"TARGET %lf %lf %d", &target_x, &target_y, &target_id) == 3 && !target_sent){
+                double nx, ny; int nid;
+                int changed = sscanf(rcv.text,"TARGET %lf %lf %d", &nx, &ny, &nid) == 3 &&
+                              (!target_sent || nid != target_id || nx != target_x || ny != target_y);
+                if(changed){
+                    target_x = nx; target_y = ny; target_id = nid;
                     printf("[TRUCK %d] Blanco asignado: ID=%d, Pos=(%.1f, %.1f)\n", 
                            truck_id, target_id, target_x, target_y);
                     
-                    // Enviar coordenadas del blanco a todos los drones (solo una vez)
-                    for(int i=0;i<ASSEMBLY_SIZE;i++){
-                        int gid = truck_id*100 + i + 1;
-                        int dport = port_for_drone(BASE_PORT, gid);
-                        msg_t cmd; memset(&cmd,0,sizeof(cmd));
-                        cmd.type = MSG_COMMAND;
-                        cmd.swarm_id = truck_id;
-                        cmd.drone_id = gid;
-                        snprintf(cmd.text,sizeof(cmd.text),"TARGET %.1f %.1f %d", target_x, target_y, target_id);
-                        send_msg(sock, dport, &cmd);
-                        printf("[TRUCK %d] Enviado TARGET a drone %d\n", truck_id, gid);
-                    }
+                    // Enviar coordenadas del blanco a todo el swarm (solo si cambió)
+                    msg_t cmd; memset(&cmd,0,sizeof(cmd));
+                    cmd.type = MSG_COMMAND;
+                    cmd.swarm_id = truck_id;
+                    snprintf(cmd.text,sizeof(cmd.text),"TARGET %.1f %.1f %d", target_x, target_y, target_id);
+                    send_msg_group(sock, BASE_PORT, truck_id, roster, roster_len, &cmd);
+                    printf("[TRUCK %d] Enviado TARGET a %d drones\n", truck_id, roster_len);
                     target_sent = 1; // Marcar como enviado
                 }
             }
-            else if(strncmp(rcv.text,"REASSIGN_ONE_TO",15)==0){
-                printf("[TRUCK %d] Procesando REASSIGN_ONE_TO...\n", truck_id);
-                
-                // ✅ MEJORA: Solo enviar a drones existentes, no broadcast masivo
-                for(int i=0;i<ASSEMBLY_SIZE;i++){
-                    int gid = truck_id*100 + i + 1;
-                    int dport = port_for_drone(BASE_PORT, gid);
-                    msg_t cmd; memset(&cmd,0,sizeof(cmd));
-                    cmd.type = MSG_COMMAND;
-                    cmd.swarm_id = -1;
-                    cmd.drone_id = gid;
-                    snprintf(cmd.text,sizeof(cmd.text),"GO_TO_SWARM %s", rcv.text + 16);
-                    send_msg(sock, dport, &cmd);
+            // El centro ya avisó a cada dron (REASSIGN); el truck solo ajusta su lista
+            else if(strncmp(rcv.text,"RELEASE",7)==0){
+                for_each_id(rcv.text + 7, roster_remove);
+                printf("[TRUCK %d] Drones cedidos, %d en la lista del swarm\n", truck_id, roster_len);
+            }
+            else if(strncmp(rcv.text,"ADOPT",5)==0){
+                int n = 0;
+                if(sscanf(rcv.text,"ADOPT %lf %lf %d %n", &target_x, &target_y, &target_id, &n) == 3){
+                    target_sent = 1;
+                    for_each_id(rcv.text + n, roster_add);
+                    printf("[TRUCK %d] Drones adoptados, %d en la lista del swarm (blanco %d)\n", truck_id, roster_len, target_id);
                 }
-            } 
+            }
             else if(strncmp(rcv.text,"TAKEOFF",7)==0){
                 // broadcast TAKEOFF to all drones of this truck (solo una vez)
                 if(!takeoff_sent){
                     printf("[TRUCK %d] Procesando TAKEOFF...\n", truck_id);
-                    for(int i=0;i<ASSEMBLY_SIZE;i++){
-                        int gid = truck_id*100 + i + 1;
-                        int dport = port_for_drone(BASE_PORT, gid);
-                        msg_t cmd; memset(&cmd,0,sizeof(cmd));
-                        cmd.type = MSG_COMMAND;
-                        cmd.swarm_id = truck_id;
-                        cmd.drone_id = gid;
-                        snprintf(cmd.text,sizeof(cmd.text),"TAKEOFF");
-                        printf("[TRUCK %d] Enviando TAKEOFF a drone %d (puerto %d)\n", truck_id, gid, dport);
-                        send_msg(sock, dport, &cmd);
-                    }
+                    msg_t cmd; memset(&cmd,0,sizeof(cmd));
+                    cmd.type = MSG_COMMAND;
+                    cmd.swarm_id = truck_id;
+                    snprintf(cmd.text,sizeof(cmd.text),"TAKEOFF");
+                    printf("[TRUCK %d] Enviando TAKEOFF a %d drones\n", truck_id, roster_len);
+                    send_msg_group(sock, BASE_PORT, truck_id, roster, roster_len, &cmd);
                     takeoff_sent = 1; // Marcar como enviado
                 }
             }
@@ -204,5 +263,6 @@ int main(int argc, char **argv){
     
     printf("[TRUCK %d] terminado\n", truck_id);
     close(sock);
+    free(roster);
     return 0;
 }
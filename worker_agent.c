@@ -0,0 +1,170 @@
+// worker_agent.c - agente de un nodo de trabajo en modo distribuido (WORKERS)
+//   worker_agent params.txt [k]
+// Escucha en port_for_agent(BASE_PORT, k) sobre la dirección del worker k:
+//  - "SPAWN tid [args...]" del centro: lanza ./truck params.txt tid args... en este nodo
+//  - "SPAWN_DRONE gid tid" de un truck de otro nodo al retomar: relanza aquí (el nodo de
+//    su swarm original) un drone que ese truck había adoptado
+//  - "SHUTDOWN" del centro al terminar la misión: termina
+//  - POS de los drones del nodo: los agrupa y los envía a la artillería como un solo
+//    MSG_POS_BATCH cada POS_BATCH_MS (o antes, si el lote llena un datagrama)
+// Sin k lanza un agente por cada dirección de WORKERS (para probar en una sola máquina
+// con varias direcciones de loopback) y espera a que terminen.
+#include "common.h"
+#include <poll.h>
+#include <fcntl.h>
+
+int BASE_PORT = 40000;
+int POS_BATCH_MS = 100;
+char *params_path;
+
+static double now_mono(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Lote en armado: "gid swarm x y;" por POS; el encabezado se agrega al enviarlo
+#define BATCH_HEADER 32
+#define BATCH_ENTRY  48   // lugar que se deja para la próxima entrada
+typedef struct {
+    char body[MAX_DGRAM - BATCH_HEADER];
+    int len, count;
+    unsigned long positions, batches;
+} pos_batch_t;
+
+static void batch_flush(int sock, int worker, pos_batch_t *b){
+    if(b->count == 0) return;
+    char out[MAX_DGRAM];
+    int n = snprintf(out, sizeof(out), "%d|%d|%d|0|%.*s", (int)MSG_POS_BATCH, worker, b->count, b->len, b->body);
+    if(n >= (int)sizeof(out)) n = sizeof(out) - 1;
+    send_datagram(sock, port_for_artillery(BASE_PORT), out, n);
+    b->positions += b->count;
+    b->batches++;
+    b->len = 0;
+    b->count = 0;
+}
+
+static void batch_add(int sock, int worker, pos_batch_t *b, const msg_view_t *m){
+    double x, y;
+    if(sscanf(m->text + 4, "%lf %lf", &x, &y) != 2) return;
+    if(b->len + BATCH_ENTRY > (int)sizeof(b->body)) batch_flush(sock, worker, b);
+    b->len += snprintf(b->body + b->len, sizeof(b->body) - b->len, "%d %d %.1f %.1f;",
+                       m->drone_id, m->swarm_id, x, y);
+    b->count++;
+}
+
+// "SPAWN tid [args...]": ./truck params tid args...
+static void spawn_truck(int worker, const char *text){
+    char buf[MAX_MSG];
+    snprintf(buf, sizeof(buf), "%s", text);
+    char *argv[64], *save;
+    int na = 0;
+    argv[na++] = "truck";
+    argv[na++] = params_path;
+    for(char *t = strtok_r(buf, " ", &save); t && na < 63; t = strtok_r(NULL, " ", &save))
+        argv[na++] = t;
+    argv[na] = NULL;
+    if(na < 3) return;
+    pid_t pid = fork();
+    if(pid == 0){
+        execv("./truck", argv);
+        perror("execv truck");
+        exit(1);
+    }
+    if(pid < 0) perror("fork truck");
+    else printf("[AGENT %d] Truck %s lanzado con PID %d\n", worker, argv[2], pid);
+}
+
+// "SPAWN_DRONE gid tid": ./drone params gid tid --restore
+static void spawn_drone(int worker, const char *text){
+    char gid[16], tid[16];
+    if(sscanf(text, "%15s %15s", gid, tid) != 2) return;
+    pid_t pid = fork();
+    if(pid == 0){
+        execl("./drone", "drone", params_path, gid, tid, "--restore", (char *)NULL);
+        perror("execl drone");
+        exit(1);
+    }
+    if(pid < 0) perror("fork drone");
+    else printf("[AGENT %d] Drone %s (truck %s) relanzado con PID %d\n", worker, gid, tid, pid);
+}
+
+static int run_agent(int worker){
+    int port = port_for_agent(BASE_PORT, worker);
+    int sock = make_udp_socket();
+    int rcvbuf = sock_tune(sock, params_path);
+    struct sockaddr_in addr; memset(&addr,0,sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = net_addr_for_port(port);
+    addr.sin_port = htons(port);
+    if(bind(sock,(struct sockaddr*)&addr,sizeof(addr))<0){
+        perror("bind worker_agent");
+        return 1;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+    printf("[AGENT %d] Iniciado en %s:%d (SO_RCVBUF %d kB, lotes de POS cada %d ms)\n",
+           worker, net_worker_addr(worker), port, rcvbuf / 1024, POS_BATCH_MS);
+    fflush(stdout);
+
+    static pos_batch_t batch;
+    double next_flush = now_mono() + POS_BATCH_MS / 1000.0;
+    msg_view_t m; struct sockaddr_in from;
+    for(;;){
+        int timeout_ms = (int)((next_flush - now_mono()) * 1000) + 1;
+        struct pollfd pfd = { sock, POLLIN, 0 };
+        if(poll(&pfd, 1, timeout_ms > 0 ? timeout_ms : 0) > 0){
+            while(recv_view(sock, &m, &from) > 0){
+                if(m.type == MSG_STATUS && strncmp(m.text, "POS ", 4) == 0)
+                    batch_add(sock, worker, &batch, &m);
+                else if(m.type == MSG_COMMAND && strncmp(m.text, "SPAWN ", 6) == 0)
+                    spawn_truck(worker, m.text + 6);
+                else if(m.type == MSG_COMMAND && strncmp(m.text, "SPAWN_DRONE ", 12) == 0)
+                    spawn_drone(worker, m.text + 12);
+                else if(m.type == MSG_COMMAND && strcmp(m.text, "SHUTDOWN") == 0){
+                    batch_flush(sock, worker, &batch);
+                    printf("[AGENT %d] SHUTDOWN: %lu POS reenviados en %lu lotes\n",
+                           worker, batch.positions, batch.batches);
+                    close(sock);
+                    return 0;
+                }
+            }
+        }
+        if(now_mono() >= next_flush){
+            batch_flush(sock, worker, &batch);
+            next_flush += POS_BATCH_MS / 1000.0;
+            if(next_flush < now_mono()) next_flush = now_mono() + POS_BATCH_MS / 1000.0;
+        }
+        while(waitpid(-1, NULL, WNOHANG) > 0)
+            ;
+    }
+}
+
+int main(int argc, char **argv){
+    if(argc<2){ fprintf(stderr,"Usage: worker_agent params.txt [worker]\n"); exit(1); }
+    params_path = argv[1];
+    char v[32];
+    if(params_get_string(params_path, "BASE_PORT", v, sizeof(v))) BASE_PORT = atoi(v);
+    if(params_get_string(params_path, "POS_BATCH_MS", v, sizeof(v)) && atoi(v) > 0) POS_BATCH_MS = atoi(v);
+    budget_load(params_path);
+    int n = net_load(params_path);
+    if(n == 0){
+        fprintf(stderr, "worker_agent: WORKERS no está configurado en %s\n", params_path);
+        exit(1);
+    }
+    if(argc > 2){
+        int k = atoi(argv[2]);
+        if(k < 0 || k >= n){ fprintf(stderr, "worker_agent: worker %d fuera de 0..%d\n", k, n - 1); exit(1); }
+        return run_agent(k);
+    }
+
+    // un agente por worker (todos en esta máquina)
+    for(int k = 0; k < n; k++){
+        pid_t pid = fork();
+        if(pid == 0) exit(run_agent(k));
+        if(pid < 0) perror("fork worker_agent");
+    }
+    int status, rc = 0;
+    while(wait(&status) > 0)
+        if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) rc = 1;
+    return rc;
+}